@@ -0,0 +1,122 @@
+#ifndef BUTTON_H_
+#define BUTTON_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Debounced keys with long press and accelerating auto-repeat.
+*           - The first edge on a key masks its EXTI line, so bounce cannot
+*             interrupt again, and starts TIM7 in one-pulse mode.
+*           - Each TIM7 shot (BTN_SCAN_MS) samples every busy key and feeds
+*             btn_scan(); TIM7 is re-armed only while a key is busy.
+*           - A level has to read the same BTN_DEBOUNCE_SCANS times to count.
+*             Once the release is confirmed the line is cleared and unmasked.
+*           A press therefore costs one EXTI plus one TIM7 shot per
+*           BTN_SCAN_MS held, whatever the contacts do.
+*           Keys are active high (external pull-down, EXTI rising).
+******************************************************/
+
+#include <stdint.h>
+
+#ifndef BTN_SCAN_MS
+#define BTN_SCAN_MS         10u     /* TIM7 shot length */
+#endif
+#ifndef BTN_DEBOUNCE_SCANS
+#define BTN_DEBOUNCE_SCANS  3u      /* equal samples to accept a level */
+#endif
+#ifndef BTN_LONG_MS
+#define BTN_LONG_MS         800u    /* held this long: BTN_EV_LONG */
+#endif
+#ifndef BTN_REPEAT_MS
+#define BTN_REPEAT_MS       300u    /* first repeat period after LONG */
+#endif
+#ifndef BTN_REPEAT_MIN_MS
+#define BTN_REPEAT_MIN_MS   50u     /* each repeat is 1/4 sooner, down to this */
+#endif
+
+typedef enum {
+    BTN_MODE = 0,       /* PB1 */
+    BTN_ACTION,         /* PB12 */
+    BTN_COUNT
+} ButtonId;
+
+typedef enum {
+    BTN_EV_NONE = 0,
+    BTN_EV_PRESS,
+    BTN_EV_RELEASE,
+    BTN_EV_LONG,
+    BTN_EV_REPEAT
+} ButtonEvent;
+
+enum { BTN_IDLE = 0, BTN_BOUNCE, BTN_HELD };
+
+typedef struct {
+    uint8_t  phase;     /* BTN_IDLE / BTN_BOUNCE / BTN_HELD */
+    uint8_t  hi, lo;    /* consecutive high / low samples */
+    uint8_t  longed;
+    uint16_t period;    /* current repeat period, ms */
+    uint32_t held;      /* ms since the press was accepted */
+    uint32_t next;      /* `held` of the next LONG / REPEAT */
+} btn_t;
+
+/* First edge seen: start confirming */
+static inline void btn_edge(btn_t *b)
+{
+    b->phase = BTN_BOUNCE;
+    b->hi = b->lo = 0;
+}
+
+/* One sample, BTN_SCAN_MS after the previous one. Returns the event it
+   completes; the key is done when phase is back to BTN_IDLE. */
+static inline ButtonEvent btn_scan(btn_t *b, uint8_t level)
+{
+    if (level) { b->lo = 0; if (b->hi < BTN_DEBOUNCE_SCANS) b->hi++; }
+    else       { b->hi = 0; if (b->lo < BTN_DEBOUNCE_SCANS) b->lo++; }
+
+    switch (b->phase) {
+        case BTN_BOUNCE:
+            if (b->hi >= BTN_DEBOUNCE_SCANS) {
+                b->phase  = BTN_HELD;
+                b->longed = 0;
+                b->held   = 0;
+                b->next   = BTN_LONG_MS;
+                return BTN_EV_PRESS;
+            }
+            if (b->lo >= BTN_DEBOUNCE_SCANS) b->phase = BTN_IDLE;     /* glitch */
+            return BTN_EV_NONE;
+
+        case BTN_HELD:
+            if (b->lo >= BTN_DEBOUNCE_SCANS) {
+                b->phase = BTN_IDLE;
+                return BTN_EV_RELEASE;
+            }
+            b->held += BTN_SCAN_MS;
+            if (b->held < b->next) return BTN_EV_NONE;
+            if (!b->longed) {
+                b->longed = 1;
+                b->period = BTN_REPEAT_MS;
+                b->next   = b->held + b->period;
+                return BTN_EV_LONG;
+            }
+            b->period = (uint16_t)(b->period - b->period / 4u);
+            if (b->period < BTN_REPEAT_MIN_MS) b->period = BTN_REPEAT_MIN_MS;
+            b->next = b->held + b->period;
+            return BTN_EV_REPEAT;
+
+        default:
+            return BTN_EV_NONE;
+    }
+}
+
+/* Receives every event, from the TIM7 interrupt */
+typedef void (*ButtonSink)(ButtonId key, ButtonEvent ev);
+
+/* After MX_GPIO_Init / MX_TIM7_Init */
+void Button_Init(ButtonSink sink);
+
+/* From HAL_GPIO_EXTI_Callback; ignores pins that are not keys */
+void Button_Edge(uint16_t pin);
+
+/* From HAL_TIM_PeriodElapsedCallback for TIM7 */
+void Button_Tick(void);
+
+#endif /* BUTTON_H_ */
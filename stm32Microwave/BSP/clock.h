@@ -0,0 +1,58 @@
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : System clock profiles, both from the 16 MHz HSI.
+*             FULL : PLL 168 MHz, AHB /1, APB1 /4 (42 MHz, timers 84 MHz),
+*                    APB2 /2 (84 MHz), 5 flash wait states
+*             LOW  : HSI 16 MHz straight, PLL off, all buses /1, 0 wait
+*                    states
+*           SystemClock_Config() (CubeMX) brings up FULL; tim.c and spi.c
+*           are generated for it. Every switch also rescales what depends
+*           on the bus clocks, so their timing does not change:
+*             TIM2 1 MHz (servo pulse in us), TIM3 100 kHz (1 kHz PWM),
+*             TIM4 2 kHz (countdown), TIM7 10 kHz (key scan), SPI1 at most
+*             CLOCK_LCD_SPI_MAX_HZ, USART2 baud rate, SysTick, HAL tick.
+*           Prefetch and the flash I/D caches (ART) stay on in both.
+*           TIM4 runs at 2 kHz because 1 kHz needs a prescaler above
+*           65536 at 84 MHz.
+******************************************************/
+
+#include <stdint.h>
+
+typedef enum {
+    CLOCK_PROFILE_FULL = 0,
+    CLOCK_PROFILE_LOW
+} ClockProfile;
+
+/* Profile applied by Clock_Init */
+#ifndef MW_CLOCK_PROFILE
+#define MW_CLOCK_PROFILE        CLOCK_PROFILE_FULL
+#endif
+
+/* Counter rates kept across profiles */
+#define CLOCK_TIM_SERVO_HZ      1000000u    /* TIM2 */
+#define CLOCK_TIM_PWM_HZ        100000u     /* TIM3 */
+#define CLOCK_TIM_COUNTDOWN_HZ  2000u       /* TIM4 */
+#define CLOCK_TIM_SCAN_HZ       10000u      /* TIM7 */
+
+/* ST7735 serial clock limit (66 ns write cycle) */
+#ifndef CLOCK_LCD_SPI_MAX_HZ
+#define CLOCK_LCD_SPI_MAX_HZ    15000000u
+#endif
+
+/* After the MX_*_Init calls, before the scheduler: apply MW_CLOCK_PROFILE */
+void Clock_Init(void);
+
+/* Switch at run time, from a task. Waits for SPI1 / USART2 transfers to end.
+   Returns 0 if the RCC did not accept the new setting. */
+uint8_t Clock_SetProfile(ClockProfile p);
+
+ClockProfile Clock_Profile(void);
+
+/* STOP wake-up leaves the core on HSI: bring the profile's clock back
+   (interrupts off, lowpower.c) */
+void Clock_Restore(void);
+
+#endif /* CLOCK_H_ */
@@ -7,6 +7,12 @@
 extern "C" {
 #endif
 
+/* The console keeps a character/color grid in RAM. Console_PutChar and
+   friends only update the grid and mark changed cells; Console_Flush()
+   redraws the changed runs. Once Console_StartRenderTask() has run, a
+   low-priority task does that at most every CONSOLE_FRAME_MS, so a burst of
+   printf output costs one redraw. Before that, every call flushes at once. */
+
 /* Initialize console after LCD_Init().
    width_px, height_px are taken from LCD driver; pass 0 to auto-read via LCD_Width/LCD_Height. */
 void Console_Init(uint16_t width_px, uint16_t height_px);
@@ -26,6 +32,15 @@ int  Console_PutChar(int ch);
 /* Convenience */
 void Console_Puts(const char *s);
 
+/* Deferred redraw: start the render task (call once, after Console_Init),
+   or draw pending changes now from the calling task */
+void Console_StartRenderTask(void);
+void Console_Flush(void);
+
+/* After LCD_SetRotation(): re-fit the grid to the new screen size and
+   redraw it from the backing store (most recent lines kept) */
+void Console_Refresh(void);
+
 /* If you want to change font later (e.g., to 6x12), call this first. */
 void Console_SetFontCell(uint8_t cell_w, uint8_t cell_h);
 
@@ -0,0 +1,75 @@
+#ifndef FSM_H_
+#define FSM_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Generic table-driven hierarchical state machine.
+*           - The machine is a const fsm_def_t: one descriptor per state
+*             (parent, initial child, entry/exit) and a transition table
+*             indexed [state][event], both in flash.
+*           - Dispatch indexes the table of the current state; a cell left
+*             empty (or whose guard fails) defers to the parent state, so
+*             the walk is bounded by the nesting depth, not by the number
+*             of states or events.
+*           - External transitions run exits up to the common ancestor,
+*             the transition action, then entries down to the target and
+*             its initial children. Internal ones only run the action.
+*           No RTOS or HAL dependency: it builds on a host as well.
+******************************************************/
+
+#include <stdint.h>
+
+#define FSM_NONE        0xFFu   /* no parent / no initial child */
+
+/* Deepest nesting the engine walks (root state = depth 1) */
+#ifndef FSM_MAX_DEPTH
+#define FSM_MAX_DEPTH   4u
+#endif
+
+typedef uint8_t (*fsm_guard_t)(void *ctx, uint16_t arg);
+typedef void    (*fsm_action_t)(void *ctx, uint16_t arg);
+
+enum { FSM_UNHANDLED = 0, FSM_INTERNAL, FSM_EXTERNAL };
+
+typedef struct {
+    uint8_t      kind;      /* FSM_UNHANDLED (zero-init) / INTERNAL / EXTERNAL */
+    uint8_t      target;    /* EXTERNAL only */
+    fsm_guard_t  guard;     /* NULL = always */
+    fsm_action_t action;    /* NULL = none */
+} fsm_trans_t;
+
+typedef struct {
+    uint8_t      parent;    /* FSM_NONE for top-level states */
+    uint8_t      initial;   /* child entered when this state is a target */
+    fsm_action_t entry;
+    fsm_action_t exit;
+} fsm_state_t;
+
+typedef struct {
+    const fsm_state_t *states;  /* [n_states] */
+    const fsm_trans_t *table;   /* [n_states][n_events], row-major */
+    uint8_t            n_states;
+    uint8_t            n_events;
+} fsm_def_t;
+
+typedef struct {
+    const fsm_def_t *def;
+    void            *ctx;       /* handed to guards and actions */
+    uint8_t          cur;       /* always a leaf state */
+} fsm_t;
+
+/* Table cell helpers, for designated initializers */
+#define FSM_TRAN(to, g, a)  { FSM_EXTERNAL, (uint8_t)(to), (g), (a) }
+#define FSM_INT(g, a)       { FSM_INTERNAL, 0, (g), (a) }
+
+/* Start in `initial` (drilled down to its leaf). Entry actions are not run:
+   the caller has already set the outputs up for that state. */
+void fsm_init(fsm_t *f, const fsm_def_t *def, uint8_t initial, void *ctx);
+
+/* Feed one event. Returns 1 if some state handled it, 0 if dropped. */
+uint8_t fsm_dispatch(fsm_t *f, uint8_t ev, uint16_t arg);
+
+/* 1 if `s` is the current state or one of its ancestors */
+uint8_t fsm_in(const fsm_t *f, uint8_t s);
+
+#endif /* FSM_H_ */
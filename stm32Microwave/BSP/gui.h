@@ -48,6 +48,11 @@ void Show_Str(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, uint8_t *str,uin
 /* Centered ASCII string: centered horizontally; provide Y line, colors, size, mode */
 void Gui_StrCenter(uint16_t y, uint16_t fc, uint16_t bc, uint8_t *str,uint8_t size,uint8_t mode);
 
+#if LCD_ENABLE_BENCH
+/* Time one 8x16 glyph drawn per-pixel vs. through the blitter (DWT cycles) */
+void GUI_BenchChar(uint16_t x, uint16_t y);
+#endif
+
 /* Small demos (you can call them from main.c) */
 void run_lcd_probe(void);
 void run_text_ascii(void);
@@ -0,0 +1,85 @@
+#ifndef HEATER_PID_H_
+#define HEATER_PID_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Optional closed-loop heater (MW_HEATER_PID = 1).
+*           - NTC thermistor (10k, B3950) from PC1 (ADC1_IN11) to GND with
+*             a 10k pull-up to 3V3.
+*           - ADC1 converts continuously; DMA2_Stream0 (channel 0) keeps the
+*             last MW_THERM_SAMPLES results in a circular buffer, no IRQ.
+*           - Task "heaterPid" wakes every MW_PID_PERIOD_MS, averages the
+*             buffer, converts to 0.1 degC and runs pid_step() into the
+*             MW_HEATER_CH compare (0..MW_HEATER_DUTY_MAX), or into the
+*             burst-fire level when MW_HEATER_SD is on.
+*           A shorted or open sensor forces the output to 0.
+*           The HAL ADC driver is not part of this tree, so ADC1 and the DMA
+*           stream are set up at register level.
+******************************************************/
+
+#include <stdint.h>
+#include "pid.h"
+#include "heater_sd.h"
+
+#ifndef MW_HEATER_PID
+#define MW_HEATER_PID       0
+#endif
+
+#ifndef MW_PID_PERIOD_MS
+#define MW_PID_PERIOD_MS    100u
+#endif
+
+/* Gains per sample: error in 0.1 degC, output in duty counts */
+#ifndef MW_PID_KP
+#define MW_PID_KP           PID_Q16(0.20)
+#endif
+#ifndef MW_PID_KI
+#define MW_PID_KI           PID_Q16(0.002)
+#endif
+#ifndef MW_PID_KD
+#define MW_PID_KD           PID_Q16(0.50)
+#endif
+
+/* Anti-windup: integrator share of the output, and the strategy. At the
+   setpoint the integral alone holds the duty, so a lower limit leaves an
+   offset wherever the load needs more. */
+#ifndef MW_PID_I_LIMIT
+#define MW_PID_I_LIMIT      MW_HEATER_DUTY_MAX
+#endif
+#ifndef MW_PID_ANTIWINDUP
+#define MW_PID_ANTIWINDUP   PID_AW_CONDITIONAL
+#endif
+
+/* Largest duty change per period (counts), 0 = unlimited */
+#ifndef MW_PID_SLEW
+#define MW_PID_SLEW         5
+#endif
+
+/* TIM3 ARR = 99; burst-fire levels go to 100 % */
+#ifndef MW_HEATER_DUTY_MAX
+#if MW_HEATER_SD
+#define MW_HEATER_DUTY_MAX  100
+#else
+#define MW_HEATER_DUTY_MAX  99
+#endif
+#endif
+
+#ifndef MW_THERM_SAMPLES
+#define MW_THERM_SAMPLES    16u
+#endif
+
+/* ADC1, DMA and the task. Call from MX_FREERTOS_Init. */
+void HeaterPid_Init(void);
+
+/* Regulate to setpoint (0.1 degC) / heater off. Task or ISR-free context. */
+void HeaterPid_Start(int16_t setpoint_dC);
+void HeaterPid_Stop(void);
+
+/* Offset added to the thermistor reading (0.1 degC), in RAM. The
+   controller stores it (MW_EV_SET_CAL) and HeaterPid_Init reloads it. */
+void HeaterPid_SetCalibration(int16_t offset_dC);
+
+/* Last measurement in 0.1 degC; INT16_MIN while the sensor is faulty */
+int16_t HeaterPid_Temperature(void);
+
+#endif /* HEATER_PID_H_ */
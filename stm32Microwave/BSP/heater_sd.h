@@ -0,0 +1,60 @@
+#ifndef HEATER_SD_H_
+#define HEATER_SD_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Optional (MW_HEATER_SD = 1) heater power 0..100 % in 1 % steps
+*           by sigma-delta (error diffusion) burst firing, for loads that
+*           must be switched in whole cycles (magnetron supply, triac-driven
+*           element). Off by default, which keeps the heater on plain 1 kHz
+*           PWM on MW_HEATER_CH.
+*           - Time is cut into on/off cycles of MW_SD_CYCLE_TICKS TIM3
+*             updates (1 kHz): 10 ms by default, one 50 Hz half-wave.
+*           - Each cycle the accumulator gains `level`; when it reaches
+*             SD_FULL the cycle is on and SD_FULL is taken back. On-cycles
+*             are therefore spread as evenly as possible, and any window of
+*             SD_FULL cycles holds exactly `level` of them.
+*           - MW_HEATER_CH is driven fully on (CCR = ARR + 1) or off; the
+*             CCR preload applies the change on the cycle edge.
+*           The TIM3 update IRQ is enabled only while the heater runs and
+*           does constant work per tick.
+******************************************************/
+
+#include <stdint.h>
+
+#ifndef MW_HEATER_SD
+#define MW_HEATER_SD        0
+#endif
+
+/* TIM3 updates (1 ms) per on/off cycle */
+#ifndef MW_SD_CYCLE_TICKS
+#define MW_SD_CYCLE_TICKS   10u
+#endif
+
+#define SD_FULL             100u    /* level for always on */
+
+typedef struct {
+    uint8_t level;      /* 0..SD_FULL */
+    uint8_t acc;        /* < SD_FULL */
+} sd_mod_t;
+
+/* One cycle of the modulator: 1 = on */
+static inline uint8_t sd_step(sd_mod_t *m)
+{
+    uint16_t a = (uint16_t)(m->acc + m->level);
+    if (a >= SD_FULL) { m->acc = (uint8_t)(a - SD_FULL); return 1; }
+    m->acc = (uint8_t)a;
+    return 0;
+}
+
+/* Start at `pct` / heater off and IRQ off */
+void HeaterSd_Start(uint8_t pct);
+void HeaterSd_Stop(void);
+
+/* New level, applied from the next cycle on (task or ISR) */
+void HeaterSd_Set(uint8_t pct);
+
+/* From HAL_TIM_PeriodElapsedCallback for TIM3 */
+void HeaterSd_Tick(void);
+
+#endif /* HEATER_SD_H_ */
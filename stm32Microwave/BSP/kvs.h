@@ -0,0 +1,67 @@
+#ifndef KVS_H_
+#define KVS_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Log-structured key/value store in two flash sectors.
+*           - One sector is active: an 8-byte header (magic, sequence)
+*             followed by append-only records
+*               [key:16 | len:16] [data, padded to 4] [CRC-32]
+*             The CRC word is programmed last and commits the record; a
+*             record cut by power loss fails its CRC and is skipped.
+*           - When the active sector is full, the live records are copied
+*             to the other one, whose header is written last. A compaction
+*             cut short leaves a headerless sector that boot ignores. The
+*             old header there is zeroed before the erase, so a torn erase
+*             cannot leave it over scrambled contents.
+*           - Init scans the active sector once into a RAM index
+*             (key -> offset of its latest record); Get is O(1).
+*           Erasing a 128 KB sector stalls the CPU (code runs from the same
+*           flash) for 1-2 s, so writes belong to idle states.
+*           The flash access is a kvs_flash_t, so another backend (e.g. a
+*           file on a host) can be plugged in.
+******************************************************/
+
+#include <stdint.h>
+
+/* Keys are 0..KVS_MAX_KEYS-1 */
+#ifndef KVS_MAX_KEYS
+#define KVS_MAX_KEYS    32u
+#endif
+#ifndef KVS_MAX_VALUE
+#define KVS_MAX_VALUE   256u
+#endif
+
+/* Keys used by this firmware */
+enum {
+    KVS_KEY_POWER = 1,      /* uint8_t  PowerLevel last selected */
+    KVS_KEY_CYCLES,         /* uint32_t completed cooks */
+    KVS_KEY_THERM_CAL,      /* int16_t  thermistor offset, 0.1 degC */
+    KVS_KEY_RECIPE0 = 8     /* rcp_stage_t[] user program 0, 1, ... */
+};
+
+typedef struct {
+    uintptr_t base[2];      /* sector start addresses, memory-mapped */
+    uint32_t  size;         /* bytes per sector */
+    uint8_t (*erase)(uint8_t sector);                   /* 1 = ok */
+    uint8_t (*program)(uintptr_t addr, uint32_t word);  /* 1 = ok, clears bits only */
+    void    (*lock)(void);                              /* optional */
+    void    (*unlock)(void);
+} kvs_flash_t;
+
+/* Sectors 10/11 (0x080C0000, 2 x 128 KB), reserved in the linker script */
+extern const kvs_flash_t kvs_stm32_flash;
+
+/* Scan (or format) the store. Returns 0 on a flash error. */
+uint8_t Kvs_Init(const kvs_flash_t *fl);
+
+/* Copy up to `max` bytes of `key`; returns its length, 0 if absent */
+uint16_t Kvs_Get(uint16_t key, void *dst, uint16_t max);
+
+/* Store `len` (1..KVS_MAX_VALUE) bytes. Same value again is not rewritten.
+   Returns 0 on a bad argument or flash error. */
+uint8_t Kvs_Put(uint16_t key, const void *src, uint16_t len);
+
+uint8_t Kvs_Delete(uint16_t key);
+
+#endif /* KVS_H_ */
@@ -36,6 +36,61 @@ extern "C" {
 #define ST7735_YSTART    0
 #endif
 
+/* ========= SPI transport =========
+ * LCD_USE_DMA: pixel data goes out over SPI1_TX on DMA2_Stream3 (see spi.c).
+ * Once the scheduler runs, the calling task blocks on a semaphore given from
+ * the DMA complete callback, so other tasks get the CPU while a fill or blit
+ * is on the wire. Before that (LCD_Init, splash screen) the driver spins.
+ * Bursts shorter than LCD_DMA_MIN_BYTES use HAL_SPI_Transmit directly,
+ * setting up the stream costs more than it saves there.
+ */
+#ifndef LCD_USE_DMA
+#define LCD_USE_DMA          1
+#endif
+#ifndef LCD_DMA_MIN_BYTES
+#define LCD_DMA_MIN_BYTES    32
+#endif
+
+/* Size (in pixels) of each of the two SRAM staging buffers that hold
+ * byte-swapped RGB565 on its way to the panel.
+ */
+#ifndef LCD_TXBUF_PIXELS
+#define LCD_TXBUF_PIXELS     64
+#endif
+
+/* ========= Fill engine =========
+ * Solid fills come from one scanline buffer (LCD_LINE_PIXELS pixels, packed
+ * and byte-swapped once per color) sent a whole line per transaction.
+ * LCD_FILL_FRAME16: for fills longer than a scanline with DMA available,
+ * switch SPI1 to 16-bit frames and let DMA repeat a single pixel with the
+ * memory address fixed, so the whole area is one transaction.
+ */
+#define LCD_LINE_PIXELS      ((ST7735_WIDTH > ST7735_HEIGHT) ? ST7735_WIDTH : ST7735_HEIGHT)
+#ifndef LCD_FILL_FRAME16
+#define LCD_FILL_FRAME16     1
+#endif
+
+/* ========= Shadow framebuffer =========
+ * LCD_USE_FRAMEBUFFER: every primitive draws into a full-frame RGB565 copy
+ * of the panel (40 KB, in CCM-RAM) and only records the rectangle it
+ * touched. LCD_Flush() merges overlapping/adjacent rectangles and sends each
+ * one as a single window through the SRAM staging buffers, so "clear a box
+ * then redraw it" reaches the panel once. Nothing is visible until the next
+ * LCD_Flush(). After LCD_SetRotation() redraw the whole screen.
+ * LCD_DIRTY_RECTS: pending rectangles kept before the closest ones get merged.
+ */
+#ifndef LCD_USE_FRAMEBUFFER
+#define LCD_USE_FRAMEBUFFER  0
+#endif
+#ifndef LCD_DIRTY_RECTS
+#define LCD_DIRTY_RECTS      8
+#endif
+
+/* Build the DWT cycle-count benchmarks (LCD_BenchClear) */
+#ifndef LCD_ENABLE_BENCH
+#define LCD_ENABLE_BENCH     0
+#endif
+
 /* ========= Color helpers (RGB565) ========= */
 #define RGB565(r,g,b)    ( ((uint16_t)((r)&0x1F) << 11) | ((uint16_t)((g)&0x3F) << 5) | ((uint16_t)((b)&0x1F)) )
 
@@ -83,6 +138,35 @@ void LCD_DrawFastVLine(uint16_t x, uint16_t y, uint16_t h, uint16_t color);
 /* Push a raw RGB565 image block (w*h pixels) to (x,y) */
 void LCD_DrawImage565(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels);
 
+/* Hardware vertical scrolling (rotations 0 and 2 only; returns 0 otherwise).
+ * top_fixed/bottom_fixed rows stay put, the rows between form a ring.
+ * LCD_SetScrollStart(n) shows ring row n (0 = top_fixed) at the top of the
+ * scroll area; drawing still uses unscrolled coordinates. Changing rotation
+ * turns scrolling off. */
+uint8_t LCD_SetScrollArea(uint16_t top_fixed, uint16_t bottom_fixed);
+void LCD_SetScrollStart(uint16_t first);
+
+/* Start sending a w*h block that is already big-endian RGB565 (the panel's
+ * byte order) and return while it is still on the wire. The block must lie
+ * fully on screen, and buf must stay untouched until the next LCD_* call or
+ * LCD_Sync(), either of which waits for it first. Goes straight to the panel,
+ * bypassing the shadow framebuffer. */
+void LCD_PushBlockAsync(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const void *be565);
+void LCD_Sync(void);
+
+/* Push pending dirty rectangles to the panel (no-op without framebuffer) */
+void LCD_Flush(void);
+
+/* Copy a w*h block of what is on screen into dst. Returns 1 on success,
+ * 0 when there is no shadow framebuffer to read from. */
+uint8_t LCD_ReadImage565(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *dst);
+
+#if LCD_ENABLE_BENCH
+/* Time one full-screen clear through the old per-pixel-pair loop and through
+ * the fill engine; results in microseconds (also printed on the console). */
+void LCD_BenchClear(uint16_t color, uint32_t *legacy_us, uint32_t *fast_us);
+#endif
+
 /* Expose current logical width/height after rotation (read-only) */
 uint16_t LCD_Width(void);
 uint16_t LCD_Height(void);
@@ -0,0 +1,60 @@
+#ifndef __LCD_TILE_H
+#define __LCD_TILE_H
+/*
+ * Tiled renderer for builds that cannot spare a full framebuffer.
+ * - A frame is recorded once as a display list (TILE_Begin + TILE_* ops).
+ * - TILE_Render() walks the screen in bands of LCD_TILE_ROWS rows, each cut
+ *   into tiles of LCD_TILE_PIXELS pixels, rasterizes every op that touches
+ *   the tile into a small SRAM buffer and sends it as one DMA block
+ *   (LCD_PushBlockAsync) while the next tile renders into the other buffer.
+ * RAM: 2 * LCD_TILE_PIXELS * 2 bytes of tiles + LCD_TILE_OPS ops
+ *      (~6.5 KB with the defaults).
+ * Ops are drawn in recording order, later ones on top.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "lcd.h"
+
+/* Rows per band */
+#ifndef LCD_TILE_ROWS
+#define LCD_TILE_ROWS    16
+#endif
+/* Pixels per tile buffer; tile width is LCD_TILE_PIXELS / LCD_TILE_ROWS */
+#ifndef LCD_TILE_PIXELS
+#define LCD_TILE_PIXELS  1280
+#endif
+/* Display list capacity (a text op takes one entry per character) */
+#ifndef LCD_TILE_OPS
+#define LCD_TILE_OPS     64
+#endif
+
+/* Start a new display list; bg is drawn wherever no op covers */
+void TILE_Begin(uint16_t bg);
+
+/* Record primitives. Each returns 1 if recorded, 0 when the list is full.
+ * Pointers (glyph masks, images) are kept, not copied: they must stay valid
+ * until TILE_Render() returns. */
+uint8_t TILE_Rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
+uint8_t TILE_Line(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color);
+uint8_t TILE_Circle(uint16_t xc, uint16_t yc, uint8_t r, uint16_t color, uint8_t filled);
+/* 1bpp mask, MSB-left rows of `stride` bytes; mode 0 opaque, 1 transparent */
+uint8_t TILE_Glyph(uint16_t x, uint16_t y, uint8_t w, uint8_t h,
+                   const uint8_t *msk, uint8_t stride,
+                   uint16_t fc, uint16_t bc, uint8_t mode);
+/* ASCII string in the 6x12 (size 12) or 8x16 (size 16) font */
+uint8_t TILE_Text(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc,
+                  const char *s, uint8_t size, uint8_t mode);
+uint8_t TILE_Image(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels);
+
+/* Rasterize the list over the whole screen, or only over one area */
+void TILE_Render(void);
+void TILE_RenderArea(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __LCD_TILE_H */
@@ -0,0 +1,86 @@
+#ifndef LOWPOWER_H_
+#define LOWPOWER_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Tickless idle (configUSE_TICKLESS_IDLE = 1). This file replaces
+*           the port's vPortSuppressTicksAndSleep:
+*           - LP_MODE_STOP (the state machine sets it on entry to IDLE):
+*             SysTick stops, the RTC wakeup timer is set for the expected
+*             idle time and the core enters STOP with the low-power
+*             regulator. Keys (EXTI1/12), the console RX pin (PA3, EXTI3)
+*             and the RTC wake it. The RTC subsecond count gives the time
+*             slept, the kernel tick is stepped by that amount and the clock
+*             tree is set up again.
+*           - LP_MODE_SLEEP (set on entry to ACTIVE): plain WFI with the tick
+*             left running, so TIM3 PWM, TIM4 and DMA keep working.
+*           STOP falls back to SLEEP while something needs its clock: the
+*           key scan (TIM7), burst firing (TIM3 update IRQ), a nonzero
+*           heater compare, SPI/UART transfers, a LowPower_Hold() that has
+*           not run out, or less than MW_LP_CONSOLE_HOLD_MS since the
+*           console woke the core. The door servo (TIM2_CH2 on PA1) needs
+*           its 50 Hz pulses until it has travelled, and STOP would cut
+*           them (PA1 may even freeze high mid-pulse), so every servo
+*           write holds STOP off for MW_LP_SERVO_HOLD_MS. The byte
+*           that wakes the core from STOP is lost, so a host should send a
+*           newline first.
+*           The RTC runs from LSI (MW_LP_RTC_LSE = 0) or from a 32.768 kHz
+*           crystal. LSI is only accurate to a few %, and so is the time
+*           stepped after a STOP.
+*           The HAL RTC driver is not part of this tree, so the RTC is set up
+*           at register level.
+******************************************************/
+
+#include <stdint.h>
+
+#ifndef MW_LP_RTC_LSE
+#define MW_LP_RTC_LSE           0
+#endif
+
+/* Idle periods shorter than this are spent in SLEEP */
+#ifndef MW_LP_STOP_MIN_MS
+#define MW_LP_STOP_MIN_MS       5u
+#endif
+
+/* One STOP lasts at most this long (16-bit wakeup timer at RTCCLK/16) */
+#ifndef MW_LP_STOP_MAX_MS
+#define MW_LP_STOP_MAX_MS       30000u
+#endif
+
+#ifndef MW_LP_CONSOLE_HOLD_MS
+#define MW_LP_CONSOLE_HOLD_MS   5000u
+#endif
+
+/* STOP is held off this long after a door servo write (SG90 full travel) */
+#ifndef MW_LP_SERVO_HOLD_MS
+#define MW_LP_SERVO_HOLD_MS     500u
+#endif
+
+typedef enum {
+    LP_MODE_SLEEP = 0,
+    LP_MODE_STOP
+} LowPowerMode;
+
+typedef struct {
+    uint32_t sleep_count;   /* WFI entries */
+    uint32_t sleep_ms;      /* time spent in them */
+    uint32_t stop_count;    /* STOP entries */
+    uint32_t stop_ms;       /* time spent in them */
+    uint32_t stop_blocked;  /* STOP allowed but a peripheral was busy */
+    uint32_t aborted;       /* a task became ready before sleeping */
+} LowPowerStats;
+
+/* RTC clock + wakeup timer; once, before the scheduler starts */
+void LowPower_Init(void);
+
+/* Deepest mode the idle task may use */
+void LowPower_SetMode(LowPowerMode mode);
+
+/* No STOP for the next `ms` (SLEEP only); a longer hold is kept. From
+   tasks, or before the scheduler starts. */
+void LowPower_Hold(uint32_t ms);
+
+/* Copy the counters; clear them when `reset` is set */
+void LowPower_GetStats(LowPowerStats *out, uint8_t reset);
+
+#endif /* LOWPOWER_H_ */
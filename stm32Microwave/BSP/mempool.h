@@ -0,0 +1,65 @@
+#ifndef MEMPOOL_H_
+#define MEMPOOL_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Fixed-size block pool, one per size class.
+*           Free blocks form a LIFO list whose head is swapped with
+*           LDREX/STREX, so MemPool_Alloc and MemPool_Free are O(1), take
+*           no lock and can be called from tasks and ISRs alike. Any
+*           exception between the load and the store clears the exclusive
+*           monitor and the store is retried, which also rules out the ABA
+*           case on a single core.
+*           Links are block numbers (index + 1, 0 ends the list) rather
+*           than pointers: the head stays one 32-bit word for LDREX/STREX
+*           whatever the pointer size, and the pool builds on a host.
+*           Messages are allocated from a pool, filled in, and only the
+*           pointer goes through the queue; the receiver frees the block.
+*           The pool keeps used / peak / failed counters.
+******************************************************/
+
+#include <stdint.h>
+
+/* First word of a free block: number of the next free block */
+typedef struct {
+    uint32_t next;
+} MemPoolBlock;
+
+typedef struct {
+    volatile uint32_t head;         /* free list: first block number, 0 = empty */
+    uint8_t          *base;
+    uint32_t          block_size;
+    uint32_t          count;
+    volatile uint32_t used;
+    volatile uint32_t peak;         /* highest `used` since init / reset */
+    volatile uint32_t fail;         /* Alloc on an empty pool */
+} MemPool;
+
+typedef struct {
+    uint32_t count;
+    uint32_t used;
+    uint32_t peak;
+    uint32_t fail;
+} MemPoolStats;
+
+/* Block size rounded up so every block stays 8-byte aligned */
+#define MEMPOOL_BLOCK_SIZE(size)   (((uint32_t)(size) + 7u) & ~7u)
+
+/* Backing store for `count` blocks of `size` bytes */
+#define MEMPOOL_STORAGE(name, size, count) \
+    static uint64_t name[MEMPOOL_BLOCK_SIZE(size) / 8u * (count)]
+
+/* Before any other call (not thread-safe) */
+void  MemPool_Init(MemPool *p, void *mem, uint32_t block_size, uint32_t count);
+
+/* NULL when the pool is empty */
+void *MemPool_Alloc(MemPool *p);
+
+/* Blocks not from `p` are ignored */
+void  MemPool_Free(MemPool *p, void *blk);
+
+/* Copy the counters; `reset` restarts peak from the current use and
+   clears fail */
+void  MemPool_GetStats(MemPool *p, MemPoolStats *out, uint8_t reset);
+
+#endif /* MEMPOOL_H_ */
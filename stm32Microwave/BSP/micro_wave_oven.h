@@ -12,15 +12,20 @@
 #include <stdint.h>
 #include "stm32f4xx_hal.h"
 #include "led.h"
+#include "beep.h"
+#include "clock.h"
 
 /* External LED descriptor (defined elsewhere) */
 extern led_d led1;
+/* Buzzer (main.c); Port stays NULL until Beep_Init() */
+extern Beep_HandleTypeDef hbeep;
 
 /* ===== Timer handles provided by CubeMX =====
    - TIM2_CH2 (PA1) : door servo (50 Hz)
    - TIM3_CH3 (PB0) : heater PWM (1 kHz)
    - TIM3_CH4 (PC9) : turntable PWM (1 kHz)
-   - TIM4          : 1 Hz base timer for countdown (Update IT)
+   - TIM4          : 2 kHz free-running counter; CH1 compare (no output)
+                     interrupts on each whole second of the countdown
 */
 extern TIM_HandleTypeDef htim2;
 extern TIM_HandleTypeDef htim3;
@@ -33,18 +38,32 @@ extern TIM_HandleTypeDef htim4;
 #define MW_HEATER_CH        TIM_CHANNEL_3      /* PB0 */
 #define MW_TURNTABLE_TIM    (&htim3)
 #define MW_TURNTABLE_CH     TIM_CHANNEL_4      /* PC9 */
+#define MW_COUNTDOWN_TIM    (&htim4)
+#define MW_COUNTDOWN_CH     TIM_CHANNEL_1
+#define MW_COUNTDOWN_CPMS   (CLOCK_TIM_COUNTDOWN_HZ / 1000u)    /* counts per ms */
 
 /* Servo pulse (µs) for your SG90 — tune to your mechanics if needed */
 #define DOOR_OPEN_US        (1000u)
 #define DOOR_CLOSE_US       (2000u)
 #define DOOR_NEUTRAL_US     (1500u)
 
-/* Microwave states */
+/* Microwave states. All but IDLE and ACTIVE are leaves; those two are the
+   superstates the others nest in (see the table in mw_ctrl.c):
+     IDLE   : STANDBY, TIME_SETTING, POWER_SETTING, PROG_SETTING, COMPLETED
+     ACTIVE : COOKING, PAUSED, DOOR_OPEN, WAIT_DOOR */
 typedef enum {
     STATE_STANDBY = 0,    /* Idle */
     STATE_TIME_SETTING,   /* Set time */
     STATE_POWER_SETTING,  /* Set power */
-    STATE_COMPLETED       /* Done */
+    STATE_COMPLETED,      /* Done */
+    STATE_COOKING,        /* Heating, countdown running */
+    STATE_PAUSED,         /* Cook interrupted, door closed */
+    STATE_DOOR_OPEN,      /* Cook interrupted by the door */
+    STATE_PROG_SETTING,   /* Pick a program */
+    STATE_WAIT_DOOR,      /* Program waits for the door to open and close */
+    STATE_IDLE,
+    STATE_ACTIVE,
+    STATE_COUNT
 } MicrowaveState;
 
 /* Power levels */
@@ -69,8 +88,10 @@ typedef enum {
 /* Main control structure */
 typedef struct {
     MicrowaveState state;     /* current state */
-    uint16_t       cooking_time; /* seconds remaining */
+    uint32_t       cooking_time; /* milliseconds remaining */
     PowerLevel     power;     /* selected power */
+    uint8_t        power_pct; /* heater power while cooking, 0..100 %:
+                                 from `power`, or set by a program stage */
     DoorState      door;      /* 0 = open, 1 = closed */
     HeatingState   heating;   /* 0/1 */
 } MicrowaveCtrl;
@@ -81,12 +102,14 @@ void plan_cooking(void);                     /* close door + turn panel LED off
 void end_cooking(void);                      /* open door + turn panel LED on  */
 void start_cooking(MicrowaveCtrl *mw);
 void stop_cooking(MicrowaveCtrl *mw);
+uint8_t countdown_tick(MicrowaveCtrl *mw);   /* on the TIM4 CH1 event; 1 = expired */
 void power_display(MicrowaveCtrl *mw);
+void time_display(MicrowaveCtrl *mw);
+void status_display(const char *msg);        /* top strip message */
+uint8_t power_pct_from_level(PowerLevel pwr);
+void beep_signal(uint8_t times);
 
-/* Optional tickless hooks (FreeRTOS) */
-#if configUSE_TICKLESS_IDLE
-void PRE_SLEEP_PROCESSING(uint32_t ulExpectedIdleTime);
-void POST_SLEEP_PROCESSING(uint32_t ulExpectedIdleTime);
-#endif
+/* The oven instance (main.c) */
+extern MicrowaveCtrl mw1;
 
 #endif /* MICRO_WAVE_OVEN_H_ */
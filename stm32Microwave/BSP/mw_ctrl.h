@@ -0,0 +1,98 @@
+#ifndef MW_CTRL_H_
+#define MW_CTRL_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Controller task. It owns MicrowaveCtrl and sleeps on an event
+*           queue; buttons (EXTI), the TIM4 countdown compare, UART commands and
+*           door changes are posted to it and fed to the hierarchical
+*           state machine (fsm.h) whose table lives in mw_ctrl.c.
+*           Nothing runs while the queue is empty. Keys come debounced
+*           from button.h.
+*             PB1  (KEY_MODE)   : STANDBY -> TIME_SETTING -> POWER_SETTING
+*                                 -> PROG_SETTING, aborts a cook
+*             PB12 (KEY_ACTION) : +10 s / next power / next program /
+*                                 start-pause-resume; held in TIME_SETTING
+*                                 it keeps adding 10 s, faster and faster
+*           Events are 8 bytes; anything larger travels in a block from the
+*           message pool (mempool.h) and only its pointer is queued. The
+*           controller frees the block after dispatching the event.
+*           Settings (power level, cook count, user programs, thermistor
+*           offset) go to the flash store only once the machine is back
+*           in IDLE.
+******************************************************/
+
+#include <stdint.h>
+#include "recipe.h"
+#include "mempool.h"
+#include "micro_wave_oven.h"
+
+#ifndef MW_CTRL_QUEUE_LEN
+#define MW_CTRL_QUEUE_LEN   16u
+#endif
+
+/* Message blocks in flight (allocated, not yet dispatched) */
+#ifndef MW_MSG_POOL_COUNT
+#define MW_MSG_POOL_COUNT   4u
+#endif
+
+/* Events index the transition table columns */
+typedef enum {
+    MW_EV_KEY_MODE = 0, /* PB1 pressed  (= BTN_MODE) */
+    MW_EV_KEY_ACTION,   /* PB12 pressed (= BTN_ACTION) */
+    MW_EV_KEY_RELEASE,  /* arg: ButtonId */
+    MW_EV_KEY_LONG,     /* arg: ButtonId, held BTN_LONG_MS */
+    MW_EV_KEY_REPEAT,   /* arg: ButtonId, auto-repeat after LONG */
+    MW_EV_TICK,         /* TIM4 CH1, on each whole second left while cooking */
+    MW_EV_SET_TIME,     /* arg: seconds */
+    MW_EV_SET_POWER,    /* arg: PowerLevel */
+    MW_EV_DOOR_OPEN,
+    MW_EV_DOOR_CLOSE,
+    MW_EV_START,
+    MW_EV_STOP,
+    MW_EV_DONE,         /* countdown reached 0 (posted by the controller) */
+    MW_EV_PROGRAM,      /* arg: program index (recipe.h) */
+    MW_EV_STAGE_COOK,   /* posted by the controller: next program stage is */
+    MW_EV_STAGE_WAIT,   /*   a COOK / a WAIT_DOOR / */
+    MW_EV_STAGE_END,    /*   the end (or a plain cook is over) */
+    MW_EV_PROGDEF,      /* arg: user slot, msg: MwProgDef */
+    MW_EV_SET_CAL,      /* arg: thermistor offset, (int16_t) 0.1 degC */
+    MW_EV_COUNT
+} MwEventType;
+
+typedef struct {
+    uint8_t  type;      /* MwEventType */
+    uint8_t  rsv;
+    uint16_t arg;
+    void    *msg;       /* MwCtrl_MsgAlloc block or NULL */
+} MwEvent;
+
+/* MW_EV_PROGDEF payload: new stages of a user program */
+typedef struct {
+    uint8_t     n;
+    rcp_stage_t st[RCP_USER_STAGES];
+} MwProgDef;
+
+/* Size class of the message pool: the largest payload */
+#define MW_MSG_SIZE         sizeof(MwProgDef)
+
+/* Create the queue; call before the scheduler starts (MX_FREERTOS_Init) */
+void MwCtrl_Init(MicrowaveCtrl *mw);
+
+/* Controller task body, never returns */
+void MwCtrl_Run(void);
+
+/* Queue an event from a task or an ISR. Returns 0 if the queue was full. */
+uint8_t MwCtrl_Post(MwEventType type, uint16_t arg);
+
+/* Message block of MW_MSG_SIZE bytes, NULL if all are in use (tasks / ISRs) */
+void   *MwCtrl_MsgAlloc(void);
+void    MwCtrl_MsgFree(void *msg);
+
+/* Queue an event with a message block; on failure the block is freed */
+uint8_t MwCtrl_PostMsg(MwEventType type, uint16_t arg, void *msg);
+
+/* Message pool counters */
+void    MwCtrl_MsgStats(MemPoolStats *out, uint8_t reset);
+
+#endif /* MW_CTRL_H_ */
@@ -0,0 +1,47 @@
+#ifndef PID_H_
+#define PID_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Fixed-point PID, one call per sample period.
+*           - Gains are Q16.16 and per sample (Ki = Ki_s * T, Kd = Kd_s / T).
+*           - Derivative acts on the measurement, so setpoint steps do not
+*             kick the output.
+*           - Anti-windup: the integrator is clamped to [i_min, i_max]
+*             (output units); PID_AW_CONDITIONAL also stops integrating
+*             while the output is saturated in the direction of the error.
+*           - The output is clamped to [out_min, out_max] and may move at
+*             most `slew` units per call (0 = no limit).
+*           No HAL/RTOS dependency.
+******************************************************/
+
+#include <stdint.h>
+
+#define PID_Q16(x)  ((int32_t)((x) * 65536.0 + (((x) >= 0) ? 0.5 : -0.5)))
+
+typedef enum {
+    PID_AW_CLAMP = 0,       /* integrator limits only */
+    PID_AW_CONDITIONAL      /* limits + freeze while saturated */
+} PidAntiWindup;
+
+typedef struct {
+    /* configuration */
+    int32_t kp, ki, kd;         /* Q16.16 */
+    int32_t out_min, out_max;
+    int32_t i_min, i_max;       /* output units */
+    int32_t slew;               /* output units per call, 0 = off */
+    uint8_t aw;                 /* PidAntiWindup */
+    /* state */
+    int64_t integ;              /* Q16 output units */
+    int32_t prev_meas;
+    int32_t out;
+} pid_q16_t;
+
+/* Clear the state: the next derivative is taken from `meas`, the slew
+   limit starts from `out`. */
+void pid_reset(pid_q16_t *p, int32_t meas, int32_t out);
+
+/* One sample: returns the new output */
+int32_t pid_step(pid_q16_t *p, int32_t setpoint, int32_t meas);
+
+#endif /* PID_H_ */
@@ -0,0 +1,93 @@
+#ifndef PROF_H_
+#define PROF_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Run-time profiling on the DWT cycle counter (MW_PROF = 1).
+*           - Per task: the kernel's run time stats
+*             (configGENERATE_RUN_TIME_STATS) count core cycles >>
+*             PROF_RUNTIME_SHIFT. CYCCNT is 32 bits; it is extended in
+*             software on every read, and the 1 kHz HAL tick reads it so no
+*             wrap is missed.
+*           - Per IRQ: PROF_IRQ_ENTER / PROF_IRQ_EXIT in the
+*             stm32f4xx_it.c handlers add up calls and cycles. The time of
+*             a handler includes whatever preempted it. With MW_TRACE
+*             the exit also records the handler as a trace event.
+*           - Stack high-water marks from uxTaskGetSystemState().
+*           CYCCNT stops in SLEEP and STOP, so the counters only cover
+*           time awake; the snapshot carries the tick count as well and
+*           the decoder works out the load against wall time.
+*           Prof_Snapshot() streams one binary frame on USART2 (console
+*           PROF), decoded by tools/prof_top.py. Little endian:
+*             hdr   "PRF1", u16 frame length, u8 tasks, u8 irqs,
+*                   u32 tick ms, u32 SystemCoreClock,
+*                   u32 total run time, u8 shift, u8 pad[3]
+*             task  char name[16], u32 run time, u16 stack free (words),
+*                   u8 priority, u8 state (eTaskState)
+*             irq   u32 calls, u32 cycles low, u32 cycles high
+*             crc   u16 CRC-16/CCITT-FALSE over everything before it
+******************************************************/
+
+#include <stdint.h>
+#include "main.h"
+#include "trace.h"
+
+#ifndef MW_PROF
+#define MW_PROF             1
+#endif
+
+/* Run time stats unit: 2^shift core cycles */
+#define PROF_RUNTIME_SHIFT  6u
+
+/* Tasks reported in a snapshot */
+#ifndef PROF_MAX_TASKS
+#define PROF_MAX_TASKS      12u
+#endif
+
+/* Instrumented handlers; the order is the one in the frame */
+typedef enum {
+    PROF_IRQ_EXTI1 = 0,
+    PROF_IRQ_EXTI15_10,
+    PROF_IRQ_TIM3,
+    PROF_IRQ_TIM4,
+    PROF_IRQ_TIM7,
+    PROF_IRQ_DMA1_S5,       /* USART2 RX */
+    PROF_IRQ_DMA1_S6,       /* USART2 TX */
+    PROF_IRQ_DMA2_S3,       /* SPI1 TX (LCD) */
+    PROF_IRQ_USART2,
+    PROF_IRQ_COUNT
+} ProfIrq;
+
+#if MW_PROF || MW_TRACE
+#define PROF_IRQ_ENTER()        uint32_t prof_t0_ = DWT->CYCCNT
+#define PROF_IRQ_EXIT(id)       Prof_IrqExit((id), DWT->CYCCNT - prof_t0_)
+#else
+#define PROF_IRQ_ENTER()        do { } while (0)
+#define PROF_IRQ_EXIT(id)       do { } while (0)
+#endif
+
+/* portCONFIGURE_TIMER_FOR_RUN_TIME_STATS: start CYCCNT (not reset) */
+void     Prof_Init(void);
+
+/* portGET_RUN_TIME_COUNTER_VALUE; also from the HAL tick */
+uint32_t Prof_RunTime(void);
+
+void     Prof_IrqAdd(ProfIrq id, uint32_t cycles);
+
+static inline void Prof_IrqExit(ProfIrq id, uint32_t cycles)
+{
+#if MW_PROF
+    Prof_IrqAdd(id, cycles);
+#endif
+    trace_put(TRACE_EV_IRQ, (uint8_t)id, trace_sat16(cycles));
+}
+
+/* CRC-16/CCITT-FALSE of the binary frames; start with crc = 0xFFFF and
+   chain it to cover a frame sent in pieces */
+uint16_t Prof_Crc16(uint16_t crc, const uint8_t *p, uint32_t n);
+
+/* Build a frame and queue it on USART2, from a task. Returns 0 if it
+   could not be queued within a second. */
+uint8_t  Prof_Snapshot(void);
+
+#endif /* PROF_H_ */
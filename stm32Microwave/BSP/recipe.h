@@ -0,0 +1,93 @@
+#ifndef RECIPE_H_
+#define RECIPE_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Cooking programs: const stage arrays in flash, run by a
+*           small interpreter.
+*           - COOK  : power (%) for a time (s). 0 % is a rest stage
+*                     (countdown and turntable, no heat); 0 s is skipped.
+*           - BEEP  : n beeps, then straight on.
+*           - WAIT_DOOR : hold until the door is opened and closed again
+*                     (stir, turn over).
+*           - END
+*           rcp_next() runs instant stages and returns the next one that
+*           takes time; the oven's countdown or the door decides when it is
+*           over. Timing is not kept here, so a host test drives it with any
+*           clock. No HAL/RTOS dependency.
+*           Programs 0..RCP_BUILTIN-1 are built in; RCP_USER_SLOTS more are
+*           defined at run time (rcp_set_user) and kept in RAM.
+*           A program cannot be redefined while it runs (the controller
+*           answers ERR BUSY).
+******************************************************/
+
+#include <stdint.h>
+
+typedef enum {
+    RCP_END = 0,
+    RCP_COOK,
+    RCP_BEEP,
+    RCP_WAIT_DOOR
+} RcpOp;
+
+typedef struct {
+    uint8_t  op;        /* RcpOp */
+    uint8_t  pct;       /* COOK: power */
+    uint16_t arg;       /* COOK: seconds; BEEP: count */
+} rcp_stage_t;
+
+#define RCP_STAGE_COOK(pct, s)  { RCP_COOK, (pct), (s) }
+#define RCP_STAGE_REST(s)       { RCP_COOK, 0, (s) }
+#define RCP_STAGE_BEEP(n)       { RCP_BEEP, 0, (n) }
+#define RCP_STAGE_WAIT_DOOR     { RCP_WAIT_DOOR, 0, 0 }
+#define RCP_STAGE_END           { RCP_END, 0, 0 }
+
+typedef struct {
+    const char        *name;
+    const rcp_stage_t *stages;  /* ends with RCP_STAGE_END */
+} rcp_program_t;
+
+#ifndef RCP_USER_SLOTS
+#define RCP_USER_SLOTS   2u
+#endif
+#ifndef RCP_USER_STAGES
+#define RCP_USER_STAGES  8u     /* END not counted */
+#endif
+#define RCP_COOK_MAX_S   999u   /* what the time field can show */
+
+/* Number of programs (built in + user slots) and their names */
+uint8_t     rcp_count(void);
+const char *rcp_name(uint8_t index);
+
+/* Replace user program `slot` with n stages (END implied).
+   Returns 0 if a stage is malformed (a cook over RCP_COOK_MAX_S
+   included) or n is too large. */
+uint8_t rcp_set_user(uint8_t slot, const rcp_stage_t *st, uint8_t n);
+
+/* Stages of user program `slot` and their number in *n (END not counted);
+   NULL for a bad slot */
+const rcp_stage_t *rcp_user(uint8_t slot, uint8_t *n);
+
+typedef struct {
+    const rcp_stage_t *pc;      /* next stage; NULL when no program runs */
+    const rcp_stage_t *cur;     /* stage being executed */
+} rcp_run_t;
+
+typedef void (*rcp_beep_t)(void *ctx, uint16_t count);
+
+/* Arm program `index`. Returns 0 if there is no such program. */
+uint8_t rcp_load(rcp_run_t *r, uint8_t index);
+
+/* Execute up to the next timed/waiting stage and return it (also kept in
+   r->cur). NULL once the program is over, or if none is loaded. */
+const rcp_stage_t *rcp_next(rcp_run_t *r, rcp_beep_t beep, void *ctx);
+
+/* Drop the program */
+void rcp_clear(rcp_run_t *r);
+
+static inline uint8_t rcp_running(const rcp_run_t *r)
+{
+    return r->pc != 0;
+}
+
+#endif /* RECIPE_H_ */
@@ -0,0 +1,45 @@
+#ifndef RTOS_BENCH_H_
+#define RTOS_BENCH_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Context switch latency (MW_RTOS_BENCH = 1, console BENCH).
+*           Two tasks above every application task: "benchTx" stamps
+*           DWT->CYCCNT and gives a notification to "benchRx", which is
+*           one priority higher, so the give switches straight to it.
+*           benchRx takes the difference, so one sample is the notify
+*           call + PendSV + task selection + the restore, in core cycles.
+*           RTOS_BENCH_FPU makes benchTx execute a floating-point
+*           instruction before each stamp: it then leaves with an extended
+*           frame and PendSV also saves s16-s31 (and, through lazy
+*           stacking, s0-s15). The difference between the two runs is what
+*           a task doing FP math costs on every switch.
+*           Interrupts stay enabled, so a tick in between shows up in max.
+*           The tasks are created on the first run.
+******************************************************/
+
+#include <stdint.h>
+
+#ifndef MW_RTOS_BENCH
+#define MW_RTOS_BENCH       1
+#endif
+
+#define RTOS_BENCH_MAX_ROUNDS   10000u
+
+typedef enum {
+    RTOS_BENCH_INT = 0,     /* no FP context in either task */
+    RTOS_BENCH_FPU          /* benchTx has live FP context */
+} RtosBenchMode;
+
+typedef struct {
+    uint32_t rounds;
+    uint32_t min;           /* DWT cycles */
+    uint32_t avg;
+    uint32_t max;
+} RtosBenchStats;
+
+/* Blocking, from a task (1..RTOS_BENCH_MAX_ROUNDS switches).
+   Returns 0 if the tasks could not be created or did not finish. */
+uint8_t RtosBench_Run(RtosBenchMode mode, uint32_t rounds, RtosBenchStats *out);
+
+#endif /* RTOS_BENCH_H_ */
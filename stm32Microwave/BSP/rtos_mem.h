@@ -0,0 +1,24 @@
+#ifndef RTOS_MEM_H_
+#define RTOS_MEM_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Every task, queue, stream buffer and semaphore is created with
+*           caller-provided memory (the *Static calls, or cb_mem/stack_mem
+*           in osThreadAttr_t). Control blocks and queue storage stay in
+*           SRAM; task stacks go to CCM RAM (.ccmbss), which the DMA
+*           controllers cannot reach, so no transfer may use a buffer on a
+*           task stack. The idle and timer task memory is in freertos.c.
+*           The heap_4 heap is kept small for library code that runs
+*           before the kernel starts. traceMALLOC (FreeRTOSConfig.h)
+*           stops at configASSERT on any pvPortMalloc once the scheduler
+*           is running, and so does a failed allocation.
+******************************************************/
+
+#include "FreeRTOS.h"
+
+/* Task stack in CCM RAM (not zeroed; the kernel fills it on creation) */
+#define RTOS_STACK(name, bytes) \
+    static StackType_t name[(bytes) / sizeof(StackType_t)] __attribute__((section(".ccmbss"), aligned(8)))
+
+#endif /* RTOS_MEM_H_ */
@@ -0,0 +1,96 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Event trace ring (MW_TRACE = 1).
+*           One record is 8 bytes: the DWT->CYCCNT stamp and a word with
+*           the event id and its arguments. trace_put() takes a slot with
+*           LDREX/STREX on the write index, so tasks and ISRs of any
+*           priority can record without a lock; about 20 cycles per event
+*           (console TRACE COST measures it). The ring keeps the last
+*           TRACE_LEN events and lives in CCM RAM.
+*           Sources: task switches and queue / semaphore traffic (kernel
+*           trace macros in FreeRTOSConfig.h), the instrumented IRQ
+*           handlers (prof.h), LCD SPI DMA, USART2 TX DMA and RX events.
+*           TRACE DUMP stops recording, sends the ring and a task name
+*           table as one frame and starts over; tools/trace2chrome.py
+*           turns it into Chrome trace / Perfetto JSON. The frame is
+*           larger than the console ring and goes out in pieces; a printf
+*           from another task can land in between, and the CRC then drops
+*           the frame. Little endian:
+*             hdr   "TRC1", u32 frame length, u32 SystemCoreClock,
+*                   u32 events written, u16 records, u8 tasks, u8 pad
+*             task  u16 number (uxTCBNumber), char name[16]
+*             rec   u32 cycles, u8 event, u8 arg8, u16 arg16 (oldest first)
+*             crc   u16 CRC-16/CCITT-FALSE over everything before it
+*           CYCCNT stops in SLEEP and STOP, so idle gaps look shorter
+*           than they were.
+******************************************************/
+
+#include <stdint.h>
+#include "stm32f4xx.h"
+
+#ifndef MW_TRACE
+#define MW_TRACE            1
+#endif
+
+/* Records in the ring (power of two) */
+#ifndef TRACE_LEN
+#define TRACE_LEN           512u
+#endif
+
+typedef enum {
+    TRACE_EV_TASK_IN = 1,   /* arg16: task number */
+    TRACE_EV_QUEUE_SEND,    /* arg8: from ISR, arg16: queue address >> 2 */
+    TRACE_EV_QUEUE_RECV,    /* arg8: from ISR, arg16: queue address >> 2 */
+    TRACE_EV_IRQ,           /* at handler exit; arg8: ProfIrq, arg16: cycles */
+    TRACE_EV_LCD_DMA,       /* arg16: bytes */
+    TRACE_EV_LCD_DMA_DONE,
+    TRACE_EV_UART_TX,       /* arg16: bytes */
+    TRACE_EV_UART_TX_DONE,
+    TRACE_EV_UART_RX,       /* arg16: bytes */
+    TRACE_EV_MARK,          /* Trace_Cost(); arg16: run */
+} TraceEvent;
+
+typedef struct {
+    uint32_t ts;
+    uint32_t w;             /* event | arg8 << 8 | arg16 << 16 */
+} TraceRec;
+
+extern TraceRec          g_trace_buf[TRACE_LEN];
+extern volatile uint32_t g_trace_idx;
+extern volatile uint8_t  g_trace_on;
+
+static inline void trace_put(uint8_t ev, uint8_t a8, uint16_t a16)
+{
+#if MW_TRACE
+    uint32_t i;
+    if (!g_trace_on) return;
+    do {
+        i = __LDREXW(&g_trace_idx);
+    } while (__STREXW(i + 1u, &g_trace_idx));
+    TraceRec *r = &g_trace_buf[i & (TRACE_LEN - 1u)];
+    r->ts = DWT->CYCCNT;
+    r->w  = (uint32_t)ev | ((uint32_t)a8 << 8) | ((uint32_t)a16 << 16);
+#else
+    (void)ev; (void)a8; (void)a16;
+#endif
+}
+
+static inline uint16_t trace_sat16(uint32_t v)
+{
+    return (v > 0xFFFFu) ? 0xFFFFu : (uint16_t)v;
+}
+
+/* Start / stop recording */
+void     Trace_Enable(uint8_t on);
+
+/* Send the ring as one frame on USART2 and restart it, from a task.
+   Returns 0 if the console did not take it within a second. */
+uint8_t  Trace_Dump(void);
+
+/* Average cycles of one trace_put() */
+uint32_t Trace_Cost(void);
+
+#endif /* TRACE_H_ */
@@ -0,0 +1,61 @@
+#ifndef UART_CMD_H_
+#define UART_CMD_H_
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Line-based command channel on USART2 RX.
+*           USART2_RX runs on circular DMA (DMA1_Stream5); the IDLE-line,
+*           half- and full-transfer events hand whatever arrived to a
+*           stream buffer, so there is no per-byte interrupt. A parser
+*           task assembles lines and posts them to the controller task
+*           (mw_ctrl.h):
+*             TIME <seconds>            set cooking time (0..999)
+*             POWER LOW|MEDIUM|HIGH     set power level (or 0/1/2)
+*             DOOR OPEN|CLOSE           move the door
+*             START / STOP              start or stop heating
+*             PROG [n]                  list programs / run program n
+*             PROGDEF <slot> <stage>... define user program 1..RCP_USER_SLOTS:
+*                                       C<pct>/<s> cook, R<s> rest, B<n>
+*                                       beeps, W wait for the door;
+*                                       ERR SLOT / ERR STAGE <stage> /
+*                                       ERR LONG if malformed, ERR BUSY while
+*                                       a program runs, else OK; ERR FLASH
+*                                       later if storing it failed
+*             CAL <0.1 degC>            thermistor offset (MW_HEATER_PID),
+*                                       stored once the oven is idle
+*             STATUS                    print the current settings
+*             LP [RESET]                idle counters per sleep mode (lowpower.h)
+*             CLOCK [FULL|LOW]          show / switch the clock profile (clock.h)
+*             POOL [RESET]              message pool use (mw_ctrl.h)
+*             PROF                      binary profiling frame (prof.h)
+*             TRACE [ON|OFF|COST]       binary event trace dump / recording /
+*                                       cycles per event (MW_TRACE, trace.h)
+*             BENCH [rounds]            context switch cycles (rtos_bench.h)
+*           Replies go out through printf (USART2 TX).
+******************************************************/
+
+#include <stdint.h>
+#include "micro_wave_oven.h"
+
+/* Circular DMA area; must hold what can arrive between two events
+   (half of it at full baud) */
+#ifndef UART_CMD_DMA_SIZE
+#define UART_CMD_DMA_SIZE     64u
+#endif
+/* Stream buffer between the RX events and the parser task */
+#ifndef UART_CMD_STREAM_SIZE
+#define UART_CMD_STREAM_SIZE  256u
+#endif
+/* Longest accepted command line */
+#ifndef UART_CMD_LINE_MAX
+#define UART_CMD_LINE_MAX     64u
+#endif
+
+/* Create the parser task and start reception; STATUS reports *mw.
+   Call once after MX_USART2_UART_Init(), before or after the kernel starts. */
+void UartCmd_Start(MicrowaveCtrl *mw);
+
+/* Bytes lost because the parser fell behind (stream buffer full) */
+uint32_t UartCmd_Dropped(void);
+
+#endif /* UART_CMD_H_ */
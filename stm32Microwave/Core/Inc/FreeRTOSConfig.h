@@ -56,7 +56,7 @@
 #define CMSIS_device_header "stm32f4xx.h"
 #endif /* CMSIS_device_header */
 
-#define configENABLE_FPU                         0
+#define configENABLE_FPU                         1
 #define configENABLE_MPU                         0
 
 #define configUSE_PREEMPTION                     1
@@ -68,8 +68,9 @@
 #define configTICK_RATE_HZ                       ((TickType_t)1000)
 #define configMAX_PRIORITIES                     ( 56 )
 #define configMINIMAL_STACK_SIZE                 ((uint16_t)128)
-#define configTOTAL_HEAP_SIZE                    ((size_t)30000)
+#define configTOTAL_HEAP_SIZE                    ((size_t)1024)
 #define configMAX_TASK_NAME_LEN                  ( 16 )
+#define configGENERATE_RUN_TIME_STATS            1
 #define configUSE_TRACE_FACILITY                 1
 #define configUSE_16_BIT_TICKS                   0
 #define configUSE_MUTEXES                        1
@@ -77,6 +78,8 @@
 #define configUSE_RECURSIVE_MUTEXES              1
 #define configUSE_COUNTING_SEMAPHORES            1
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION  0
+#define configUSE_TICKLESS_IDLE                  1
+#define configUSE_MALLOC_FAILED_HOOK             1
 /* USER CODE BEGIN MESSAGE_BUFFER_LENGTH_TYPE */
 /* Defaults to size_t for backward compatibility, but can be changed
    if lengths will always be less than the number of bytes in a size_t. */
@@ -157,6 +160,16 @@ header file. */
 #define configASSERT( x ) if ((x) == 0) {taskDISABLE_INTERRUPTS(); for( ;; );}
 /* USER CODE END 1 */
 
+/* USER CODE BEGIN 2 */
+/* Definitions needed when configGENERATE_RUN_TIME_STATS is on (freertos.c) */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS configureTimerForRunTimeStats
+#define portGET_RUN_TIME_COUNTER_VALUE getRunTimeCounterValue
+/* USER CODE END 2 */
+
 /* Definitions that map the FreeRTOS port interrupt handlers to their CMSIS
 standard names. */
 #define vPortSVCHandler    SVC_Handler
@@ -168,6 +181,48 @@ standard names. */
 
 /* USER CODE BEGIN Defines */
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* CLZ task selection: at most 32 priorities, so the CMSIS-RTOS2 ones are
+   halved. The wrapper passes priorities through unchanged, so every task
+   is created in user code with RTOS_PRIO(osPriorityX), none from the .ioc
+   (CubeMX writes the unfolded level): Low 8 -> 4, BelowNormal 16 -> 8,
+   Normal 24 -> 12, AboveNormal 32 -> 16, High 40 -> 20, Realtime 48 -> 24.
+   The timer task (2) stays below them all. osPriorityIdle folds to 0,
+   which osThreadNew refuses.
+   Reading back is lossy: osThreadGetPriority returns the folded level,
+   and neighbouring pairs share one, so with a shift of 1 a task created
+   at osPriorityNormal1 reads back as RTOS_PRIO(osPriorityNormal).
+   The stock freertos_os2.h insists on 56 priorities and no CLZ. Its
+   checks are relaxed by tools/freertos_os2_prio.patch; re-apply it
+   (`patch -p1 < tools/freertos_os2_prio.patch` in stm32Microwave/)
+   whenever CubeMX regenerates Middlewares. The patched header defines
+   FREERTOS_OS2_PRIO_PATCH and freertos.c stops the build without it. */
+#undef  configMAX_PRIORITIES
+#define configMAX_PRIORITIES                     ( 32 )
+#undef  configUSE_PORT_OPTIMISED_TASK_SELECTION
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION  1
+#define configCMSIS_PRIORITY_SHIFT               1
+#define RTOS_PRIO(p)                             ((p) >> configCMSIS_PRIORITY_SHIFT)
+/* configENABLE_FPU only matters to the ARMv8-M ports. The ARM_CM4F port
+   always turns on lazy stacking (FPCCR ASPEN | LSPEN): a task that has
+   used the FPU switches with s0-s31 saved, the others with the basic
+   frame, so the fixed-point tasks pay nothing for it. */
+/* Everything is allocated statically (rtos_mem.h); any pvPortMalloc after
+   the scheduler has started stops at configASSERT */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+#include <stddef.h>
+void RtosMem_MallocTrace(void *pv, size_t size);
+#endif
+#define traceMALLOC(pvAddress, uiSize)          RtosMem_MallocTrace((pvAddress), (uiSize))
+/* Event trace (trace.h): tasks by uxTCBNumber, queues, semaphores and
+   mutexes by address >> 2 */
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+#include "trace.h"
+#endif
+#define traceTASK_SWITCHED_IN()                 trace_put(TRACE_EV_TASK_IN, 0, (uint16_t)pxCurrentTCB->uxTCBNumber)
+#define traceQUEUE_SEND(pxQueue)                trace_put(TRACE_EV_QUEUE_SEND, 0, (uint16_t)((uint32_t)(pxQueue) >> 2))
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)       trace_put(TRACE_EV_QUEUE_SEND, 1, (uint16_t)((uint32_t)(pxQueue) >> 2))
+#define traceQUEUE_RECEIVE(pxQueue)             trace_put(TRACE_EV_QUEUE_RECV, 0, (uint16_t)((uint32_t)(pxQueue) >> 2))
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue)    trace_put(TRACE_EV_QUEUE_RECV, 1, (uint16_t)((uint32_t)(pxQueue) >> 2))
 /* USER CODE END Defines */
 
 #endif /* FREERTOS_CONFIG_H */
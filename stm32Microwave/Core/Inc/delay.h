@@ -38,6 +38,17 @@ void delay_us(uint32_t us);
  */
 void delay_ms(uint32_t ms);
 
+/**
+ * @brief  Read the DWT cycle counter (for timing measurements).
+ * @note   Returns 0 when delay_init() did not find a working DWT.
+ */
+uint32_t delay_cycles(void);
+
+/**
+ * @brief  Convert a DWT cycle delta into microseconds at the current clock.
+ */
+uint32_t delay_cycles_to_us(uint32_t cycles);
+
 #ifdef __cplusplus
 }
 #endif
@@ -13,7 +13,26 @@
 extern "C" {
 #endif
 
-// nothing special needed, included for clarity
+#include <stdint.h>
+
+/* TX ring size in bytes (power of two) */
+#ifndef RETARGET_TX_RING
+#define RETARGET_TX_RING 1024U
+#endif
+
+/* Queue raw bytes for USART2 without blocking. Safe from tasks and from
+ * ISRs (e.g. the TIM4 countdown) - unlike printf, which is not ISR-safe.
+ * Returns the number of bytes queued; the rest is dropped and counted. */
+int Retarget_Write(const void *buf, int len);
+
+/* From the 1 ms HAL tick: restart a transfer HAL_UART_Transmit_DMA refused */
+void Retarget_Poll(void);
+
+/* Free space in the ring */
+uint32_t Retarget_Room(void);
+
+/* Bytes dropped so far because the ring was full */
+uint32_t Retarget_Dropped(void);
 
 #ifdef __cplusplus
 }
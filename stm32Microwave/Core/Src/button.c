@@ -0,0 +1,74 @@
+#include "button.h"
+#include "main.h"
+#include "tim.h"
+#include "clock.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Key debouncing on EXTI masking + TIM7 one-shot, see button.h.
+*           EXTI1, EXTI15_10 and TIM7 share NVIC priority 6, so the edge
+*           and scan handlers never preempt each other.
+******************************************************/
+
+typedef struct {
+    GPIO_TypeDef *port;
+    uint16_t      pin;      /* also the EXTI line bit */
+} ButtonPin;
+
+static const ButtonPin k_pins[BTN_COUNT] = {
+    [BTN_MODE]   = { GPIOB, GPIO_PIN_1  },
+    [BTN_ACTION] = { GPIOB, GPIO_PIN_12 },
+};
+
+static btn_t      s_btn[BTN_COUNT];
+static ButtonSink s_sink = NULL;
+
+/* One BTN_SCAN_MS shot from now (OPM clears CEN) */
+static void scan_arm(void)
+{
+    if (htim7.Instance->CR1 & TIM_CR1_CEN) return;
+    __HAL_TIM_SET_AUTORELOAD(&htim7, BTN_SCAN_MS * (CLOCK_TIM_SCAN_HZ / 1000u) - 1u);
+    __HAL_TIM_SET_COUNTER(&htim7, 0);
+    __HAL_TIM_ENABLE(&htim7);
+}
+
+void Button_Init(ButtonSink sink)
+{
+    s_sink = sink;
+    for (uint8_t i = 0; i < BTN_COUNT; i++) s_btn[i].phase = BTN_IDLE;
+    __HAL_TIM_CLEAR_IT(&htim7, TIM_IT_UPDATE);      /* set by the init UG */
+    __HAL_TIM_ENABLE_IT(&htim7, TIM_IT_UPDATE);
+}
+
+void Button_Edge(uint16_t pin)
+{
+    for (uint8_t i = 0; i < BTN_COUNT; i++) {
+        if (k_pins[i].pin != pin) continue;
+        EXTI->IMR &= ~(uint32_t)pin;                /* no more bounce IRQs */
+        btn_edge(&s_btn[i]);
+        scan_arm();
+        return;
+    }
+}
+
+void Button_Tick(void)
+{
+    uint8_t busy = 0;
+
+    for (uint8_t i = 0; i < BTN_COUNT; i++) {
+        btn_t *b = &s_btn[i];
+        if (b->phase == BTN_IDLE) continue;
+
+        uint8_t level = (HAL_GPIO_ReadPin(k_pins[i].port, k_pins[i].pin) == GPIO_PIN_SET);
+        ButtonEvent ev = btn_scan(b, level);
+        if (ev != BTN_EV_NONE && s_sink) s_sink((ButtonId)i, ev);
+
+        if (b->phase == BTN_IDLE) {
+            __HAL_GPIO_EXTI_CLEAR_IT(k_pins[i].pin);    /* drop the release bounce */
+            EXTI->IMR |= k_pins[i].pin;
+        } else {
+            busy = 1;
+        }
+    }
+    if (busy) scan_arm();
+}
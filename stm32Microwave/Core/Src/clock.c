@@ -0,0 +1,196 @@
+#include "clock.h"
+#include "main.h"
+#include "tim.h"
+#include "spi.h"
+#include "usart.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Clock profiles and peripheral rescaling, see clock.h
+******************************************************/
+
+static ClockProfile s_profile = CLOCK_PROFILE_FULL;    /* SystemClock_Config */
+
+/* --- RCC ------------------------------------------------------------------ */
+
+/* PLL: HSI / 8 * 168 = 336 MHz VCO, / 2 = 168 MHz SYSCLK, / 7 = 48 MHz */
+#define PLL_M           8u
+#define PLL_N           168u
+#define PLL_P           2u
+#define PLL_Q           7u
+
+/* Longest wait for PLLRDY / SWS: 5 ms at 168 MHz (50 ms on HSI) */
+#define RCC_WAIT_CYCLES (168000000u / 1000u * 5u)
+
+/* The switch runs with interrupts off (Clock_SetProfile, STOP wake-up), so
+   the HAL tick that HAL_RCC_OscConfig / ClockConfig time out on does not
+   advance. The RCC is programmed here instead, and every wait is bounded
+   by the DWT cycle counter; the loop count bounds it as well in case the
+   counter does not run. */
+static uint8_t rcc_wait(volatile uint32_t *reg, uint32_t mask, uint32_t want)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t t0 = DWT->CYCCNT;
+    for (uint32_t n = 0; (*reg & mask) != want; n++)
+        if (DWT->CYCCNT - t0 > RCC_WAIT_CYCLES || n > RCC_WAIT_CYCLES) return 0;
+    return 1;
+}
+
+static uint8_t sysclk_switch(uint32_t sw)
+{
+    MODIFY_REG(RCC->CFGR, RCC_CFGR_SW, sw);
+    return rcc_wait(&RCC->CFGR, RCC_CFGR_SWS, sw << RCC_CFGR_SWS_Pos);
+}
+
+static void flash_latency(uint32_t ws)
+{
+    MODIFY_REG(FLASH->ACR, FLASH_ACR_LATENCY, ws);
+    (void)FLASH->ACR;                                   /* takes effect on read-back */
+}
+
+static uint8_t rcc_config(ClockProfile p)
+{
+    uint8_t ok;
+
+    RCC->CR |= RCC_CR_HSION;
+    if (!rcc_wait(&RCC->CR, RCC_CR_HSIRDY, RCC_CR_HSIRDY)) return 0;
+
+    if (p == CLOCK_PROFILE_FULL) {
+        if ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL) {
+            RCC->CR &= ~RCC_CR_PLLON;
+            if (!rcc_wait(&RCC->CR, RCC_CR_PLLRDY, 0)) return 0;
+            RCC->PLLCFGR = RCC_PLLCFGR_PLLSRC_HSI | PLL_M |
+                           (PLL_N << RCC_PLLCFGR_PLLN_Pos) |
+                           ((PLL_P / 2u - 1u) << RCC_PLLCFGR_PLLP_Pos) |
+                           (PLL_Q << RCC_PLLCFGR_PLLQ_Pos);
+            RCC->CR |= RCC_CR_PLLON;
+            if (!rcc_wait(&RCC->CR, RCC_CR_PLLRDY, RCC_CR_PLLRDY)) return 0;
+        }
+
+        /* wait states up before the clock, APB prescalers before the switch */
+        flash_latency(FLASH_LATENCY_5);
+        MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2,
+                   RCC_SYSCLK_DIV1 | RCC_HCLK_DIV4 | (RCC_HCLK_DIV2 << 3));
+        ok = sysclk_switch(RCC_CFGR_SW_PLL);
+    } else {
+        /* leave the PLL only once nothing runs from it */
+        ok = sysclk_switch(RCC_CFGR_SW_HSI);
+        if (ok) {
+            MODIFY_REG(RCC->CFGR, RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2,
+                       RCC_SYSCLK_DIV1 | RCC_HCLK_DIV1 | (RCC_HCLK_DIV1 << 3));
+            flash_latency(FLASH_LATENCY_0);
+            RCC->CR &= ~RCC_CR_PLLON;
+            ok = rcc_wait(&RCC->CR, RCC_CR_PLLRDY, 0);
+        }
+    }
+
+    SystemCoreClockUpdate();
+    HAL_InitTick(uwTickPrio);
+    return ok;
+}
+
+/* --- peripherals ---------------------------------------------------------- */
+
+static uint32_t apb1_timer_hz(void)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    return ((RCC->CFGR & RCC_CFGR_PPRE1) == RCC_HCLK_DIV1) ? pclk : 2u * pclk;
+}
+
+/* New prescaler right away. UG loads it and clears the counter, so the
+   count is put back; URS keeps UG from raising an update interrupt and
+   CR1 is restored because UG also ends a one-pulse run. */
+static void tim_rescale(TIM_HandleTypeDef *h, uint32_t hz)
+{
+    TIM_TypeDef *t = h->Instance;
+    uint32_t cr1 = t->CR1;
+    uint32_t cnt = t->CNT;
+
+    h->Init.Prescaler = apb1_timer_hz() / hz - 1u;
+    t->CR1 = cr1 | TIM_CR1_URS;
+    t->PSC = h->Init.Prescaler;
+    t->EGR = TIM_EGR_UG;
+    t->CNT = cnt;
+    t->CR1 = cr1;
+}
+
+/* Fastest PCLK2 / 2^(br+1) within the panel limit (SPI1 idle) */
+static void spi_rescale(void)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK2Freq();
+    uint32_t br = 0;
+    while (br < 7u && (pclk >> (br + 1u)) > CLOCK_LCD_SPI_MAX_HZ) br++;
+
+    uint32_t cr1 = hspi1.Instance->CR1;
+    hspi1.Init.BaudRatePrescaler = br << SPI_CR1_BR_Pos;
+    hspi1.Instance->CR1 = cr1 & ~SPI_CR1_SPE;
+    hspi1.Instance->CR1 = (cr1 & ~(SPI_CR1_SPE | SPI_CR1_BR)) | hspi1.Init.BaudRatePrescaler;
+    hspi1.Instance->CR1 |= cr1 & SPI_CR1_SPE;
+}
+
+static void rescale(void)
+{
+    tim_rescale(&htim2, CLOCK_TIM_SERVO_HZ);
+    tim_rescale(&htim3, CLOCK_TIM_PWM_HZ);
+    tim_rescale(&htim4, CLOCK_TIM_COUNTDOWN_HZ);
+    tim_rescale(&htim7, CLOCK_TIM_SCAN_HZ);
+    spi_rescale();
+    huart2.Instance->BRR = UART_BRR_SAMPLING16(HAL_RCC_GetPCLK1Freq(), huart2.Init.BaudRate);
+
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+        SysTick->LOAD = SystemCoreClock / configTICK_RATE_HZ - 1u;
+        SysTick->VAL  = 0;
+    }
+}
+
+static uint8_t apply(ClockProfile p)
+{
+    uint8_t ok = rcc_config(p);     /* also re-inits the HAL tick */
+    if (ok) s_profile = p;
+    __HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+    __HAL_FLASH_INSTRUCTION_CACHE_ENABLE();
+    __HAL_FLASH_DATA_CACHE_ENABLE();
+    rescale();                      /* to whatever the RCC ended up with */
+    return ok;
+}
+
+/* --- API ------------------------------------------------------------------ */
+
+void Clock_Init(void)
+{
+    if (MW_CLOCK_PROFILE != s_profile) apply(MW_CLOCK_PROFILE);
+}
+
+uint8_t Clock_SetProfile(ClockProfile p)
+{
+    uint8_t ok;
+    if (p == s_profile) return 1;
+
+    /* the SPI and UART dividers may only change between transfers; the
+       switch itself runs with interrupts off (bounded waits, rcc_config) */
+    for (;;) {
+        __disable_irq();
+        if (hspi1.State == HAL_SPI_STATE_READY && huart2.gState == HAL_UART_STATE_READY &&
+            (huart2.Instance->SR & USART_SR_TC))
+            break;
+        __enable_irq();
+        vTaskDelay(1);
+    }
+    ok = apply(p);
+    __enable_irq();
+    return ok;
+}
+
+ClockProfile Clock_Profile(void)
+{
+    return s_profile;
+}
+
+void Clock_Restore(void)
+{
+    if (s_profile == CLOCK_PROFILE_FULL) rcc_config(CLOCK_PROFILE_FULL);
+}
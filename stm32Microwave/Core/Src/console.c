@@ -1,60 +1,205 @@
 #include "console.h"
 #include "gui.h"      // LCD_ShowChar, LCD_Width, LCD_Height, POINT_COLOR, BACK_COLOR
+#include "cmsis_os.h"
+#include "task.h"
+#include "rtos_mem.h"
 
 /* ===== Configuration ===== */
 #ifndef CONSOLE_TAB_SIZE
 #define CONSOLE_TAB_SIZE 4
 #endif
 
-/* If you cannot do pixel scrolling, simplest behavior is "clear page when full" */
-#ifndef CONSOLE_CLEAR_ON_FULL
-#define CONSOLE_CLEAR_ON_FULL 1
+/* Scroll with the panel's vertical scroll registers: a newline past the last
+   row clears one line and moves the scroll start, nothing else is redrawn. */
+#ifndef CONSOLE_HW_SCROLL
+#define CONSOLE_HW_SCROLL 1
+#endif
+
+/* Text grid capacity: 6x12 cells on a 160-wide screen need 26x13 */
+#ifndef CONSOLE_MAX_COLS
+#define CONSOLE_MAX_COLS 32
+#endif
+#ifndef CONSOLE_MAX_ROWS
+#define CONSOLE_MAX_ROWS 16
+#endif
+
+/* Render task: minimum time between two redraws (bounds the frame rate;
+   output arriving meanwhile is coalesced into the next one) */
+#ifndef CONSOLE_FRAME_MS
+#define CONSOLE_FRAME_MS 40
+#endif
+#ifndef CONSOLE_TASK_STACK
+#define CONSOLE_TASK_STACK (256 * 4)
 #endif
 
 /* ===== State ===== */
+typedef struct {
+    uint8_t  ch;
+    uint16_t fg, bg;
+} con_cell_t;
+
 static uint16_t scr_w = 0, scr_h = 0;      /* in pixels */
+static uint8_t  auto_size = 1;             /* follow LCD_Width/LCD_Height */
 static uint8_t  cell_w = 8, cell_h = 16;   /* font cell size (defaults to 8x16) */
 static uint16_t cols = 0, rows = 0;        /* text grid dimensions */
 static uint16_t cur_c = 0, cur_r = 0;      /* cursor in cells */
 static uint16_t fg_col = 0xFFFF, bg_col = 0x0000; /* white on black by default */
+static uint8_t  hw_scroll = 0;             /* scroll area programmed */
+static uint16_t top_line = 0;              /* ring slot shown on the first row */
+
+/* Backing store, indexed by ring slot (not screen row), plus per-slot dirty
+   column range (lo > hi: clean). Writers only touch RAM; the panel is
+   updated by Console_Flush(). */
+static con_cell_t grid[CONSOLE_MAX_ROWS][CONSOLE_MAX_COLS];
+static uint8_t    dirty_lo[CONSOLE_MAX_ROWS], dirty_hi[CONSOLE_MAX_ROWS];
+static uint8_t    scroll_dirty = 0;        /* top_line changed since last flush */
+static uint8_t    pending = 0;             /* anything to flush */
+static TaskHandle_t render_tid = NULL;
+
+/* printf may run in any task (or before the scheduler starts): guard grid
+   updates with PRIMASK, they are a handful of stores each */
+#define CON_LOCK()    uint32_t _pm = __get_PRIMASK(); __disable_irq()
+#define CON_UNLOCK()  __set_PRIMASK(_pm)
 
 /* ===== Internals ===== */
 static inline void _compute_grid(void)
 {
-    if (scr_w == 0) scr_w = LCD_Width();
-    if (scr_h == 0) scr_h = LCD_Height();
+    if (auto_size) { scr_w = LCD_Width(); scr_h = LCD_Height(); }
     if (cell_w == 0) cell_w = 8;
     if (cell_h == 0) cell_h = 16;
     cols = (uint16_t)(scr_w / cell_w);
     rows = (uint16_t)(scr_h / cell_h);
     if (cols == 0) cols = 1;
     if (rows == 0) rows = 1;
+    if (cols > CONSOLE_MAX_COLS) cols = CONSOLE_MAX_COLS;
+    if (rows > CONSOLE_MAX_ROWS) rows = CONSOLE_MAX_ROWS;
     if (cur_c >= cols) cur_c = 0;
     if (cur_r >= rows) cur_r = (uint16_t)(rows - 1);
 }
 
+/* Screen row -> ring slot. With hardware scroll the slots are fixed bands of
+   panel memory and top_line is the slot currently shown first. */
+static inline uint16_t _slot(uint16_t r)
+{
+    return (uint16_t)((top_line + r) % rows);
+}
+
+/* Grid rows scroll, the leftover pixel rows below them stay fixed */
+static void _setup_scroll(void)
+{
+    hw_scroll = 0;
+#if CONSOLE_HW_SCROLL
+    if (scr_h == LCD_Height())
+        hw_scroll = LCD_SetScrollArea(0, (uint16_t)(scr_h - rows * cell_h));
+#endif
+}
+
+/* Callers hold the lock */
+static inline void _mark(uint16_t s, uint16_t c0, uint16_t c1)
+{
+    if (dirty_lo[s] > c0) dirty_lo[s] = (uint8_t)c0;
+    if (dirty_hi[s] < c1 || dirty_lo[s] > dirty_hi[s]) dirty_hi[s] = (uint8_t)c1;
+    pending = 1;
+}
+
+static void _blank_slot(uint16_t s)
+{
+    for (uint16_t c = 0; c < cols; c++) {
+        grid[s][c].ch = ' ';
+        grid[s][c].fg = fg_col;
+        grid[s][c].bg = bg_col;
+    }
+    _mark(s, 0, (uint16_t)(cols - 1));
+}
+
+static void _blank_all(void)
+{
+    for (uint16_t s = 0; s < rows; s++) _blank_slot(s);
+    cur_c = 0;
+    cur_r = 0;
+    if (top_line != 0) { top_line = 0; scroll_dirty = 1; }
+}
+
 static void _new_line(void)
 {
     cur_c = 0;
     cur_r++;
-#if CONSOLE_CLEAR_ON_FULL
-    if (cur_r >= rows) {
-        Console_Clear();     /* simplest behavior */
+    if (cur_r < rows) return;
+
+    if (hw_scroll) {
+        /* the oldest line becomes the new bottom one: blank it, then
+           move the scroll start past it */
+        _blank_slot(_slot(0));
+        top_line = (uint16_t)((top_line + 1) % rows);
+        scroll_dirty = 1;
+        cur_r = (uint16_t)(rows - 1);
+        return;
     }
-#else
-    if (cur_r >= rows) {
-        /* TODO: implement real scrolling if your LCD has a hardware scroll register.
-           For now, fall back to page clear: */
-        Console_Clear();
+    /* without hardware scrolling (disabled, or rotation 1/3 where the
+       panel scrolls sideways) the page is cleared when full */
+    _blank_all();
+}
+
+static void _put_cell(uint16_t c, uint16_t r, uint8_t ch)
+{
+    uint16_t s = _slot(r);
+    con_cell_t *cell = &grid[s][c];
+    if (cell->ch == ch && cell->fg == fg_col && cell->bg == bg_col) return;
+    cell->ch = ch;
+    cell->fg = fg_col;
+    cell->bg = bg_col;
+    _mark(s, c, c);
+}
+
+/* Wake the render task (task notification: the CMSIS thread flags are
+   disabled in this configuration), or draw right away if there is none yet */
+static void _wake(void)
+{
+    if (__get_IPSR() != 0U) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(render_tid, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        xTaskNotifyGive(render_tid);
     }
-#endif
 }
 
-static void _draw_char_cell(uint16_t c, uint16_t r, uint8_t ch)
+static void _kick(void)
 {
-    uint16_t x = (uint16_t)(c * cell_w);
-    uint16_t y = (uint16_t)(r * cell_h);
-    LCD_ShowChar(x, y, fg_col, bg_col, ch, cell_h, 0);  /* size == cell_h (16 now), opaque mode */
+    if (!pending) return;
+    if (render_tid) _wake();
+    else            Console_Flush();
+}
+
+/* Draw one slot's dirty run: runs of blanks with one background become a
+   single rectangle fill, everything else goes through the glyph blitter */
+static void _draw_run(uint16_t s, const con_cell_t *cells, uint16_t c0, uint16_t n)
+{
+    uint16_t y = (uint16_t)(s * cell_h);
+    uint16_t i = 0;
+    while (i < n) {
+        if (cells[i].ch == ' ') {
+            uint16_t j = (uint16_t)(i + 1);
+            while (j < n && cells[j].ch == ' ' && cells[j].bg == cells[i].bg) j++;
+            LCD_FillRect((uint16_t)((c0 + i) * cell_w), y,
+                         (uint16_t)((j - i) * cell_w), cell_h, cells[i].bg);
+            i = j;
+        } else {
+            LCD_ShowChar((uint16_t)((c0 + i) * cell_w), y, cells[i].fg, cells[i].bg,
+                         cells[i].ch, cell_h, 0);  /* size == cell_h, opaque mode */
+            i++;
+        }
+    }
+}
+
+static void _render_task(void *argument)
+{
+    (void)argument;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        Console_Flush();
+        osDelay(CONSOLE_FRAME_MS);
+    }
 }
 
 /* ===== Public API ===== */
@@ -64,19 +209,38 @@ void Console_SetFontCell(uint8_t cw, uint8_t ch)
     cell_w = (cw == 0) ? 8 : cw;
     cell_h = (ch == 0) ? 16 : ch;
     _compute_grid();
+    _setup_scroll();
+    Console_Clear();
 }
 
 void Console_Init(uint16_t width_px, uint16_t height_px)
 {
+    auto_size = (width_px == 0 || height_px == 0);
     scr_w = width_px;
     scr_h = height_px;
     /* default colors follow GUI globals initially */
     fg_col = POINT_COLOR;
     bg_col = BACK_COLOR;
     _compute_grid();
+    _setup_scroll();
     Console_Clear();
 }
 
+void Console_StartRenderTask(void)
+{
+    static StaticTask_t tcb;
+    RTOS_STACK(stack, CONSOLE_TASK_STACK);
+    static const osThreadAttr_t attr = {
+        .name = "console",
+        .cb_mem = &tcb, .cb_size = sizeof(tcb),
+        .stack_mem = stack, .stack_size = sizeof(stack),
+        .priority = (osPriority_t) RTOS_PRIO(osPriorityLow),
+    };
+    if (render_tid) return;
+    render_tid = (TaskHandle_t)osThreadNew(_render_task, NULL, &attr);
+    if (render_tid && pending) _wake();
+}
+
 void Console_SetColors(uint16_t fg, uint16_t bg)
 {
     fg_col = fg; bg_col = bg;
@@ -90,7 +254,6 @@ void Console_GetColors(uint16_t *fg, uint16_t *bg)
 
 void Console_SetCursor(uint16_t col, uint16_t row)
 {
-    _compute_grid();
     if (col >= cols) col = (uint16_t)(cols - 1);
     if (row >= rows) row = (uint16_t)(rows - 1);
     cur_c = col; cur_r = row;
@@ -104,36 +267,103 @@ void Console_GetCursor(uint16_t *col, uint16_t *row)
 
 void Console_Clear(void)
 {
-    /* Fill the whole screen with background color and home the cursor */
-    uint16_t old_pc = POINT_COLOR, old_bc = BACK_COLOR;
+    /* Blank the whole grid with the background color and home the cursor */
+    CON_LOCK();
+    _blank_all();
+    CON_UNLOCK();
+    _kick();
+}
 
-    POINT_COLOR = bg_col;
-    BACK_COLOR  = bg_col;
-    LCD_DrawFillRectangle(0, 0, (uint16_t)(scr_w - 1), (uint16_t)(scr_h - 1));
+void Console_Flush(void)
+{
+    con_cell_t run[CONSOLE_MAX_COLS];
 
-    POINT_COLOR = old_pc;
-    BACK_COLOR  = old_bc;
+    for (uint16_t s = 0; s < rows; s++) {
+        uint16_t c0, n;
+        CON_LOCK();
+        if (dirty_lo[s] > dirty_hi[s]) { CON_UNLOCK(); continue; }
+        c0 = dirty_lo[s];
+        n  = (uint16_t)(dirty_hi[s] - c0 + 1);
+        for (uint16_t i = 0; i < n; i++) run[i] = grid[s][c0 + i];
+        dirty_lo[s] = 0xFF; dirty_hi[s] = 0;
+        CON_UNLOCK();
+        _draw_run(s, run, c0, n);
+    }
 
-    cur_c = 0;
-    cur_r = 0;
+    uint16_t top;
+    uint8_t  move;
+    CON_LOCK();
+    move = scroll_dirty;
+    top  = top_line;
+    scroll_dirty = 0;
+    pending = 0;
+    for (uint16_t s = 0; s < rows; s++)
+        if (dirty_lo[s] <= dirty_hi[s]) pending = 1;   /* written meanwhile */
+    CON_UNLOCK();
+    /* only after the exposed line has been blanked */
+    if (move && hw_scroll) LCD_SetScrollStart((uint16_t)(top * cell_h));
+    LCD_Flush();
+}
+
+void Console_Refresh(void)
+{
+    uint16_t old_rows = rows;
+
+    CON_LOCK();
+    /* unroll the ring so screen row r sits in slot r again */
+    while (top_line) {
+        con_cell_t tmp[CONSOLE_MAX_COLS];
+        for (uint16_t c = 0; c < CONSOLE_MAX_COLS; c++) tmp[c] = grid[0][c];
+        for (uint16_t s = 1; s < old_rows; s++)
+            for (uint16_t c = 0; c < CONSOLE_MAX_COLS; c++) grid[s - 1][c] = grid[s][c];
+        for (uint16_t c = 0; c < CONSOLE_MAX_COLS; c++) grid[old_rows - 1][c] = tmp[c];
+        top_line--;
+    }
+
+    uint16_t cc = cur_c, cr = cur_r;
+    _compute_grid();
+
+    /* fewer rows now: keep the most recent lines */
+    if (cr >= rows) {
+        uint16_t shift = (uint16_t)(cr - (rows - 1));
+        for (uint16_t s = 0; s < rows; s++)
+            for (uint16_t c = 0; c < CONSOLE_MAX_COLS; c++) grid[s][c] = grid[s + shift][c];
+        cr = (uint16_t)(rows - 1);
+    }
+    /* more rows or cols now: blank what was never written */
+    for (uint16_t s = 0; s < rows; s++) {
+        for (uint16_t c = 0; c < cols; c++) {
+            if (s < old_rows && grid[s][c].ch) continue;
+            grid[s][c].ch = ' ';
+            grid[s][c].fg = fg_col;
+            grid[s][c].bg = bg_col;
+        }
+        _mark(s, 0, (uint16_t)(cols - 1));
+    }
+    cur_c = (cc < cols) ? cc : 0;
+    cur_r = cr;
+    scroll_dirty = 0;
+    CON_UNLOCK();
+
+    /* the margins outside the grid are never redrawn from it */
+    LCD_FillRect((uint16_t)(cols * cell_w), 0, scr_w, scr_h, bg_col);
+    LCD_FillRect(0, (uint16_t)(rows * cell_h), scr_w, scr_h, bg_col);
+    _setup_scroll();
+    _kick();
 }
 
 /* Returns the character written (standard putchar contract) */
 int Console_PutChar(int ch)
 {
-    _compute_grid();
+    CON_LOCK();
 
     if (ch == '\r') {
         /* CR: go to column 0, same row */
         cur_c = 0;
-        return ch;
-    }
-    if (ch == '\n') {
+    } else if (ch == '\n') {
         /* LF: new line */
         _new_line();
-        return ch;
-    }
-    if (ch == '\t') {
+    } else if (ch == '\t') {
         /* TAB: advance to next tab stop */
         uint16_t next = (uint16_t)(((cur_c / CONSOLE_TAB_SIZE) + 1) * CONSOLE_TAB_SIZE);
         if (next >= cols) {
@@ -141,35 +371,25 @@ int Console_PutChar(int ch)
         } else {
             /* paint spaces until next tab stop */
             while (cur_c < next) {
-                _draw_char_cell(cur_c, cur_r, ' ');
+                _put_cell(cur_c, cur_r, ' ');
                 cur_c++;
             }
         }
-        return ch;
-    }
-    if (ch == '\b') {
+    } else if (ch == '\b') {
         /* backspace: move back and overwrite with space */
         if (cur_c > 0) {
             cur_c--;
-            _draw_char_cell(cur_c, cur_r, ' ');
+            _put_cell(cur_c, cur_r, ' ');
         }
-        return ch;
-    }
-
-    /* Printable range: draw */
-    if (ch >= 32 && ch <= 126) {
-        _draw_char_cell(cur_c, cur_r, (uint8_t)ch);
+    } else {
+        /* Printable range as is, anything else as placeholder (.) */
+        _put_cell(cur_c, cur_r, (ch >= 32 && ch <= 126) ? (uint8_t)ch : '.');
         cur_c++;
-        if (cur_c >= cols) {
-            _new_line();
-        }
-        return ch;
+        if (cur_c >= cols) _new_line();
     }
 
-    /* Non-printable: show as placeholder (.) */
-    _draw_char_cell(cur_c, cur_r, '.');
-    cur_c++;
-    if (cur_c >= cols) _new_line();
+    CON_UNLOCK();
+    _kick();
     return ch;
 }
 
@@ -193,6 +413,3 @@ int putchar(int ch)
 {
     return Console_PutChar(ch);
 }
-
-
-
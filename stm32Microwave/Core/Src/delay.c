@@ -11,7 +11,6 @@
 
 /* Internal state */
 static uint8_t  s_dwt_ok = 0;
-static uint32_t s_cycles_per_us = 0;
 
 /* ---------- DWT backend ---------- */
 
@@ -31,7 +30,6 @@ static uint8_t dwt_try_init(void)
 
     if (after != before)
     {
-        s_cycles_per_us = SystemCoreClock / 1000000U;
         return 1;
     }
     return 0;
@@ -71,7 +69,7 @@ void delay_us(uint32_t us)
     if (s_dwt_ok)
     {
         const uint32_t start  = DWT->CYCCNT;
-        const uint32_t target = s_cycles_per_us * us;
+        const uint32_t target = (SystemCoreClock / 1000000U) * us;  /* clock.c may switch it */
         while ((DWT->CYCCNT - start) < target) { __NOP(); }
     }
     else
@@ -96,3 +94,14 @@ void delay_ms(uint32_t ms)
         HAL_Delay(ms);
     }
 }
+
+uint32_t delay_cycles(void)
+{
+    return s_dwt_ok ? DWT->CYCCNT : 0U;
+}
+
+uint32_t delay_cycles_to_us(uint32_t cycles)
+{
+    const uint32_t per_us = SystemCoreClock / 1000000U;
+    return (per_us != 0U) ? (cycles / per_us) : 0U;
+}
@@ -25,6 +25,18 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "micro_wave_oven.h"
+#include "uart_cmd.h"
+#include "mw_ctrl.h"
+#include "heater_pid.h"
+#include "rtos_mem.h"
+#include "prof.h"
+
+/* RTOS_PRIO (FreeRTOSConfig.h) relies on the relaxed priority checks */
+#include "freertos_os2.h"
+#ifndef FREERTOS_OS2_PRIO_PATCH
+#error "freertos_os2.h is the stock copy: re-apply tools/freertos_os2_prio.patch (patch -p1, in stm32Microwave/)"
+#endif
 
 /* USER CODE END Includes */
 
@@ -45,25 +57,57 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN Variables */
-
-/* USER CODE END Variables */
-/* Definitions for defaultTask */
-osThreadId_t defaultTaskHandle;
-const osThreadAttr_t defaultTask_attributes = {
-  .name = "defaultTask",
-  .stack_size = 128 * 4,
-  .priority = (osPriority_t) osPriorityNormal,
+/* mwCtrlTask is created here, not from the .ioc: CubeMX would generate it
+   at the unfolded CMSIS level, which FreeRTOS clamps (RTOS_PRIO) */
+osThreadId_t mwCtrlTaskHandle;
+uint32_t mwCtrlTaskBuffer[ 256 ];
+StaticTask_t mwCtrlTaskControlBlock;
+const osThreadAttr_t mwCtrlTask_attributes = {
+  .name = "mwCtrlTask",
+  .cb_mem = &mwCtrlTaskControlBlock,
+  .cb_size = sizeof(mwCtrlTaskControlBlock),
+  .stack_mem = &mwCtrlTaskBuffer[0],
+  .stack_size = sizeof(mwCtrlTaskBuffer),
+  .priority = (osPriority_t) RTOS_PRIO(osPriorityAboveNormal),
 };
+/* USER CODE END Variables */
 
 /* Private function prototypes -----------------------------------------------*/
 /* USER CODE BEGIN FunctionPrototypes */
-
+void StartMwCtrlTask(void *argument);
 /* USER CODE END FunctionPrototypes */
 
-void StartDefaultTask(void *argument);
-
 void MX_FREERTOS_Init(void); /* (MISRA C 2004 rule 8.1) */
 
+/* Functions needed when configGENERATE_RUN_TIME_STATS is on */
+void configureTimerForRunTimeStats(void);
+unsigned long getRunTimeCounterValue(void);
+
+/* Hook prototypes */
+void vApplicationMallocFailedHook(void);
+
+/* USER CODE BEGIN 1 */
+/* Functions needed when configGENERATE_RUN_TIME_STATS is on: DWT cycles,
+   see prof.h */
+void configureTimerForRunTimeStats(void)
+{
+  Prof_Init();
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+  return Prof_RunTime();
+}
+/* USER CODE END 1 */
+
+/* USER CODE BEGIN 5 */
+void vApplicationMallocFailedHook(void)
+{
+  /* heap_4 ran out: the heap only serves start-up code (rtos_mem.h) */
+  configASSERT(0);
+}
+/* USER CODE END 5 */
+
 /**
   * @brief  FreeRTOS initialization
   * @param  None
@@ -88,14 +132,16 @@ void MX_FREERTOS_Init(void) {
 
   /* USER CODE BEGIN RTOS_QUEUES */
   /* add queues, ... */
+  MwCtrl_Init(&mw1);
   /* USER CODE END RTOS_QUEUES */
 
-  /* Create the thread(s) */
-  /* creation of defaultTask */
-  defaultTaskHandle = osThreadNew(StartDefaultTask, NULL, &defaultTask_attributes);
-
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
+  mwCtrlTaskHandle = osThreadNew(StartMwCtrlTask, NULL, &mwCtrlTask_attributes);
+  UartCmd_Start(&mw1);
+#if MW_HEATER_PID
+  HeaterPid_Init();
+#endif
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_EVENTS */
@@ -104,26 +150,48 @@ void MX_FREERTOS_Init(void) {
 
 }
 
-/* USER CODE BEGIN Header_StartDefaultTask */
+/* Private application code --------------------------------------------------*/
+/* USER CODE BEGIN Application */
 /**
-  * @brief  Function implementing the defaultTask thread.
+  * @brief  Function implementing the mwCtrlTask thread: the oven controller,
+  *         blocked on its event queue until a key, tick or command arrives.
   * @param  argument: Not used
   * @retval None
   */
-/* USER CODE END Header_StartDefaultTask */
-void StartDefaultTask(void *argument)
+void StartMwCtrlTask(void *argument)
 {
-  /* USER CODE BEGIN StartDefaultTask */
-  /* Infinite loop */
-  for(;;)
-  {
-    osDelay(1);
-  }
-  /* USER CODE END StartDefaultTask */
+  MwCtrl_Run();
 }
 
-/* Private application code --------------------------------------------------*/
-/* USER CODE BEGIN Application */
+/* Idle and timer task memory; replaces the weak versions in cmsis_os2.c */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize)
+{
+  static StaticTask_t tcb;
+  RTOS_STACK(stack, configMINIMAL_STACK_SIZE * sizeof(StackType_t));
+  *ppxIdleTaskTCBBuffer   = &tcb;
+  *ppxIdleTaskStackBuffer = stack;
+  *pulIdleTaskStackSize   = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer, StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize)
+{
+  static StaticTask_t tcb;
+  RTOS_STACK(stack, configTIMER_TASK_STACK_DEPTH * sizeof(StackType_t));
+  *ppxTimerTaskTCBBuffer   = &tcb;
+  *ppxTimerTaskStackBuffer = stack;
+  *pulTimerTaskStackSize   = configTIMER_TASK_STACK_DEPTH;
+}
+
+/* traceMALLOC, inside pvPortMalloc: nothing may allocate once the
+   scheduler runs */
+void RtosMem_MallocTrace(void *pv, size_t size)
+{
+  (void)pv;
+  (void)size;
+  configASSERT(xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED);
+}
 
 /* USER CODE END Application */
 
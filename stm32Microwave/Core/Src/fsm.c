@@ -0,0 +1,88 @@
+#include "fsm.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Hierarchical state machine engine, see fsm.h
+******************************************************/
+
+static inline uint8_t parent_of(const fsm_def_t *d, uint8_t s)
+{
+    return d->states[s].parent;
+}
+
+/* `a` is a strict ancestor of `s` */
+static uint8_t is_ancestor(const fsm_def_t *d, uint8_t a, uint8_t s)
+{
+    for (s = parent_of(d, s); s != FSM_NONE; s = parent_of(d, s))
+        if (s == a) return 1;
+    return 0;
+}
+
+static void enter_initial(fsm_t *f, uint8_t s, uint16_t arg)
+{
+    const fsm_def_t *d = f->def;
+    while (d->states[s].initial != FSM_NONE) {
+        s = d->states[s].initial;
+        if (d->states[s].entry) d->states[s].entry(f->ctx, arg);
+    }
+    f->cur = s;
+}
+
+/* `src` is the state whose cell fired: cur itself or one of its ancestors */
+static void transition(fsm_t *f, uint8_t src, const fsm_trans_t *t, uint16_t arg)
+{
+    const fsm_def_t *d = f->def;
+    uint8_t to = t->target;
+
+    /* Least common ancestor; a self-transition leaves and re-enters src */
+    uint8_t lca = src;
+    while (lca != FSM_NONE && !is_ancestor(d, lca, to))
+        lca = parent_of(d, lca);
+
+    for (uint8_t s = f->cur; s != lca; s = parent_of(d, s))
+        if (d->states[s].exit) d->states[s].exit(f->ctx, arg);
+
+    if (t->action) t->action(f->ctx, arg);
+
+    uint8_t path[FSM_MAX_DEPTH], n = 0;
+    for (uint8_t s = to; s != lca && n < FSM_MAX_DEPTH; s = parent_of(d, s))
+        path[n++] = s;
+    while (n--)
+        if (d->states[path[n]].entry) d->states[path[n]].entry(f->ctx, arg);
+
+    enter_initial(f, to, arg);
+}
+
+void fsm_init(fsm_t *f, const fsm_def_t *def, uint8_t initial, void *ctx)
+{
+    f->def = def;
+    f->ctx = ctx;
+    while (def->states[initial].initial != FSM_NONE)
+        initial = def->states[initial].initial;
+    f->cur = initial;
+}
+
+uint8_t fsm_dispatch(fsm_t *f, uint8_t ev, uint16_t arg)
+{
+    const fsm_def_t *d = f->def;
+    if (ev >= d->n_events) return 0;
+
+    for (uint8_t s = f->cur; s != FSM_NONE; s = parent_of(d, s)) {
+        const fsm_trans_t *t = &d->table[(uint16_t)s * d->n_events + ev];
+        if (t->kind == FSM_UNHANDLED) continue;
+        if (t->guard && !t->guard(f->ctx, arg)) continue;
+
+        if (t->kind == FSM_INTERNAL) {
+            if (t->action) t->action(f->ctx, arg);
+        } else {
+            transition(f, s, t, arg);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+uint8_t fsm_in(const fsm_t *f, uint8_t s)
+{
+    return (f->cur == s) || is_ancestor(f->def, s, f->cur);
+}
@@ -168,6 +168,61 @@ static uint32_t mypow10(uint8_t n)
     return r;
 }
 
+/* ===== Glyph blitter =====
+ * 1bpp masks (MSB-left rows, `stride` bytes per row) are expanded into an
+ * RGB565 band buffer and pushed with one LCD_DrawImage565 per band, i.e.
+ * one address window + one data burst for a whole 8x16 cell instead of one
+ * window per pixel. Transparent glyphs start the band from what is already
+ * on screen (LCD_ReadImage565, framebuffer builds) and overlay the set bits;
+ * without a shadow to read they draw each row's runs of set bits as H-lines.
+ */
+#define GLYPH_BAND_PIXELS 256u           /* 8x16 / 16x16 in one band */
+static uint16_t s_glyph_band[GLYPH_BAND_PIXELS];
+
+static inline uint8_t _mask_bit(const uint8_t *row, uint16_t col)
+{
+    return (uint8_t)(row[col >> 3] & (uint8_t)(0x80u >> (col & 7u)));
+}
+
+static void _blit_mask(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc,
+                       const uint8_t *msk, uint8_t stride,
+                       uint16_t w, uint16_t h, uint8_t mode)
+{
+    if (x >= LCD_Width() || y >= LCD_Height()) return;
+    if ((uint16_t)(x + w) > LCD_Width())  w = (uint16_t)(LCD_Width() - x);
+    if ((uint16_t)(y + h) > LCD_Height()) h = (uint16_t)(LCD_Height() - y);
+
+    uint16_t band = (uint16_t)(GLYPH_BAND_PIXELS / w);
+    for (uint16_t row0 = 0; row0 < h; row0 = (uint16_t)(row0 + band)) {
+        uint16_t rows = (uint16_t)((h - row0 < band) ? (h - row0) : band);
+
+        if (mode && !LCD_ReadImage565(x, (uint16_t)(y + row0), w, rows, s_glyph_band)) {
+            for (uint16_t r = 0; r < rows; r++) {
+                const uint8_t *bits = msk + (uint32_t)(row0 + r) * stride;
+                uint16_t col = 0;
+                while (col < w) {
+                    if (!_mask_bit(bits, col)) { col++; continue; }
+                    uint16_t start = col;
+                    while (col < w && _mask_bit(bits, col)) col++;
+                    LCD_DrawFastHLine((uint16_t)(x + start), (uint16_t)(y + row0 + r),
+                                      (uint16_t)(col - start), fc);
+                }
+            }
+            continue;
+        }
+
+        uint16_t *p = s_glyph_band;
+        for (uint16_t r = 0; r < rows; r++) {
+            const uint8_t *bits = msk + (uint32_t)(row0 + r) * stride;
+            for (uint16_t col = 0; col < w; col++, p++) {
+                if (_mask_bit(bits, col)) *p = fc;
+                else if (!mode)           *p = bc;
+            }
+        }
+        LCD_DrawImage565(x, (uint16_t)(y + row0), w, rows, s_glyph_band);
+    }
+}
+
 /* ===== ASCII text =====
  * size: 12 -> use FONT_GetASCIIFont6x12 (6x12)
  *       16 -> use FONT_GetASCIIFont8x16 (8x16)
@@ -189,25 +244,8 @@ void LCD_ShowChar(uint16_t x, uint16_t y,
                           : FONT_GetASCIIFont8x16((char)ch);
     if (!rowptr) return;
 
-    /* quick reject if completely outside */
-    if (x >= LCD_Width() || y >= LCD_Height()) return;
-
-    /* per-pixel clipped draw (safe even near edges) */
-    for (uint8_t row = 0; row < h; row++) {
-        if ((uint16_t)(y + row) >= LCD_Height()) break;
-
-        uint8_t bits = rowptr[row];          /* MSB-left */
-        for (uint8_t col = 0; col < w; col++) {
-            if ((uint16_t)(x + col) >= LCD_Width()) break;
-
-            uint8_t mask = (uint8_t)(0x80u >> col);
-            if (bits & mask) {
-                LCD_DrawPixel((uint16_t)(x + col), (uint16_t)(y + row), fc);
-            } else if (!mode) {
-                LCD_DrawPixel((uint16_t)(x + col), (uint16_t)(y + row), bc);
-            }
-        }
-    }
+    /* clipped at the screen edges inside the blitter */
+    _blit_mask(x, y, fc, bc, rowptr, 1, w, h, mode);
 }
 
 void LCD_ShowString(uint16_t x,uint16_t y,uint8_t size,uint8_t *p,uint8_t mode)
@@ -271,22 +309,7 @@ static void _draw_cn_block(uint16_t x, uint16_t y,
                            uint8_t mode)
 {
     /* msk is row-major, 8 pixels per byte, high->low bits within byte */
-    uint32_t bi = 0;
-    for (uint16_t row = 0; row < h; row++) {
-        for (uint16_t colb = 0; colb < (uint16_t)(w/8); colb++) {
-            uint8_t b = (uint8_t)msk[bi++];
-            for (uint8_t k = 0; k < 8; k++) {
-                uint16_t xx = (uint16_t)(x + colb*8 + k);
-                uint16_t yy = (uint16_t)(y + row);
-                if (xx >= LCD_Width() || yy >= LCD_Height()) continue;
-                if (b & (uint8_t)(0x80u >> k)) {
-                    LCD_DrawPixel(xx, yy, fc);
-                } else if (!mode) {
-                    LCD_DrawPixel(xx, yy, bc);
-                }
-            }
-        }
-    }
+    _blit_mask(x, y, fc, bc, (const uint8_t*)msk, (uint8_t)(w/8), w, h, mode);
 }
 
 void GUI_DrawFont16(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, uint8_t *s,uint8_t mode)
@@ -434,6 +457,43 @@ void run_text_cn(void)
     Show_Str(8, 64, WHITE, DARKBLUE, (uint8_t*)"Define HAVE_TFONTxx", 16, 0);
 #endif
 }
+/* ===== Benchmarks ===== */
+#if LCD_ENABLE_BENCH
+#include <stdio.h>
+#include "delay.h"
+
+/* The pre-blitter LCD_ShowChar: one LCD_DrawPixel per glyph pixel */
+static void _show_char_per_pixel(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, uint8_t ch)
+{
+    const uint8_t *rowptr = FONT_GetASCIIFont8x16((char)ch);
+    if (!rowptr) return;
+    for (uint8_t row = 0; row < 16; row++) {
+        for (uint8_t col = 0; col < 8; col++) {
+            LCD_DrawPixel((uint16_t)(x + col), (uint16_t)(y + row),
+                          (rowptr[row] & (0x80u >> col)) ? fc : bc);
+        }
+    }
+}
+
+void GUI_BenchChar(uint16_t x, uint16_t y)
+{
+    uint32_t t0, t_pixel, t_blit;
+    delay_init();
+
+    t0 = delay_cycles();
+    _show_char_per_pixel(x, y, BLUE, WHITE, '8');
+    t_pixel = delay_cycles() - t0;
+
+    t0 = delay_cycles();
+    LCD_ShowChar(x, y, RED, WHITE, '8', 16, 0);
+    t_blit = delay_cycles() - t0;
+
+    printf("8x16 glyph: per-pixel %lu cyc, blitter %lu cyc (x%lu)\r\n",
+           (unsigned long)t_pixel, (unsigned long)t_blit,
+           (unsigned long)(t_blit ? t_pixel / t_blit : 0));
+}
+#endif
+
 //******************************************************test (can be deleted)
 void GUI_Test_First_CN16(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc, uint8_t mode)
 {
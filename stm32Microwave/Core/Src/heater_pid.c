@@ -0,0 +1,175 @@
+#include "heater_pid.h"
+#include "pid.h"
+#include "heater_sd.h"
+#include "kvs.h"
+#include "micro_wave_oven.h"
+#include "cmsis_os.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "rtos_mem.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Thermistor sampling + PID heater task, see heater_pid.h
+******************************************************/
+
+#if MW_HEATER_PID
+
+#define THERM_ADC_CH     11u            /* PC1 */
+#define THERM_RAW_MIN    16u            /* below: shorted */
+#define THERM_RAW_MAX    4080u          /* above: open */
+
+static volatile uint16_t s_adc[MW_THERM_SAMPLES];
+
+static pid_q16_t s_pid = {
+    .kp = MW_PID_KP, .ki = MW_PID_KI, .kd = MW_PID_KD,
+    .out_min = 0, .out_max = MW_HEATER_DUTY_MAX,
+    .i_min = -MW_PID_I_LIMIT, .i_max = MW_PID_I_LIMIT,
+    .slew = MW_PID_SLEW, .aw = MW_PID_ANTIWINDUP,
+};
+static volatile int16_t s_temp = INT16_MIN;
+static volatile int16_t s_cal;                  /* KVS_KEY_THERM_CAL */
+static int16_t          s_sp;
+static volatile uint8_t s_on;
+static osThreadId_t     s_task;
+
+/* 0.1 degC at raw = 128 * i, 10k/B3950 NTC under a 10k pull-up */
+static const int16_t k_ntc_dC[33] = {
+    2394, 1293, 1016,  866,  763,  685,  621,  567,  520,  477,  439,
+     403,  370,  338,  308,  278,  250,  222,  194,  167,  139,  111,
+      83,   53,   22,  -11,  -47,  -87, -132, -186, -256, -364, -629
+};
+
+static int16_t therm_read(void)
+{
+    uint32_t sum = 0;
+    for (uint32_t i = 0; i < MW_THERM_SAMPLES; i++) sum += s_adc[i];
+    uint32_t raw = sum / MW_THERM_SAMPLES;
+
+    if (raw < THERM_RAW_MIN || raw > THERM_RAW_MAX) return INT16_MIN;
+
+    uint32_t i = raw >> 7, frac = raw & 127u;
+    int32_t  a = k_ntc_dC[i], b = k_ntc_dC[i + 1];
+    return (int16_t)(a + ((b - a) * (int32_t)frac) / 128 + s_cal);
+}
+
+static void adc_dma_init(void)
+{
+    GPIO_InitTypeDef gpio = {0};
+
+    __HAL_RCC_GPIOC_CLK_ENABLE();
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    __HAL_RCC_ADC1_CLK_ENABLE();
+
+    gpio.Pin  = GPIO_PIN_1;
+    gpio.Mode = GPIO_MODE_ANALOG;
+    gpio.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(GPIOC, &gpio);
+
+    /* DMA2_Stream0 ch0: ADC1->DR -> s_adc, 16-bit, circular, no IRQ */
+    DMA2_Stream0->CR = 0;
+    while (DMA2_Stream0->CR & DMA_SxCR_EN) { }
+    DMA2->LIFCR  = DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 |
+                   DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0;
+    DMA2_Stream0->PAR  = (uint32_t)&ADC1->DR;
+    DMA2_Stream0->M0AR = (uint32_t)s_adc;
+    DMA2_Stream0->NDTR = MW_THERM_SAMPLES;
+    DMA2_Stream0->FCR  = 0;                              /* direct mode */
+    DMA2_Stream0->CR   = DMA_SxCR_PL_0 | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 |
+                         DMA_SxCR_MINC | DMA_SxCR_CIRC;  /* periph -> mem */
+    DMA2_Stream0->CR  |= DMA_SxCR_EN;
+
+    /* ADCCLK = PCLK2 / 4; 480-cycle samples, one channel, continuous */
+    ADC->CCR   = (ADC->CCR & ~ADC_CCR_ADCPRE) | ADC_CCR_ADCPRE_0;
+    ADC1->CR1  = 0;                                      /* 12-bit */
+    ADC1->SMPR1 = (ADC1->SMPR1 & ~ADC_SMPR1_SMP11) | ADC_SMPR1_SMP11;
+    ADC1->SQR1 = 0;                                      /* L = 1 */
+    ADC1->SQR3 = THERM_ADC_CH;
+    ADC1->CR2  = ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_CONT | ADC_CR2_ADON;
+    for (volatile uint32_t n = 0; n < 1000u; n++) { }    /* tSTAB */
+    ADC1->CR2 |= ADC_CR2_SWSTART;
+}
+
+static void heater_write(uint32_t duty)
+{
+    taskENTER_CRITICAL();
+#if MW_HEATER_SD
+    if (s_on) HeaterSd_Set((uint8_t)duty);
+#else
+    if (s_on) __HAL_TIM_SET_COMPARE(MW_HEATER_TIM, MW_HEATER_CH, duty);
+#endif
+    taskEXIT_CRITICAL();
+}
+
+static void heater_pid_task(void *argument)
+{
+    (void)argument;
+    TickType_t last = xTaskGetTickCount();
+
+    for (;;) {
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(MW_PID_PERIOD_MS));
+
+        int16_t t = therm_read();
+        s_temp = t;
+        if (!s_on) continue;
+
+        if (t == INT16_MIN) {                   /* sensor fault: fail off */
+            pid_reset(&s_pid, s_sp, 0);
+            heater_write(0);
+            continue;
+        }
+        heater_write((uint32_t)pid_step(&s_pid, s_sp, t));
+    }
+}
+
+void HeaterPid_Init(void)
+{
+    static StaticTask_t tcb;
+    RTOS_STACK(stack, 128 * 4);
+    static const osThreadAttr_t attr = {
+        .name = "heaterPid",
+        .cb_mem = &tcb, .cb_size = sizeof(tcb),
+        .stack_mem = stack, .stack_size = sizeof(stack),
+        .priority = (osPriority_t) RTOS_PRIO(osPriorityHigh),
+    };
+    int16_t cal;
+    if (s_task) return;
+    if (Kvs_Get(KVS_KEY_THERM_CAL, &cal, sizeof(cal)) == sizeof(cal)) s_cal = cal;
+    adc_dma_init();
+    s_task = osThreadNew(heater_pid_task, NULL, &attr);
+}
+
+void HeaterPid_Start(int16_t setpoint_dC)
+{
+    taskENTER_CRITICAL();
+    pid_reset(&s_pid, (s_temp == INT16_MIN) ? setpoint_dC : s_temp, 0);
+    s_sp = setpoint_dC;
+    s_on = 1;
+#if MW_HEATER_SD
+    HeaterSd_Start(0);
+#endif
+    taskEXIT_CRITICAL();
+}
+
+void HeaterPid_Stop(void)
+{
+    taskENTER_CRITICAL();
+    s_on = 0;
+#if MW_HEATER_SD
+    HeaterSd_Stop();
+#endif
+    __HAL_TIM_SET_COMPARE(MW_HEATER_TIM, MW_HEATER_CH, 0);
+    taskEXIT_CRITICAL();
+}
+
+void HeaterPid_SetCalibration(int16_t offset_dC)
+{
+    s_cal = offset_dC;
+}
+
+int16_t HeaterPid_Temperature(void)
+{
+    return s_temp;
+}
+
+#endif /* MW_HEATER_PID */
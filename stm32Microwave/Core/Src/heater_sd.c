@@ -0,0 +1,51 @@
+#include "heater_sd.h"
+#include "micro_wave_oven.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Burst-fire heater scheduling, see heater_sd.h
+******************************************************/
+
+#if MW_HEATER_SD
+
+static sd_mod_t         s_sd;
+static volatile uint8_t s_level;    /* written by tasks, latched per cycle */
+static uint8_t          s_div;
+
+void HeaterSd_Tick(void)
+{
+    if (++s_div < MW_SD_CYCLE_TICKS) return;
+    s_div = 0;
+    s_sd.level = s_level;
+    __HAL_TIM_SET_COMPARE(MW_HEATER_TIM, MW_HEATER_CH,
+                          sd_step(&s_sd) ? __HAL_TIM_GET_AUTORELOAD(MW_HEATER_TIM) + 1u : 0u);
+}
+
+void HeaterSd_Set(uint8_t pct)
+{
+    s_level = (pct > SD_FULL) ? SD_FULL : pct;
+}
+
+void HeaterSd_Start(uint8_t pct)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    HeaterSd_Set(pct);
+    s_sd.acc = 0;
+    s_div    = MW_SD_CYCLE_TICKS - 1u;          /* first decision on the next tick */
+    __HAL_TIM_CLEAR_IT(MW_HEATER_TIM,  TIM_IT_UPDATE);
+    __HAL_TIM_ENABLE_IT(MW_HEATER_TIM, TIM_IT_UPDATE);
+    __set_PRIMASK(primask);
+}
+
+void HeaterSd_Stop(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    __HAL_TIM_DISABLE_IT(MW_HEATER_TIM, TIM_IT_UPDATE);
+    s_level = 0;
+    __HAL_TIM_SET_COMPARE(MW_HEATER_TIM, MW_HEATER_CH, 0);
+    __set_PRIMASK(primask);
+}
+
+#endif /* MW_HEATER_SD */
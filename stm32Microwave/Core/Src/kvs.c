@@ -0,0 +1,218 @@
+#include <string.h>
+#include "kvs.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Flash key/value log, see kvs.h
+******************************************************/
+
+#define KVS_MAGIC       0x3153564Bu     /* "KVS1" */
+#define KVS_HDR_SIZE    8u
+#define ERASED          0xFFFFFFFFu
+#define PAD4(n)         (((uint32_t)(n) + 3u) & ~3u)
+#define REC_SPAN(len)   (4u + PAD4(len) + 4u)
+
+static const kvs_flash_t *s_fl;
+static uint8_t  s_act;                  /* active sector */
+static uint32_t s_seq;
+static uint32_t s_wr;                   /* next free offset in s_act */
+static uint32_t s_idx[KVS_MAX_KEYS];    /* offset of the latest record, 0 = none */
+
+/* --- CRC-32 (IEEE, reflected), 4 bits per step -------------------------- */
+static const uint32_t k_crc_nib[16] = {
+    0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu,
+    0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+    0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+    0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+};
+
+static uint32_t crc32_upd(uint32_t crc, const uint8_t *p, uint32_t n)
+{
+    while (n--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ k_crc_nib[crc & 15u];
+        crc = (crc >> 4) ^ k_crc_nib[crc & 15u];
+    }
+    return crc;
+}
+
+static uint32_t rec_crc(uint32_t hdr, const uint8_t *data, uint16_t len)
+{
+    uint32_t crc = crc32_upd(ERASED, (const uint8_t *)&hdr, 4u);
+    return ~crc32_upd(crc, data, len);
+}
+
+/* --- flash access -------------------------------------------------------- */
+
+static inline const uint8_t *at(uint8_t sec, uint32_t off)
+{
+    return (const uint8_t *)(s_fl->base[sec] + off);
+}
+
+static inline uint32_t rd32(uint8_t sec, uint32_t off)
+{
+    return *(const volatile uint32_t *)at(sec, off);
+}
+
+static uint8_t wr_bytes(uint8_t sec, uint32_t off, const uint8_t *src, uint16_t len)
+{
+    for (uint32_t i = 0; i < len; i += 4u) {
+        uint32_t w = ERASED;
+        memcpy(&w, src + i, (len - i < 4u) ? len - i : 4u);
+        if (!s_fl->program(s_fl->base[sec] + off + i, w)) return 0;
+    }
+    return 1;
+}
+
+static uint8_t wr_record(uint8_t sec, uint32_t off, uint16_t key, const uint8_t *data, uint16_t len)
+{
+    uint32_t hdr = ((uint32_t)len << 16) | key;
+    return s_fl->program(s_fl->base[sec] + off, hdr) &&
+           wr_bytes(sec, off + 4u, data, len) &&
+           s_fl->program(s_fl->base[sec] + off + 4u + PAD4(len), rec_crc(hdr, data, len));
+}
+
+/* --- log ----------------------------------------------------------------- */
+
+static uint8_t sector_valid(uint8_t sec)
+{
+    return rd32(sec, 0) == KVS_MAGIC;
+}
+
+/* Rebuild the index from sector `sec`. Returns 0 if the tail is unusable
+   (a torn header or leftovers past the last record). */
+static uint8_t scan(uint8_t sec)
+{
+    uint32_t off = KVS_HDR_SIZE;
+    memset(s_idx, 0, sizeof(s_idx));
+
+    while (off + 4u <= s_fl->size) {
+        uint32_t hdr = rd32(sec, off);
+        if (hdr == ERASED) break;
+
+        uint16_t key = (uint16_t)hdr, len = (uint16_t)(hdr >> 16);
+        if (len > KVS_MAX_VALUE || off + REC_SPAN(len) > s_fl->size) {
+            s_wr = off;
+            return 0;
+        }
+        uint32_t crc = rd32(sec, off + 4u + PAD4(len));
+        if (crc == rec_crc(hdr, at(sec, off + 4u), len) && key < KVS_MAX_KEYS)
+            s_idx[key] = len ? off : 0u;        /* len 0: deleted */
+        off += REC_SPAN(len);
+    }
+    s_wr = off;
+    return 1;
+}
+
+/* Copy the live records into the other sector and switch to it */
+static uint8_t compact(void)
+{
+    uint8_t  dst = (uint8_t)(s_act ^ 1u);
+    uint32_t off = KVS_HDR_SIZE;
+    uint32_t idx[KVS_MAX_KEYS];
+
+    /* retire the old copy first: a torn erase must not leave its magic
+       standing over a scrambled sequence and records */
+    if (sector_valid(dst) && !s_fl->program(s_fl->base[dst], 0u)) return 0;
+    if (!s_fl->erase(dst)) return 0;
+    for (uint32_t k = 0; k < KVS_MAX_KEYS; k++) {
+        idx[k] = 0;
+        if (!s_idx[k]) continue;
+        uint16_t len = (uint16_t)(rd32(s_act, s_idx[k]) >> 16);
+        if (!wr_record(dst, off, (uint16_t)k, at(s_act, s_idx[k] + 4u), len)) return 0;
+        idx[k] = off;
+        off += REC_SPAN(len);
+    }
+    /* sequence, then magic: the sector only counts once both are in */
+    if (!s_fl->program(s_fl->base[dst] + 4u, s_seq + 1u)) return 0;
+    if (!s_fl->program(s_fl->base[dst], KVS_MAGIC))       return 0;
+
+    s_act = dst;
+    s_seq++;
+    s_wr  = off;
+    memcpy(s_idx, idx, sizeof(s_idx));
+    return 1;
+}
+
+static uint8_t append(uint16_t key, const void *src, uint16_t len)
+{
+    if (s_wr + REC_SPAN(len) > s_fl->size) {
+        if (!compact()) return 0;
+        if (s_wr + REC_SPAN(len) > s_fl->size) return 0;
+    }
+    uint32_t off = s_wr;
+    s_wr += REC_SPAN(len);                      /* a failed write stays skipped */
+    if (!wr_record(s_act, off, key, (const uint8_t *)src, len)) return 0;
+    s_idx[key] = len ? off : 0u;
+    return 1;
+}
+
+static void lock(void)   { if (s_fl->lock)   s_fl->lock(); }
+static void unlock(void) { if (s_fl->unlock) s_fl->unlock(); }
+
+/* --- API ----------------------------------------------------------------- */
+
+uint8_t Kvs_Init(const kvs_flash_t *fl)
+{
+    uint8_t ok = 1;
+    s_fl = fl;
+    lock();
+
+    uint8_t v0 = sector_valid(0), v1 = sector_valid(1);
+    if (v0 && v1) {
+        /* both headed: an interrupted cleanup; the newer one wins */
+        s_act = ((int32_t)(rd32(1, 4) - rd32(0, 4)) > 0) ? 1u : 0u;
+    } else if (v0 || v1) {
+        s_act = v1;
+    } else {
+        /* blank or unreadable: format sector 0 */
+        s_act = 0;
+        s_seq = 0;
+        ok = s_fl->erase(0) && s_fl->program(fl->base[0] + 4u, 0u) &&
+             s_fl->program(fl->base[0], KVS_MAGIC);
+        memset(s_idx, 0, sizeof(s_idx));
+        s_wr = KVS_HDR_SIZE;
+        unlock();
+        return ok;
+    }
+    s_seq = rd32(s_act, 4);
+    if (!scan(s_act)) ok = compact();           /* drop an unusable tail */
+
+    unlock();
+    return ok;
+}
+
+uint16_t Kvs_Get(uint16_t key, void *dst, uint16_t max)
+{
+    if (s_fl == NULL || key >= KVS_MAX_KEYS) return 0;
+    lock();
+    uint32_t off = s_idx[key];
+    uint16_t len = off ? (uint16_t)(rd32(s_act, off) >> 16) : 0u;
+    if (len) memcpy(dst, at(s_act, off + 4u), (len < max) ? len : max);
+    unlock();
+    return len;
+}
+
+uint8_t Kvs_Put(uint16_t key, const void *src, uint16_t len)
+{
+    if (s_fl == NULL || key >= KVS_MAX_KEYS || len == 0 || len > KVS_MAX_VALUE) return 0;
+    lock();
+    uint32_t off = s_idx[key];
+    uint8_t  ok;
+    if (off && (uint16_t)(rd32(s_act, off) >> 16) == len &&
+        memcmp(at(s_act, off + 4u), src, len) == 0)
+        ok = 1;                                 /* unchanged: spare the flash */
+    else
+        ok = append(key, src, len);
+    unlock();
+    return ok;
+}
+
+uint8_t Kvs_Delete(uint16_t key)
+{
+    if (s_fl == NULL || key >= KVS_MAX_KEYS) return 0;
+    lock();
+    uint8_t ok = s_idx[key] ? append(key, NULL, 0) : 1u;
+    unlock();
+    return ok;
+}
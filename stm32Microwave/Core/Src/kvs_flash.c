@@ -0,0 +1,64 @@
+#include "kvs.h"
+#include "stm32f4xx_hal.h"
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : kvs backend on the F407's internal flash, sectors 10 and 11
+*           (kept out of the FLASH region in the linker scripts).
+******************************************************/
+
+#define KVS_FIRST_SECTOR    FLASH_SECTOR_10
+
+static SemaphoreHandle_t s_mtx;
+static StaticSemaphore_t s_mtx_buf;
+
+static uint8_t f_erase(uint8_t sector)
+{
+    FLASH_EraseInitTypeDef e = {
+        .TypeErase    = FLASH_TYPEERASE_SECTORS,
+        .Sector       = KVS_FIRST_SECTOR + sector,
+        .NbSectors    = 1,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3,      /* 2.7-3.6 V, x32 */
+    };
+    uint32_t bad;
+    return HAL_FLASHEx_Erase(&e, &bad) == HAL_OK;
+}
+
+static uint8_t f_program(uintptr_t addr, uint32_t word)
+{
+    return HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, addr, word) == HAL_OK;
+}
+
+static uint8_t rtos_running(void)
+{
+    return xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
+}
+
+static void f_lock(void)
+{
+    if (s_mtx == NULL) s_mtx = xSemaphoreCreateMutexStatic(&s_mtx_buf);
+    if (rtos_running()) xSemaphoreTake(s_mtx, portMAX_DELAY);
+    HAL_FLASH_Unlock();
+}
+
+static void f_unlock(void)
+{
+    HAL_FLASH_Lock();
+    /* the ART data cache may still hold what was there before programming */
+    __HAL_FLASH_DATA_CACHE_DISABLE();
+    __HAL_FLASH_DATA_CACHE_RESET();
+    __HAL_FLASH_DATA_CACHE_ENABLE();
+    if (rtos_running()) xSemaphoreGive(s_mtx);
+}
+
+const kvs_flash_t kvs_stm32_flash = {
+    .base    = { 0x080C0000u, 0x080E0000u },
+    .size    = 128u * 1024u,
+    .erase   = f_erase,
+    .program = f_program,
+    .lock    = f_lock,
+    .unlock  = f_unlock,
+};
@@ -1,15 +1,24 @@
 #include "lcd.h"
+#include "trace.h"
 #include <string.h>
 
+#if LCD_USE_DMA
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#endif
+
 /* ====== Private state ====== */
 static uint16_t _w  = ST7735_WIDTH;
 static uint16_t _h  = ST7735_HEIGHT;
 
-/* ====== Short GPIO helpers (pins/macros from main.h) ====== */
-#define CS_LO()   HAL_GPIO_WritePin(LCD_CS_GPIO_Port,  LCD_CS_Pin,  GPIO_PIN_RESET)
-#define CS_HI()   HAL_GPIO_WritePin(LCD_CS_GPIO_Port,  LCD_CS_Pin,  GPIO_PIN_SET)
-#define DC_LO()   HAL_GPIO_WritePin(LCD_DC_GPIO_Port,  LCD_DC_Pin,  GPIO_PIN_RESET)
-#define DC_HI()   HAL_GPIO_WritePin(LCD_DC_GPIO_Port,  LCD_DC_Pin,  GPIO_PIN_SET)
+/* ====== Short GPIO helpers (pins/macros from main.h) ======
+ * CS/DC flip several times per window setup, so they go straight to BSRR
+ * instead of through HAL_GPIO_WritePin. */
+#define CS_LO()   (LCD_CS_GPIO_Port->BSRR = (uint32_t)LCD_CS_Pin << 16U)
+#define CS_HI()   (LCD_CS_GPIO_Port->BSRR = LCD_CS_Pin)
+#define DC_LO()   (LCD_DC_GPIO_Port->BSRR = (uint32_t)LCD_DC_Pin << 16U)
+#define DC_HI()   (LCD_DC_GPIO_Port->BSRR = LCD_DC_Pin)
 #define RST_LO()  HAL_GPIO_WritePin(LCD_RST_GPIO_Port, LCD_RST_Pin, GPIO_PIN_RESET)
 #define RST_HI()  HAL_GPIO_WritePin(LCD_RST_GPIO_Port, LCD_RST_Pin, GPIO_PIN_SET)
 
@@ -24,6 +33,68 @@ static uint16_t _h  = ST7735_HEIGHT;
 /* ====== SPI helpers ====== */
 extern SPI_HandleTypeDef hspi1;
 
+/* Ping-pong staging for byte-swapped pixels. Must stay in SRAM: DMA2 reads it. */
+static uint8_t s_txbuf[2][LCD_TXBUF_PIXELS * 2];
+
+#if LCD_USE_DMA
+static volatile uint8_t  s_dma_busy = 0;
+static uint8_t           s_dma_block = 0;     /* waiter sleeps on s_dma_done */
+static SemaphoreHandle_t s_dma_done = NULL;
+static StaticSemaphore_t s_dma_done_buf;
+
+/* Sleep only from task context with the scheduler running; spin otherwise */
+static inline uint8_t dma_can_block(void) {
+  return (s_dma_done != NULL) && (__get_IPSR() == 0U) &&
+         (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING);
+}
+
+/* Wait until the in-flight transfer (if any) has left the shift register */
+static void spi_wait(void) {
+  while (s_dma_busy) {
+    if (s_dma_block) xSemaphoreTake(s_dma_done, pdMS_TO_TICKS(100));
+  }
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+  if (hspi->Instance != SPI1) return;
+  trace_put(TRACE_EV_LCD_DMA_DONE, 0, 0);
+  s_dma_busy = 0;
+  if (s_dma_block) {
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR(s_dma_done, &woken);
+    portYIELD_FROM_ISR(woken);
+  }
+}
+#else
+static inline void spi_wait(void) { }
+#endif
+
+/* Queue len bytes on SPI1 (CS/DC already set by the caller).
+ * With DMA this returns as soon as the transfer is started: buf must not be
+ * touched and CS must not be raised before spi_wait().
+ */
+#if LCD_USE_DMA
+/* Start a DMA transfer of len data frames; 0 if the stream refused it */
+static uint8_t spi_dma_start(const void *buf, uint16_t len) {
+  s_dma_block = dma_can_block();
+  s_dma_busy  = 1;
+  trace_put(TRACE_EV_LCD_DMA, 0, len);
+  if (HAL_SPI_Transmit_DMA(&hspi1, (uint8_t *)buf, len) == HAL_OK) return 1;
+  s_dma_busy  = 0;
+  return 0;
+}
+#endif
+
+static void spi_write(const uint8_t *buf, uint16_t len) {
+  spi_wait();
+#if LCD_USE_DMA
+  /* DMA2 cannot read CCM RAM (task stacks, rtos_mem.h) */
+  if (len >= LCD_DMA_MIN_BYTES && (uintptr_t)buf - CCMDATARAM_BASE >= 0x10000u &&
+      spi_dma_start(buf, len)) return;
+#endif
+  HAL_SPI_Transmit(&hspi1, (uint8_t *)buf, len, HAL_MAX_DELAY);
+}
+
 static inline void wr8(uint8_t d) {
   HAL_SPI_Transmit(&hspi1, &d, 1, HAL_MAX_DELAY);
 }
@@ -31,41 +102,165 @@ static inline void wr16(uint16_t d) {
   uint8_t b[2] = { (uint8_t)(d >> 8), (uint8_t)(d & 0xFF) };
   HAL_SPI_Transmit(&hspi1, b, 2, HAL_MAX_DELAY);
 }
+/* A block queued by LCD_PushBlockAsync() keeps CS low until the next
+ * access to the panel; anything that talks to it closes the block first. */
+static uint8_t s_push_open = 0;
+
+static void push_close(void) {
+  if (!s_push_open) return;
+  spi_wait();
+  CS_HI();
+  s_push_open = 0;
+}
+
 static inline void cmd(uint8_t c) {
+  push_close();
   DC_LO(); CS_LO(); wr8(c); CS_HI();
 }
 static inline void data8(uint8_t d) {
   DC_HI(); CS_LO(); wr8(d); CS_HI();
 }
-static inline void data16_rep(uint16_t color, uint32_t count) {
-  DC_HI(); CS_LO();
-  uint8_t b[2] = { (uint8_t)(color>>8), (uint8_t)color };
-  while (count--) HAL_SPI_Transmit(&hspi1, b, 2, HAL_MAX_DELAY);
+
+/* ====== Fill engine ====== */
+#if !LCD_USE_FRAMEBUFFER         /* framebuffer mode fills the shadow instead */
+static uint8_t  s_line[LCD_LINE_PIXELS * 2];  /* one scanline, byte-swapped */
+static uint16_t s_line_color = 0;
+static uint8_t  s_line_valid = 0;
+
+/* Pack the scanline buffer for color (no-op if it already holds it) */
+static void line_pack(uint16_t color) {
+  if (s_line_valid && s_line_color == color) return;
+  spi_wait();                       /* a previous fill may still read it */
+  for (uint32_t i = 0; i < LCD_LINE_PIXELS; ++i) {
+    s_line[2*i] = (uint8_t)(color >> 8); s_line[2*i + 1] = (uint8_t)color;
+  }
+  s_line_color = color;
+  s_line_valid = 1;
+}
+
+#if LCD_USE_DMA && LCD_FILL_FRAME16
+extern DMA_HandleTypeDef hdma_spi1_tx;
+static uint16_t s_fill_px;          /* DMA source for 16-bit repeat fills */
+
+/* Switch SPI1 + its TX stream between 8-bit incrementing transfers (default)
+ * and 16-bit transfers from a fixed address. Bus must be idle. */
+static void spi_frame16(uint8_t on) {
+  DMA_Stream_TypeDef *st = hdma_spi1_tx.Instance;
+  __HAL_SPI_DISABLE(&hspi1);
+  if (on) {
+    hspi1.Instance->CR1 |= SPI_CR1_DFF;
+    hspi1.Init.DataSize = SPI_DATASIZE_16BIT;
+    st->CR = (st->CR & ~DMA_SxCR_MINC) | DMA_SxCR_PSIZE_0 | DMA_SxCR_MSIZE_0;
+  } else {
+    hspi1.Instance->CR1 &= ~SPI_CR1_DFF;
+    hspi1.Init.DataSize = SPI_DATASIZE_8BIT;
+    st->CR = (st->CR & ~(DMA_SxCR_PSIZE | DMA_SxCR_MSIZE)) | DMA_SxCR_MINC;
+  }
+  __HAL_SPI_ENABLE(&hspi1);
+}
+#endif
+
+/* Send count pixels of one color into the window opened by set_window() */
+static void data16_rep(uint16_t color, uint32_t count) {
+#if LCD_USE_DMA && LCD_FILL_FRAME16
+  if (count > LCD_LINE_PIXELS) {
+    s_fill_px = color;
+    spi_frame16(1);
+    while (count) {
+      uint32_t chunk = (count < 0xFFFFu) ? count : 0xFFFFu;
+      spi_wait();
+      if (!spi_dma_start(&s_fill_px, (uint16_t)chunk)) {     /* chunk = halfwords */
+        for (uint32_t i = 0; i < chunk; ++i)
+          HAL_SPI_Transmit(&hspi1, (uint8_t *)&s_fill_px, 1, HAL_MAX_DELAY);
+      }
+      count -= chunk;
+    }
+    spi_wait();
+    spi_frame16(0);
+    CS_HI();
+    return;
+  }
+#endif
+  line_pack(color);
+  while (count) {
+    uint32_t chunk = (count < LCD_LINE_PIXELS) ? count : LCD_LINE_PIXELS;
+    spi_write(s_line, (uint16_t)(chunk * 2));
+    count -= chunk;
+  }
+  spi_wait();
   CS_HI();
 }
+#endif /* !LCD_USE_FRAMEBUFFER */
+
+/* Stream count native-endian pixels into the open window as big-endian bytes:
+ * one staging buffer is swapped while the other is on the wire. Does not wait
+ * for the last chunk, so a window can be fed row by row; caller ends it with
+ * spi_wait() + CS_HI(). */
+static uint8_t s_txsel = 0;
+
+static void data16_buf(const uint16_t *px, uint32_t count) {
+  while (count) {
+    uint32_t chunk = (count < LCD_TXBUF_PIXELS) ? count : LCD_TXBUF_PIXELS;
+    uint8_t *b = s_txbuf[s_txsel];
+    for (uint32_t i = 0; i < chunk; ++i) {
+      uint16_t v = *px++;
+      b[2*i] = (uint8_t)(v >> 8); b[2*i + 1] = (uint8_t)v;
+    }
+    spi_write(b, (uint16_t)(chunk * 2));   /* waits for the other buffer first */
+    s_txsel ^= 1;
+    count -= chunk;
+  }
+}
 
 static void hw_reset(void) {
   RST_LO(); HAL_Delay(50);
   RST_HI(); HAL_Delay(120);
 }
 
-/* ====== Address window ====== */
+/* ====== Address window ======
+ * One CS assertion covers CASET, RASET, RAMWR and the pixel data that
+ * follows: set_window() returns with CS low and DC high, and the caller
+ * raises CS once its data is out. Each parameter block is a single 4-byte
+ * burst, and the last column/row range is cached so a window that only moves
+ * along one axis (next pixel of a span, next row of a glyph) skips the
+ * other axis' command.
+ */
+#define WIN_UNKNOWN 0xFFFFu
+static uint16_t s_win_xs = WIN_UNKNOWN, s_win_xe = WIN_UNKNOWN;
+static uint16_t s_win_ys = WIN_UNKNOWN, s_win_ye = WIN_UNKNOWN;
+
+static inline void win_invalidate(void) {
+  s_win_xs = s_win_xe = s_win_ys = s_win_ye = WIN_UNKNOWN;
+}
+
+static inline void win_range(uint8_t c, uint16_t a, uint16_t b) {
+  uint8_t p[4] = { (uint8_t)(a >> 8), (uint8_t)a, (uint8_t)(b >> 8), (uint8_t)b };
+  DC_LO(); wr8(c);
+  DC_HI(); HAL_SPI_Transmit(&hspi1, p, 4, HAL_MAX_DELAY);
+}
+
 static void set_window(uint16_t xs, uint16_t ys, uint16_t xe, uint16_t ye) {
   xs += ST7735_XSTART; xe += ST7735_XSTART;
   ys += ST7735_YSTART; ye += ST7735_YSTART;
 
-  cmd(0x2A);
-  data8(xs >> 8); data8(xs & 0xFF);
-  data8(xe >> 8); data8(xe & 0xFF);
-
-  cmd(0x2B);
-  data8(ys >> 8); data8(ys & 0xFF);
-  data8(ye >> 8); data8(ye & 0xFF);
-
-  cmd(0x2C);
+  push_close();
+  CS_LO();
+  if (xs != s_win_xs || xe != s_win_xe) {
+    win_range(0x2A, xs, xe);
+    s_win_xs = xs; s_win_xe = xe;
+  }
+  if (ys != s_win_ys || ye != s_win_ye) {
+    win_range(0x2B, ys, ye);
+    s_win_ys = ys; s_win_ye = ye;
+  }
+  DC_LO(); wr8(0x2C);
+  DC_HI();
 }
 
 /* ====== MADCTL (orientation) ====== */
+static uint8_t  s_madctl = 0;
+static uint16_t s_scr_tm = 0, s_scr_vsa = 0;   /* scroll area, panel row terms */
+
 static void set_madctl_by_rot(uint8_t rot) {
   uint8_t madctl;
   switch (rot & 3) {
@@ -75,8 +270,78 @@ static void set_madctl_by_rot(uint8_t rot) {
     default:madctl = 0x60; _w = ST7735_HEIGHT; _h = ST7735_WIDTH;   break; // MV|MX
   }
   cmd(0x36); data8(madctl);
+  s_madctl = madctl;
+  win_invalidate();
+
+  if (s_scr_vsa) {               /* scroll offsets meant the old orientation */
+    cmd(0x13);                   // Normal display mode (scroll off)
+    s_scr_vsa = 0;
+  }
+}
+
+/* ====== Shadow framebuffer ====== */
+#if LCD_USE_FRAMEBUFFER
+/* Indexed in current logical coordinates (stride _w); the pixel count is the
+ * same for every rotation. CPU-only memory, flushed via s_txbuf. */
+static uint16_t s_fb[ST7735_WIDTH * ST7735_HEIGHT] __attribute__((section(".ccmbss"), aligned(4)));
+
+typedef struct { uint16_t x0, y0, x1, y1; } lcd_rect_t;   /* inclusive */
+static lcd_rect_t s_dirty[LCD_DIRTY_RECTS];
+static uint8_t    s_ndirty = 0;
+
+static inline uint32_t rect_area(const lcd_rect_t *r) {
+  return (uint32_t)(r->x1 - r->x0 + 1) * (uint32_t)(r->y1 - r->y0 + 1);
 }
 
+static inline void rect_union(lcd_rect_t *a, const lcd_rect_t *b) {
+  if (b->x0 < a->x0) a->x0 = b->x0;
+  if (b->y0 < a->y0) a->y0 = b->y0;
+  if (b->x1 > a->x1) a->x1 = b->x1;
+  if (b->y1 > a->y1) a->y1 = b->y1;
+}
+
+/* overlapping or sharing an edge: one window costs less than two */
+static inline uint8_t rect_touch(const lcd_rect_t *a, const lcd_rect_t *b) {
+  return a->x0 <= b->x1 + 1 && b->x0 <= a->x1 + 1 &&
+         a->y0 <= b->y1 + 1 && b->y0 <= a->y1 + 1;
+}
+
+/* Record an already clipped w*h area at (x,y) as needing a flush */
+static void fb_mark(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  lcd_rect_t r = { x, y, (uint16_t)(x + w - 1), (uint16_t)(y + h - 1) };
+
+  /* absorb every pending rect it touches; the union grows, so rescan */
+  for (uint8_t i = 0; i < s_ndirty; ) {
+    if (rect_touch(&s_dirty[i], &r)) {
+      rect_union(&r, &s_dirty[i]);
+      s_dirty[i] = s_dirty[--s_ndirty];
+      i = 0;
+    } else {
+      ++i;
+    }
+  }
+  if (s_ndirty < LCD_DIRTY_RECTS) { s_dirty[s_ndirty++] = r; return; }
+
+  /* list full: fold into the one whose bounding box grows the least */
+  uint8_t  best = 0;
+  uint32_t best_cost = UINT32_MAX;
+  for (uint8_t i = 0; i < s_ndirty; ++i) {
+    lcd_rect_t u = s_dirty[i];
+    rect_union(&u, &r);
+    uint32_t cost = rect_area(&u) - rect_area(&s_dirty[i]);
+    if (cost < best_cost) { best_cost = cost; best = i; }
+  }
+  rect_union(&s_dirty[best], &r);
+}
+
+static void fb_fill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+  uint16_t *row = &s_fb[(uint32_t)y * _w + x];
+  for (uint16_t r = 0; r < h; ++r, row += _w)
+    for (uint16_t i = 0; i < w; ++i) row[i] = color;
+  fb_mark(x, y, w, h);
+}
+#endif
+
 /* ====== Public API ====== */
 
 void LCD_Backlight_On(void)  { BL_ON();  }
@@ -87,9 +352,44 @@ uint16_t LCD_Height(void) { return _h; }
 
 void LCD_SetRotation(uint8_t r) {
   set_madctl_by_rot((uint8_t)(r & 3));
+#if LCD_USE_FRAMEBUFFER
+  s_ndirty = 0;          /* shadow layout changed with _w; caller redraws */
+#endif
+}
+
+/* VSCRDEF/VSCRSADD act on panel rows: the scroll direction follows the
+ * 160-pixel axis, which is only vertical on screen while MV is clear.
+ * With MY set, logical row 0 is the panel's last row, so the fixed areas
+ * swap ends and the start address counts backwards. */
+uint8_t LCD_SetScrollArea(uint16_t top_fixed, uint16_t bottom_fixed) {
+  if ((s_madctl & 0x20) || top_fixed + bottom_fixed >= ST7735_HEIGHT) return 0;
+
+  uint16_t vsa = ST7735_HEIGHT - top_fixed - bottom_fixed;
+  uint16_t tm  = (s_madctl & 0x80) ? bottom_fixed : top_fixed;
+  uint16_t bm  = ST7735_HEIGHT - tm - vsa;
+
+  cmd(0x33);                     // VSCRDEF: TFA, VSA, BFA
+  data8((uint8_t)(tm >> 8));  data8((uint8_t)tm);
+  data8((uint8_t)(vsa >> 8)); data8((uint8_t)vsa);
+  data8((uint8_t)(bm >> 8));  data8((uint8_t)bm);
+  s_scr_tm  = tm;
+  s_scr_vsa = vsa;
+  LCD_SetScrollStart(0);
+  return 1;
+}
+
+void LCD_SetScrollStart(uint16_t first) {
+  if (!s_scr_vsa) return;
+  first %= s_scr_vsa;
+  uint16_t ssa = s_scr_tm + ((s_madctl & 0x80) ? (uint16_t)((s_scr_vsa - first) % s_scr_vsa) : first);
+  cmd(0x37);                     // VSCRSADD
+  data8((uint8_t)(ssa >> 8)); data8((uint8_t)ssa);
 }
 
 void LCD_Init(void) {
+#if LCD_USE_DMA
+  if (s_dma_done == NULL) s_dma_done = xSemaphoreCreateBinaryStatic(&s_dma_done_buf);
+#endif
   BL_OFF();
   hw_reset();
 
@@ -136,57 +436,165 @@ void LCD_Init(void) {
   cmd(0x3A); data8(0x05);
 
   cmd(0x29);                     // Display on
+  win_invalidate();
 
   BL_ON();
   LCD_Clear(BLACK);
+  LCD_Flush();
 }
 
 void LCD_Clear(uint16_t color) {
+#if LCD_USE_FRAMEBUFFER
+  fb_fill(0, 0, _w, _h, color);
+#else
   set_window(0, 0, _w - 1, _h - 1);
   data16_rep(color, (uint32_t)_w * _h);
+#endif
 }
 
 void LCD_DrawPixel(uint16_t x, uint16_t y, uint16_t color) {
   if (x >= _w || y >= _h) return;
+#if LCD_USE_FRAMEBUFFER
+  s_fb[(uint32_t)y * _w + x] = color;
+  fb_mark(x, y, 1, 1);
+#else
   set_window(x, y, x, y);
-  DC_HI(); CS_LO(); wr16(color); CS_HI();
+  wr16(color);
+  CS_HI();
+#endif
 }
 
 void LCD_FillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
   if (x >= _w || y >= _h) return;
   if (x + w > _w) w = _w - x;
   if (y + h > _h) h = _h - y;
+#if LCD_USE_FRAMEBUFFER
+  fb_fill(x, y, w, h, color);
+#else
   set_window(x, y, x + w - 1, y + h - 1);
   data16_rep(color, (uint32_t)w * h);
+#endif
 }
 
 void LCD_DrawFastHLine(uint16_t x, uint16_t y, uint16_t w, uint16_t color) {
   if (y >= _h || x >= _w) return;
   if (x + w > _w) w = _w - x;
+#if LCD_USE_FRAMEBUFFER
+  fb_fill(x, y, w, 1, color);
+#else
   set_window(x, y, x + w - 1, y);
   data16_rep(color, w);
+#endif
 }
 
 void LCD_DrawFastVLine(uint16_t x, uint16_t y, uint16_t h, uint16_t color) {
   if (x >= _w || y >= _h) return;
   if (y + h > _h) h = _h - y;
+#if LCD_USE_FRAMEBUFFER
+  fb_fill(x, y, 1, h, color);
+#else
   set_window(x, y, x, y + h - 1);
   data16_rep(color, h);
+#endif
 }
 
 void LCD_DrawImage565(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels) {
   if (x >= _w || y >= _h) return;
+  uint16_t stride = w;
   if (x + w > _w) w = _w - x;
   if (y + h > _h) h = _h - y;
 
+#if LCD_USE_FRAMEBUFFER
+  for (uint16_t r = 0; r < h; ++r)
+    memcpy(&s_fb[(uint32_t)(y + r) * _w + x], pixels + (uint32_t)r * stride, (size_t)w * 2);
+  fb_mark(x, y, w, h);
+#else
   set_window(x, y, x + w - 1, y + h - 1);
+  if (w == stride) {
+    data16_buf(pixels, (uint32_t)w * h);
+  } else {
+    for (uint16_t r = 0; r < h; ++r) data16_buf(pixels + (uint32_t)r * stride, w);
+  }
+  spi_wait();
+  CS_HI();
+#endif
+}
 
-  DC_HI(); CS_LO();
-  /* transmit as bytes (big-endian) */
-  for (uint32_t i = 0; i < (uint32_t)w * h; ++i) {
-    uint16_t px = pixels[i];
-    uint8_t b[2] = { (uint8_t)(px >> 8), (uint8_t)px };
-    HAL_SPI_Transmit(&hspi1, b, 2, HAL_MAX_DELAY);
+void LCD_PushBlockAsync(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const void *be565) {
+  if (!w || !h || x + w > _w || y + h > _h) return;
+
+  set_window(x, y, x + w - 1, y + h - 1);
+  const uint8_t *p = (const uint8_t *)be565;
+  uint32_t left = (uint32_t)w * h * 2;
+  while (left) {
+    uint16_t chunk = (left < 0xFFFEu) ? (uint16_t)left : 0xFFFEu;
+    spi_write(p, chunk);
+    p += chunk;
+    left -= chunk;
   }
+  s_push_open = 1;
+}
+
+void LCD_Sync(void) {
+  push_close();
+}
+
+void LCD_Flush(void) {
+#if LCD_USE_FRAMEBUFFER
+  for (uint8_t i = 0; i < s_ndirty; ++i) {
+    const lcd_rect_t *r = &s_dirty[i];
+    uint16_t w = r->x1 - r->x0 + 1;
+    set_window(r->x0, r->y0, r->x1, r->y1);
+    if (w == _w) {
+      data16_buf(&s_fb[(uint32_t)r->y0 * _w], (uint32_t)w * (r->y1 - r->y0 + 1));
+    } else {
+      for (uint16_t y = r->y0; y <= r->y1; ++y) data16_buf(&s_fb[(uint32_t)y * _w + r->x0], w);
+    }
+    spi_wait();
+    CS_HI();
+  }
+  s_ndirty = 0;
+#endif
+}
+
+uint8_t LCD_ReadImage565(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t *dst) {
+#if LCD_USE_FRAMEBUFFER
+  if (x >= _w || y >= _h || x + w > _w || y + h > _h) return 0;
+  for (uint16_t r = 0; r < h; ++r)
+    memcpy(dst + (uint32_t)r * w, &s_fb[(uint32_t)(y + r) * _w + x], (size_t)w * 2);
+  return 1;
+#else
+  (void)x; (void)y; (void)w; (void)h; (void)dst;
+  return 0;
+#endif
+}
+
+/* ====== Benchmarks ====== */
+#if LCD_ENABLE_BENCH
+#include <stdio.h>
+#include "delay.h"
+
+void LCD_BenchClear(uint16_t color, uint32_t *legacy_us, uint32_t *fast_us) {
+  uint32_t t0, t_legacy, t_fast;
+  delay_init();
+
+  /* before: one blocking 2-byte HAL call per pixel */
+  t0 = delay_cycles();
+  set_window(0, 0, _w - 1, _h - 1);
+  uint8_t b[2] = { (uint8_t)(color >> 8), (uint8_t)color };
+  for (uint32_t n = (uint32_t)_w * _h; n; --n) HAL_SPI_Transmit(&hspi1, b, 2, HAL_MAX_DELAY);
   CS_HI();
+  t_legacy = delay_cycles_to_us(delay_cycles() - t0);
+
+  /* after: fill engine */
+  t0 = delay_cycles();
+  LCD_Clear((uint16_t)~color);
+  LCD_Flush();
+  t_fast = delay_cycles_to_us(delay_cycles() - t0);
+
+  if (legacy_us) *legacy_us = t_legacy;
+  if (fast_us)   *fast_us   = t_fast;
+  printf("LCD_Clear %ux%u: legacy %lu us, fill engine %lu us\r\n",
+         _w, _h, (unsigned long)t_legacy, (unsigned long)t_fast);
 }
+#endif
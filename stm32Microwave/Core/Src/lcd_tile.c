@@ -0,0 +1,246 @@
+#include <string.h>
+#include "lcd_tile.h"
+#include "font.h"
+
+/* ====== Display list ====== */
+enum { OP_RECT, OP_LINE, OP_CIRCLE, OP_GLYPH, OP_IMAGE };
+
+typedef struct {
+  uint8_t     type;
+  uint8_t     mode;          /* glyph: transparent; circle: filled */
+  uint8_t     stride;        /* glyph bytes per row */
+  int16_t     x0, y0, x1, y1;/* bbox, inclusive (line: endpoints, circle: center + r in x1) */
+  uint16_t    fc, bc;        /* native RGB565 */
+  const void *data;
+} tile_op_t;
+
+static tile_op_t s_ops[LCD_TILE_OPS];
+static uint8_t   s_nops = 0;
+static uint16_t  s_bg   = BLACK;
+
+/* Two tiles: one rendering, one on the wire. SRAM (.bss), DMA reads them. */
+static uint16_t s_tile[2][LCD_TILE_PIXELS];
+
+/* Tiles hold panel byte order so they go out without a copy */
+#define BE16(c)   ((uint16_t)(((c) << 8) | ((c) >> 8)))
+
+static tile_op_t *op_new(uint8_t type) {
+  if (s_nops >= LCD_TILE_OPS) return NULL;
+  tile_op_t *op = &s_ops[s_nops++];
+  memset(op, 0, sizeof(*op));
+  op->type = type;
+  return op;
+}
+
+/* ====== Recording ====== */
+
+void TILE_Begin(uint16_t bg) {
+  s_nops = 0;
+  s_bg   = bg;
+}
+
+uint8_t TILE_Rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color) {
+  if (!w || !h) return 1;
+  tile_op_t *op = op_new(OP_RECT);
+  if (!op) return 0;
+  op->x0 = (int16_t)x;           op->y0 = (int16_t)y;
+  op->x1 = (int16_t)(x + w - 1); op->y1 = (int16_t)(y + h - 1);
+  op->fc = color;
+  return 1;
+}
+
+uint8_t TILE_Line(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color) {
+  tile_op_t *op = op_new(OP_LINE);
+  if (!op) return 0;
+  op->x0 = (int16_t)x0; op->y0 = (int16_t)y0;
+  op->x1 = (int16_t)x1; op->y1 = (int16_t)y1;
+  op->fc = color;
+  return 1;
+}
+
+uint8_t TILE_Circle(uint16_t xc, uint16_t yc, uint8_t r, uint16_t color, uint8_t filled) {
+  tile_op_t *op = op_new(OP_CIRCLE);
+  if (!op) return 0;
+  op->x0 = (int16_t)xc; op->y0 = (int16_t)yc; op->x1 = r;
+  op->fc = color;
+  op->mode = filled;
+  return 1;
+}
+
+uint8_t TILE_Glyph(uint16_t x, uint16_t y, uint8_t w, uint8_t h,
+                   const uint8_t *msk, uint8_t stride,
+                   uint16_t fc, uint16_t bc, uint8_t mode) {
+  if (!msk || !w || !h) return 1;
+  tile_op_t *op = op_new(OP_GLYPH);
+  if (!op) return 0;
+  op->x0 = (int16_t)x;           op->y0 = (int16_t)y;
+  op->x1 = (int16_t)(x + w - 1); op->y1 = (int16_t)(y + h - 1);
+  op->fc = fc; op->bc = bc; op->mode = mode;
+  op->stride = stride;
+  op->data = msk;
+  return 1;
+}
+
+uint8_t TILE_Text(uint16_t x, uint16_t y, uint16_t fc, uint16_t bc,
+                  const char *s, uint8_t size, uint8_t mode) {
+  uint8_t w = (size == 12) ? 6 : 8;
+  uint8_t h = (size == 12) ? 12 : 16;
+  for (; *s >= ' ' && *s <= '~'; ++s, x = (uint16_t)(x + w)) {
+    const uint8_t *rows = (size == 12) ? FONT_GetASCIIFont6x12(*s) : FONT_GetASCIIFont8x16(*s);
+    if (!TILE_Glyph(x, y, w, h, rows, 1, fc, bc, mode)) return 0;
+  }
+  return 1;
+}
+
+uint8_t TILE_Image(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint16_t *pixels) {
+  if (!pixels || !w || !h) return 1;
+  tile_op_t *op = op_new(OP_IMAGE);
+  if (!op) return 0;
+  op->x0 = (int16_t)x;           op->y0 = (int16_t)y;
+  op->x1 = (int16_t)(x + w - 1); op->y1 = (int16_t)(y + h - 1);
+  op->data = pixels;
+  return 1;
+}
+
+/* ====== Rasterizer ======
+ * Everything below draws one op into the current tile, clipped to it.
+ */
+typedef struct {
+  uint16_t *px;
+  int16_t   x0, y0, x1, y1;   /* tile area on screen, inclusive */
+  uint16_t  w;
+} tile_t;
+
+static inline void t_plot(const tile_t *t, int16_t x, int16_t y, uint16_t be) {
+  if (x < t->x0 || x > t->x1 || y < t->y0 || y > t->y1) return;
+  t->px[(uint32_t)(y - t->y0) * t->w + (uint16_t)(x - t->x0)] = be;
+}
+
+static void t_span(const tile_t *t, int16_t xa, int16_t xb, int16_t y, uint16_t be) {
+  if (y < t->y0 || y > t->y1) return;
+  if (xa < t->x0) xa = t->x0;
+  if (xb > t->x1) xb = t->x1;
+  uint16_t *p = &t->px[(uint32_t)(y - t->y0) * t->w + (uint16_t)(xa - t->x0)];
+  for (int16_t x = xa; x <= xb; ++x) *p++ = be;
+}
+
+/* Classic Bresenham, same stepping as LCD_DrawLine */
+static void t_line(const tile_t *t, const tile_op_t *op) {
+  int16_t dx = op->x1 - op->x0, dy = op->y1 - op->y0;
+  int16_t sx = (dx >= 0) ? 1 : -1, sy = (dy >= 0) ? 1 : -1;
+  dx = (dx >= 0) ? dx : -dx;
+  dy = (dy >= 0) ? dy : -dy;
+  int16_t err = (dx > dy ? dx : -dy) / 2;
+  int16_t x = op->x0, y = op->y0;
+  uint16_t be = BE16(op->fc);
+  for (;;) {
+    t_plot(t, x, y, be);
+    if (x == op->x1 && y == op->y1) break;
+    int16_t e2 = err;
+    if (e2 > -dx) { err -= dy; x += sx; }
+    if (e2 <  dy) { err += dx; y += sy; }
+  }
+}
+
+/* Midpoint circle, same stepping as gui_circle(); filled draws the horizontal chords */
+static void t_circle(const tile_t *t, const tile_op_t *op) {
+  int16_t xc = op->x0, yc = op->y0, r = op->x1;
+  if (xc + r < t->x0 || xc - r > t->x1 || yc + r < t->y0 || yc - r > t->y1) return;
+  int16_t a = 0, b = r, di = 3 - (r << 1);
+  uint16_t be = BE16(op->fc);
+  while (a <= b) {
+    if (op->mode) {
+      t_span(t, xc - b, xc + b, yc + a, be);
+      t_span(t, xc - b, xc + b, yc - a, be);
+      t_span(t, xc - a, xc + a, yc + b, be);
+      t_span(t, xc - a, xc + a, yc - b, be);
+    } else {
+      t_plot(t, xc + a, yc - b, be); t_plot(t, xc + b, yc - a, be);
+      t_plot(t, xc + b, yc + a, be); t_plot(t, xc + a, yc + b, be);
+      t_plot(t, xc - a, yc + b, be); t_plot(t, xc - b, yc + a, be);
+      t_plot(t, xc - a, yc - b, be); t_plot(t, xc - b, yc - a, be);
+    }
+    if (di < 0) di += 4 * a + 6;
+    else { di += 4 * (a - b) + 10; b--; }
+    a++;
+  }
+}
+
+static void t_op(const tile_t *t, const tile_op_t *op) {
+  if (op->type == OP_LINE)   { t_line(t, op);   return; }
+  if (op->type == OP_CIRCLE) { t_circle(t, op); return; }
+
+  /* box ops: intersect with the tile */
+  int16_t xa = (op->x0 > t->x0) ? op->x0 : t->x0;
+  int16_t xb = (op->x1 < t->x1) ? op->x1 : t->x1;
+  int16_t ya = (op->y0 > t->y0) ? op->y0 : t->y0;
+  int16_t yb = (op->y1 < t->y1) ? op->y1 : t->y1;
+  if (xa > xb || ya > yb) return;
+
+  switch (op->type) {
+    case OP_RECT: {
+      uint16_t be = BE16(op->fc);
+      for (int16_t y = ya; y <= yb; ++y) t_span(t, xa, xb, y, be);
+      break;
+    }
+    case OP_GLYPH: {
+      uint16_t fc = BE16(op->fc), bc = BE16(op->bc);
+      for (int16_t y = ya; y <= yb; ++y) {
+        const uint8_t *bits = (const uint8_t *)op->data + (uint32_t)(y - op->y0) * op->stride;
+        uint16_t *p = &t->px[(uint32_t)(y - t->y0) * t->w + (uint16_t)(xa - t->x0)];
+        for (int16_t x = xa; x <= xb; ++x, ++p) {
+          uint16_t col = (uint16_t)(x - op->x0);
+          if (bits[col >> 3] & (0x80u >> (col & 7u))) *p = fc;
+          else if (!op->mode)                         *p = bc;
+        }
+      }
+      break;
+    }
+    case OP_IMAGE: {
+      uint16_t iw = (uint16_t)(op->x1 - op->x0 + 1);
+      for (int16_t y = ya; y <= yb; ++y) {
+        const uint16_t *src = (const uint16_t *)op->data +
+                              (uint32_t)(y - op->y0) * iw + (uint16_t)(xa - op->x0);
+        uint16_t *p = &t->px[(uint32_t)(y - t->y0) * t->w + (uint16_t)(xa - t->x0)];
+        for (int16_t x = xa; x <= xb; ++x) { uint16_t c = *src++; *p++ = BE16(c); }
+      }
+      break;
+    }
+    default: break;
+  }
+}
+
+/* ====== Render ====== */
+
+void TILE_Render(void) {
+  TILE_RenderArea(0, 0, LCD_Width(), LCD_Height());
+}
+
+void TILE_RenderArea(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  if (x >= LCD_Width() || y >= LCD_Height() || !w || !h) return;
+  if (x + w > LCD_Width())  w = LCD_Width()  - x;
+  if (y + h > LCD_Height()) h = LCD_Height() - y;
+
+  const uint16_t tw_max = LCD_TILE_PIXELS / LCD_TILE_ROWS;
+  const uint16_t bg = BE16(s_bg);
+  uint8_t sel = 0;
+
+  for (uint16_t by = y; by < y + h; by = (uint16_t)(by + LCD_TILE_ROWS)) {
+    uint16_t th = (uint16_t)((y + h - by < LCD_TILE_ROWS) ? (y + h - by) : LCD_TILE_ROWS);
+    for (uint16_t bx = x; bx < x + w; bx = (uint16_t)(bx + tw_max)) {
+      uint16_t tw = (uint16_t)((x + w - bx < tw_max) ? (x + w - bx) : tw_max);
+      tile_t t = { s_tile[sel], (int16_t)bx, (int16_t)by,
+                   (int16_t)(bx + tw - 1), (int16_t)(by + th - 1), tw };
+
+      /* this buffer went out two tiles ago; LCD_PushBlockAsync of the
+         previous tile already waited for it */
+      uint32_t n = (uint32_t)tw * th;
+      for (uint32_t i = 0; i < n; ++i) t.px[i] = bg;
+      for (uint8_t i = 0; i < s_nops; ++i) t_op(&t, &s_ops[i]);
+
+      LCD_PushBlockAsync(bx, by, tw, th, t.px);
+      sel ^= 1;
+    }
+  }
+  LCD_Sync();
+}
@@ -0,0 +1,285 @@
+#include "lowpower.h"
+#include "main.h"
+#include "tim.h"
+#include "spi.h"
+#include "usart.h"
+#include "micro_wave_oven.h"
+#include "clock.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : STOP / SLEEP idle with an RTC timebase, see lowpower.h
+******************************************************/
+
+#if configUSE_TICKLESS_IDLE == 1
+
+/* RTC: ck_apre = RTCCLK / 8 drives the subsecond counter, ck_spre = 1 Hz,
+   the wakeup timer runs at RTCCLK / 16 */
+#if MW_LP_RTC_LSE
+#define LP_RTCCLK_HZ    32768u
+#define LP_RTCSEL       RCC_BDCR_RTCSEL_0
+#else
+#define LP_RTCCLK_HZ    32000u
+#define LP_RTCSEL       RCC_BDCR_RTCSEL_1
+#endif
+#define LP_PREDIV_A     7u
+#define LP_SUB_HZ       (LP_RTCCLK_HZ / (LP_PREDIV_A + 1u))
+#define LP_PREDIV_S     (LP_SUB_HZ - 1u)
+#define LP_WUT_HZ       (LP_RTCCLK_HZ / 16u)
+#define LP_DAY          (86400u * LP_SUB_HZ)
+
+static volatile LowPowerMode s_mode = LP_MODE_SLEEP;
+static LowPowerStats         s_stats;
+static uint32_t              s_sleep_cyc;      /* SysTick counts not yet in sleep_ms */
+static uint8_t               s_rtc_ok;
+static volatile uint8_t      s_console;        /* console woke us at s_console_at */
+static volatile TickType_t   s_console_at;
+static volatile uint8_t      s_hold;           /* LowPower_Hold until s_hold_until */
+static volatile TickType_t   s_hold_until;
+
+/* --- RTC ------------------------------------------------------------------ */
+
+static inline uint32_t bcd(uint32_t v)
+{
+    return (v >> 4) * 10u + (v & 0xFu);
+}
+
+/* Subsecond counts since midnight. Shadow registers are bypassed (they are
+   stale after STOP), so SSR is read twice around TR. */
+static uint32_t rtc_now(void)
+{
+    uint32_t ss, tr;
+    do {
+        ss = RTC->SSR;
+        tr = RTC->TR;
+    } while (ss != RTC->SSR);
+
+    uint32_t s = bcd(tr & (RTC_TR_ST | RTC_TR_SU)) +
+                 bcd((tr & (RTC_TR_MNT | RTC_TR_MNU)) >> RTC_TR_MNU_Pos) * 60u +
+                 bcd((tr & (RTC_TR_HT | RTC_TR_HU)) >> RTC_TR_HU_Pos) * 3600u;
+    return s * LP_SUB_HZ + (LP_PREDIV_S - ss);
+}
+
+static inline void rtc_clear_wakeup(void)
+{
+    RTC->ISR = ~(RTC_ISR_WUTF | RTC_ISR_INIT) & 0x0000FFFFu;
+    EXTI->PR = EXTI_PR_PR22;
+}
+
+/* Wake after `counts` + 1 periods of LP_WUT_HZ */
+static void wut_start(uint32_t counts)
+{
+    RTC->WPR = 0xCAu;
+    RTC->WPR = 0x53u;
+    RTC->CR &= ~RTC_CR_WUTE;
+    while (!(RTC->ISR & RTC_ISR_WUTWF)) { }
+    RTC->WUTR = counts;
+    RTC->CR = (RTC->CR & ~RTC_CR_WUCKSEL) | RTC_CR_WUTIE | RTC_CR_WUTE;
+    rtc_clear_wakeup();
+    RTC->WPR = 0xFFu;
+}
+
+static void wut_stop(void)
+{
+    RTC->WPR = 0xCAu;
+    RTC->WPR = 0x53u;
+    RTC->CR &= ~(RTC_CR_WUTE | RTC_CR_WUTIE);
+    rtc_clear_wakeup();
+    RTC->WPR = 0xFFu;
+    NVIC_ClearPendingIRQ(RTC_WKUP_IRQn);
+}
+
+void RTC_WKUP_IRQHandler(void)
+{
+    rtc_clear_wakeup();
+}
+
+/* PA3 (USART2 RX) falling edge, only unmasked while in STOP */
+void EXTI3_IRQHandler(void)
+{
+    EXTI->PR = EXTI_PR_PR3;
+    s_console_at = xTaskGetTickCountFromISR();
+    s_console = 1;
+}
+
+void LowPower_Init(void)
+{
+    __HAL_RCC_PWR_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+
+    /* the RTC clock can only be changed by a backup domain reset */
+    if ((RCC->BDCR & RCC_BDCR_RTCSEL) != LP_RTCSEL) {
+        RCC->BDCR |= RCC_BDCR_BDRST;
+        RCC->BDCR &= ~RCC_BDCR_BDRST;
+    }
+#if MW_LP_RTC_LSE
+    RCC->BDCR |= RCC_BDCR_LSEON;
+    uint32_t t0 = HAL_GetTick();
+    while (!(RCC->BDCR & RCC_BDCR_LSERDY))
+        if (HAL_GetTick() - t0 > 5000u) return;    /* no crystal: SLEEP only */
+#else
+    __HAL_RCC_LSI_ENABLE();
+    while (!(RCC->CSR & RCC_CSR_LSIRDY)) { }
+#endif
+    RCC->BDCR |= LP_RTCSEL | RCC_BDCR_RTCEN;
+
+    RTC->WPR = 0xCAu;
+    RTC->WPR = 0x53u;
+    RTC->ISR |= RTC_ISR_INIT;
+    while (!(RTC->ISR & RTC_ISR_INITF)) { }
+    RTC->PRER = LP_PREDIV_S;                        /* two writes, S first */
+    RTC->PRER |= LP_PREDIV_A << RTC_PRER_PREDIV_A_Pos;
+    RTC->TR = 0;
+    RTC->CR = RTC_CR_BYPSHAD;
+    RTC->ISR &= ~RTC_ISR_INIT;
+    RTC->WPR = 0xFFu;
+
+    /* wakeup timer -> EXTI22 rising */
+    EXTI->IMR  |= EXTI_IMR_MR22;
+    EXTI->RTSR |= EXTI_RTSR_TR22;
+    HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+
+    /* console start bit -> EXTI3 falling */
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+    SYSCFG->EXTICR[0] = (SYSCFG->EXTICR[0] & ~SYSCFG_EXTICR1_EXTI3) | SYSCFG_EXTICR1_EXTI3_PA;
+    EXTI->FTSR |= EXTI_FTSR_TR3;
+    HAL_NVIC_SetPriority(EXTI3_IRQn, 6, 0);
+    HAL_NVIC_EnableIRQ(EXTI3_IRQn);
+
+    s_rtc_ok = 1;
+}
+
+void LowPower_SetMode(LowPowerMode mode)
+{
+    s_mode = mode;
+}
+
+void LowPower_Hold(uint32_t ms)
+{
+    TickType_t until = xTaskGetTickCount() + pdMS_TO_TICKS(ms);
+
+    taskENTER_CRITICAL();
+    if (!s_hold || (int32_t)(until - s_hold_until) > 0) s_hold_until = until;
+    s_hold = 1;
+    taskEXIT_CRITICAL();
+}
+
+void LowPower_GetStats(LowPowerStats *out, uint8_t reset)
+{
+    taskENTER_CRITICAL();
+    *out = s_stats;
+    if (reset) {
+        s_stats = (LowPowerStats){ 0 };
+        s_sleep_cyc = 0;
+    }
+    taskEXIT_CRITICAL();
+}
+
+/* --- idle ----------------------------------------------------------------- */
+
+/* Whatever is clocked from the bus or the PLL must be idle for STOP */
+static uint8_t stop_blocked(void)
+{
+    if (htim7.Instance->CR1 & TIM_CR1_CEN) return 1;                    /* key scan */
+    if (MW_HEATER_TIM->Instance->DIER & TIM_DIER_UIE) return 1;         /* burst firing */
+    if (__HAL_TIM_GET_COMPARE(MW_HEATER_TIM, MW_HEATER_CH) ||
+        __HAL_TIM_GET_COMPARE(MW_TURNTABLE_TIM, MW_TURNTABLE_CH)) return 1;
+    if (hspi1.State != HAL_SPI_STATE_READY) return 1;                   /* LCD DMA */
+    if (huart2.gState != HAL_UART_STATE_READY) return 1;                /* console TX */
+    if (s_hold && (int32_t)(s_hold_until - xTaskGetTickCount()) > 0) return 1;   /* servo travel */
+    s_hold = 0;
+    if (s_console &&
+        (TickType_t)(xTaskGetTickCount() - s_console_at) < pdMS_TO_TICKS(MW_LP_CONSOLE_HOLD_MS))
+        return 1;
+    s_console = 0;
+    return 0;
+}
+
+/* WFI with the tick running; SysTick counts measure the nap */
+static void sleep_wfi(void)
+{
+    uint32_t before, after, cyc, per_ms;
+
+    (void)SysTick->CTRL;                            /* clear COUNTFLAG */
+    before = SysTick->VAL;
+    __DSB();
+    __WFI();
+    __ISB();
+    after = SysTick->VAL;
+    cyc = (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) ? before + SysTick->LOAD + 1u - after
+                                                        : before - after;
+
+    per_ms = SystemCoreClock / 1000u;
+    s_sleep_cyc += cyc;
+    s_stats.sleep_ms += s_sleep_cyc / per_ms;
+    s_sleep_cyc %= per_ms;
+    s_stats.sleep_count++;
+}
+
+/* SysTick off, RTC wakeup armed one tick short (the restarted SysTick
+   delivers the last one), STOP, then step the kernel by the RTC time */
+static void stop_rtc(TickType_t expected)
+{
+    uint32_t start, slept;
+    TickType_t ticks;
+
+    if (expected > pdMS_TO_TICKS(MW_LP_STOP_MAX_MS)) expected = pdMS_TO_TICKS(MW_LP_STOP_MAX_MS);
+    uint32_t wut = (uint32_t)(expected - 1u) * LP_WUT_HZ / configTICK_RATE_HZ;
+
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+    wut_start(wut ? wut - 1u : 0u);
+    start = rtc_now();
+
+    EXTI->PR   = EXTI_PR_PR3;
+    EXTI->IMR |= EXTI_IMR_MR3;
+    HAL_SuspendTick();
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+    Clock_Restore();                                /* back from HSI to the PLL */
+    HAL_ResumeTick();
+    EXTI->IMR &= ~EXTI_IMR_MR3;
+
+    slept = (rtc_now() + LP_DAY - start) % LP_DAY;
+    wut_stop();
+
+    ticks = (TickType_t)(slept * configTICK_RATE_HZ / LP_SUB_HZ);
+    if (ticks > expected - 1u) ticks = expected - 1u;
+    SysTick->VAL   = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+    if (ticks) vTaskStepTick(ticks);
+
+    s_stats.stop_ms += slept * 1000u / LP_SUB_HZ;
+    s_stats.stop_count++;
+}
+
+/* Replaces the port's weak SysTick-only version */
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+    uint8_t stop = (s_mode == LP_MODE_STOP) && s_rtc_ok &&
+                   xExpectedIdleTime >= pdMS_TO_TICKS(MW_LP_STOP_MIN_MS);
+
+    __disable_irq();
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+        s_stats.aborted++;
+        __enable_irq();
+        return;
+    }
+    if (stop && stop_blocked()) {
+        s_stats.stop_blocked++;
+        stop = 0;
+    }
+    if (stop) stop_rtc(xExpectedIdleTime);
+    else      sleep_wfi();
+    __enable_irq();
+}
+
+#else /* !configUSE_TICKLESS_IDLE */
+
+void LowPower_Init(void) { }
+void LowPower_SetMode(LowPowerMode mode) { (void)mode; }
+void LowPower_Hold(uint32_t ms) { (void)ms; }
+void LowPower_GetStats(LowPowerStats *out, uint8_t reset) { (void)reset; *out = (LowPowerStats){ 0 }; }
+
+#endif /* configUSE_TICKLESS_IDLE */
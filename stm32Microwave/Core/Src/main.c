@@ -33,6 +33,13 @@
 #include "delay.h"
 #include "stm32f4xx_hal.h"
 #include "micro_wave_oven.h"
+#include "heater_sd.h"
+#include "kvs.h"
+#include "button.h"
+#include "lowpower.h"
+#include "clock.h"
+#include "prof.h"
+#include "retarget.h"
 
 
 /* USER CODE END Includes */
@@ -64,6 +71,8 @@ led_d LED_ORANGE;  // PD13
 led_d led1;     // PD14//red
 led_d LED_BLUE;    // PD15
 
+MicrowaveCtrl mw1; // oven state; global so it outlives main()'s stack once the scheduler runs
+
 
 /* USER CODE END PV */
 
@@ -114,7 +123,9 @@ int main(void)
   MX_TIM4_Init();
   MX_TIM2_Init();
   MX_TIM3_Init();
+  MX_TIM7_Init();
   /* USER CODE BEGIN 2 */
+  Clock_Init();                 /* MW_CLOCK_PROFILE, rescales what MX_* set up */
 
   //HAL_NVIC_SetPriority(DMA1_Stream5_IRQn, 4, 0);  // override it, make DMA=4
 
@@ -130,7 +141,9 @@ int main(void)
   //HAL_Delay(1500);
 
 
-  MicrowaveCtrl mw1;
+  Kvs_Init(&kvs_stm32_flash);   /* settings log, before the oven restores them */
+  LowPower_Init();              /* RTC for STOP-mode idle */
+
   micro_wave_init(&mw1);
 
 
@@ -192,9 +205,9 @@ void SystemClock_Config(void)
   RCC_OscInitStruct.PLL.PLLState = RCC_PLL_ON;
   RCC_OscInitStruct.PLL.PLLSource = RCC_PLLSOURCE_HSI;
   RCC_OscInitStruct.PLL.PLLM = 8;
-  RCC_OscInitStruct.PLL.PLLN = 64;
+  RCC_OscInitStruct.PLL.PLLN = 168;
   RCC_OscInitStruct.PLL.PLLP = RCC_PLLP_DIV2;
-  RCC_OscInitStruct.PLL.PLLQ = 4;
+  RCC_OscInitStruct.PLL.PLLQ = 7;
   if (HAL_RCC_OscConfig(&RCC_OscInitStruct) != HAL_OK)
   {
     Error_Handler();
@@ -205,11 +218,11 @@ void SystemClock_Config(void)
   RCC_ClkInitStruct.ClockType = RCC_CLOCKTYPE_HCLK|RCC_CLOCKTYPE_SYSCLK
                               |RCC_CLOCKTYPE_PCLK1|RCC_CLOCKTYPE_PCLK2;
   RCC_ClkInitStruct.SYSCLKSource = RCC_SYSCLKSOURCE_PLLCLK;
-  RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV4;
-  RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV1;
-  RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV1;
+  RCC_ClkInitStruct.AHBCLKDivider = RCC_SYSCLK_DIV1;
+  RCC_ClkInitStruct.APB1CLKDivider = RCC_HCLK_DIV4;
+  RCC_ClkInitStruct.APB2CLKDivider = RCC_HCLK_DIV2;
 
-  if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_0) != HAL_OK)
+  if (HAL_RCC_ClockConfig(&RCC_ClkInitStruct, FLASH_LATENCY_5) != HAL_OK)
   {
     Error_Handler();
   }
@@ -237,6 +250,21 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
     HAL_IncTick();
   }
   /* USER CODE BEGIN Callback 1 */
+  if (htim->Instance == TIM6)
+  {
+    Prof_RunTime();             /* keeps the CYCCNT extension current */
+    Retarget_Poll();            /* output the UART refused to take */
+  }
+  if (htim->Instance == TIM7)
+  {
+    Button_Tick();
+  }
+#if MW_HEATER_SD
+  if (htim->Instance == TIM3)
+  {
+    HeaterSd_Tick();
+  }
+#endif
 
   /* USER CODE END Callback 1 */
 }
@@ -0,0 +1,87 @@
+#include "mempool.h"
+#include "main.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Lock-free fixed-block pool, see mempool.h
+******************************************************/
+
+/* *v += d, returns the new value */
+static uint32_t atomic_add(volatile uint32_t *v, int32_t d)
+{
+    uint32_t n;
+    do {
+        n = __LDREXW(v) + (uint32_t)d;
+    } while (__STREXW(n, v));
+    return n;
+}
+
+/* Block number n (1..count) <-> address */
+static inline MemPoolBlock *blk_at(const MemPool *p, uint32_t n)
+{
+    return (MemPoolBlock *)(p->base + (n - 1u) * p->block_size);
+}
+
+static void peak_update(volatile uint32_t *peak, uint32_t n)
+{
+    do {
+        if (__LDREXW(peak) >= n) { __CLREX(); return; }
+    } while (__STREXW(n, peak));
+}
+
+void MemPool_Init(MemPool *p, void *mem, uint32_t block_size, uint32_t count)
+{
+    block_size    = MEMPOOL_BLOCK_SIZE(block_size);
+    p->base       = (uint8_t *)mem;
+    p->block_size = block_size;
+    p->count      = count;
+    p->used = p->peak = p->fail = 0;
+
+    for (uint32_t n = 1; n <= count; n++)
+        blk_at(p, n)->next = (n < count) ? n + 1u : 0u;
+    p->head = count ? 1u : 0u;
+}
+
+void *MemPool_Alloc(MemPool *p)
+{
+    uint32_t n;
+    do {
+        n = __LDREXW(&p->head);
+        if (n == 0u) {
+            __CLREX();
+            atomic_add(&p->fail, 1);
+            return NULL;
+        }
+        /* next may be stale if n was taken meanwhile; then the store fails */
+    } while (__STREXW(blk_at(p, n)->next, &p->head));
+
+    peak_update(&p->peak, atomic_add(&p->used, 1));
+    return blk_at(p, n);
+}
+
+void MemPool_Free(MemPool *p, void *blk)
+{
+    if (blk == NULL) return;
+    uintptr_t off = (uintptr_t)blk - (uintptr_t)p->base;
+    if (off >= (uintptr_t)p->block_size * p->count || off % p->block_size) return;
+
+    MemPoolBlock *b = (MemPoolBlock *)blk;
+    uint32_t      n = (uint32_t)(off / p->block_size) + 1u;
+    do {
+        b->next = __LDREXW(&p->head);
+    } while (__STREXW(n, &p->head));
+
+    atomic_add(&p->used, -1);
+}
+
+void MemPool_GetStats(MemPool *p, MemPoolStats *out, uint8_t reset)
+{
+    out->count = p->count;
+    out->used  = p->used;
+    out->peak  = p->peak;
+    out->fail  = p->fail;
+    if (reset) {
+        p->peak = p->used;
+        p->fail = 0;
+    }
+}
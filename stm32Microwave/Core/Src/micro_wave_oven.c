@@ -3,7 +3,12 @@
 #include "gui.h"
 #include "delay.h"
 #include "beep.h"
+#include <stdio.h>
 #include "FreeRTOSConfig.h"
+#include "heater_pid.h"
+#include "heater_sd.h"
+#include "kvs.h"
+#include "lowpower.h"
 
 /******************************************************
 * Project : Microwave Oven Controller (STM32F407 + HAL)
@@ -12,9 +17,10 @@
 * Date    : 2025/03/20
 * Note    : Uses:
 *            - TIM2_CH2 (PA1) for SG90 door servo @ 50 Hz
-*            - TIM3_CH3 (PB0) heater PWM @ 1 kHz
+*            - TIM3_CH3 (PB0) heater PWM @ 1 kHz, or burst-fire cycles
+*              from the TIM3 update IRQ (MW_HEATER_SD)
 *            - TIM3_CH4 (PC9) turntable PWM @ 1 kHz
-*            - TIM4 Base timer (1 Hz) for countdown (Update interrupt)
+*            - TIM4 free-running @ 2 kHz, CH1 compare for the countdown
 ******************************************************/
 
 /* --- local helpers ------------------------------------------------------- */
@@ -24,30 +30,99 @@ static inline void servo_write_us(uint16_t us)
     if (us < 900u)  us = 900u;     /* safe guard */
     if (us > 2100u) us = 2100u;
     __HAL_TIM_SET_COMPARE(MW_DOOR_TIM, MW_DOOR_CH, us);
+    LowPower_Hold(MW_LP_SERVO_HOLD_MS);     /* TIM2 has to run until it gets there */
 }
 
-/* Map power level to heater duty (TIM3 ARR=99 for 1 kHz) */
-static inline uint16_t heater_duty_from_power(PowerLevel pwr)
+/* Power level -> heater power (%) */
+uint8_t power_pct_from_level(PowerLevel pwr)
 {
     switch (pwr) {
-        case POWER_LOW:    return 50;  /* ~50% */
-        case POWER_MEDIUM: return 70;  /* ~70% */
-        case POWER_HIGH:   return 99;  /* ~100% (ARR=99) */
+        case POWER_LOW:    return 50;
+        case POWER_MEDIUM: return 70;
+        case POWER_HIGH:   return 100;
         default:           return 70;
     }
 }
 
+/* --- countdown ------------------------------------------------------------
+ * TIM4 counts MW_COUNTDOWN_CPMS per millisecond and never stops.
+ * cooking_time is brought up to date against s_cd_mark, the count it was
+ * last synced at; the 16-bit difference is exact because syncs are never
+ * more than 1 s apart while cooking (the CH1 compare is always armed for
+ * the next whole second). The mark only moves by whole milliseconds.
+ */
+static uint16_t s_cd_mark;
+
+static void countdown_sync(MicrowaveCtrl *mw)
+{
+    uint16_t now     = (uint16_t)__HAL_TIM_GET_COUNTER(MW_COUNTDOWN_TIM);
+    uint16_t elapsed = (uint16_t)(now - s_cd_mark) / MW_COUNTDOWN_CPMS;
+    s_cd_mark = (uint16_t)(s_cd_mark + elapsed * MW_COUNTDOWN_CPMS);
+    mw->cooking_time = (elapsed >= mw->cooking_time) ? 0u : mw->cooking_time - elapsed;
+}
+
+/* Compare at the next whole-second boundary of the remaining time */
+static void countdown_arm(MicrowaveCtrl *mw)
+{
+    uint32_t step = mw->cooking_time % 1000u;
+    if (step == 0u) step = 1000u;
+    __HAL_TIM_SET_COMPARE(MW_COUNTDOWN_TIM, MW_COUNTDOWN_CH,
+                          (uint16_t)(s_cd_mark + step * MW_COUNTDOWN_CPMS));
+    __HAL_TIM_CLEAR_IT(MW_COUNTDOWN_TIM,  TIM_IT_CC1);
+    __HAL_TIM_ENABLE_IT(MW_COUNTDOWN_TIM, TIM_IT_CC1);
+}
+
+static void countdown_disarm(void)
+{
+    __HAL_TIM_DISABLE_IT(MW_COUNTDOWN_TIM, TIM_IT_CC1);
+    __HAL_TIM_CLEAR_IT(MW_COUNTDOWN_TIM,   TIM_IT_CC1);
+}
+
+uint8_t countdown_tick(MicrowaveCtrl *mw)
+{
+    countdown_sync(mw);
+    if (mw->cooking_time) countdown_arm(mw);
+    time_display(mw);
+    return (mw->cooking_time == 0u);
+}
+
+/* --- UI: show remaining time (000..999 s) -------------------------------- */
+void time_display(MicrowaveCtrl *mw)
+{
+    /* Numbers use POINT_COLOR/BACK_COLOR; partial seconds round up */
+    POINT_COLOR = BLUE;
+    BACK_COLOR  = WHITE;
+    LCD_ShowNum(5*8, 40, (mw->cooking_time + 999u) / 1000u, 3, 16);
+    LCD_Flush();
+}
+
 /* --- UI: show power string ---------------------------------------------- */
 void power_display(MicrowaveCtrl *mw)
 {
     const char *txt = "Medium";
+    char pct[6];
     if (mw) {
         if      (mw->power == POWER_LOW)    txt = "Low";
         else if (mw->power == POWER_HIGH)   txt = "High";
+        if (mw->power_pct != power_pct_from_level(mw->power)) {
+            /* set by a program stage: show the number */
+            snprintf(pct, sizeof(pct), "%u%%", (unsigned)mw->power_pct);
+            txt = pct;
+        }
     }
     /* Clear small area (x:48..127, y:60..74) -> w=80, h=15 */
     LCD_FillRect(48, 60, 80, 15, WHITE);
     Show_Str(6*8, 60, RED, WHITE, (uint8_t*)txt, 16, 0);
+    LCD_Flush();        /* clear + redraw go out as one window */
+}
+
+/* --- UI: one-line status in the top strip ------------------------------- */
+void status_display(const char *msg)
+{
+    /* clear top strip then message */
+    LCD_FillRect(0, 0, 128, 35, WHITE);
+    Show_Str(0, 20, BLUE, WHITE, (uint8_t*)msg, 16, 0);
+    LCD_Flush();
 }
 
 /* --- Initialization ------------------------------------------------------ */
@@ -62,6 +137,10 @@ void micro_wave_init(MicrowaveCtrl *mw)
     mw->state        = STATE_STANDBY;
     mw->cooking_time = 0;
     mw->power        = POWER_MEDIUM;
+    uint8_t saved;
+    if (Kvs_Get(KVS_KEY_POWER, &saved, 1) && saved <= POWER_HIGH)
+        mw->power = (PowerLevel)saved;      /* last level used */
+    mw->power_pct    = power_pct_from_level(mw->power);
     mw->heating      = HEATING_OFF;
     mw->door         = DOOR_OPEN;
 
@@ -70,6 +149,7 @@ void micro_wave_init(MicrowaveCtrl *mw)
 
     /* ----- Splash ----- */
     Show_Str(0, 20, BLUE, WHITE, (uint8_t*)"Microwave Demo V1.1", 16, 0);
+    LCD_Flush();
     delay_ms(1000);
     /* clear the top strip after splash: w=128, h=35 */
     LCD_FillRect(0, 0, 128, 35, WHITE);
@@ -77,10 +157,7 @@ void micro_wave_init(MicrowaveCtrl *mw)
     /* ----- Static labels & initial values ----- */
     Show_Str(0, 40, BLUE, WHITE, (uint8_t*)"Time:    s", 16, 0);
 
-    /* Numbers use POINT_COLOR/BACK_COLOR */
-    POINT_COLOR = BLUE;
-    BACK_COLOR  = WHITE;
-    LCD_ShowNum(5*8, 40, mw->cooking_time, 3, 16);  /* shows 000..999 */
+    time_display(mw);   /* shows 000..999 */
 
     Show_Str(0, 60, BLUE, WHITE, (uint8_t*)"Power:0000", 16, 0);
     power_display(mw);
@@ -95,10 +172,15 @@ void micro_wave_init(MicrowaveCtrl *mw)
     __HAL_TIM_SET_COMPARE(MW_HEATER_TIM,    MW_HEATER_CH,    0);
     __HAL_TIM_SET_COMPARE(MW_TURNTABLE_TIM, MW_TURNTABLE_CH, 0);
 
-    /* Ensure countdown timer stopped */
-    HAL_TIM_Base_Stop_IT(&htim4);
-    __HAL_TIM_DISABLE_IT(&htim4, TIM_IT_UPDATE);
-    __HAL_TIM_CLEAR_IT(&htim4,   TIM_IT_UPDATE);
+    /* Countdown clock runs from here on; only its compare IT is switched */
+    countdown_disarm();
+    HAL_TIM_Base_Start(MW_COUNTDOWN_TIM);
+}
+
+/* Audible signal; blocks for times * 200 ms. No-op while hbeep is unset. */
+void beep_signal(uint8_t times)
+{
+    if (hbeep.Port) Beep_Beep(&hbeep, times, 100, 100);
 }
 
 /* Prepare to cook: close door + panel LED off */
@@ -118,63 +200,51 @@ void end_cooking(void)
 /* Stop heating/rotation + UI + stop countdown */
 void stop_cooking(MicrowaveCtrl *mw)
 {
-    mw->heating = HEATING_OFF;
-
     /* Heater & turntable off */
+#if MW_HEATER_PID
+    HeaterPid_Stop();
+#elif MW_HEATER_SD
+    HeaterSd_Stop();
+#endif
     __HAL_TIM_SET_COMPARE(MW_HEATER_TIM,    MW_HEATER_CH,    0);
     __HAL_TIM_SET_COMPARE(MW_TURNTABLE_TIM, MW_TURNTABLE_CH, 0);
 
-    /* Stop 1 Hz countdown timer */
-    HAL_TIM_Base_Stop_IT(&htim4);
-    __HAL_TIM_DISABLE_IT(&htim4, TIM_IT_UPDATE);
-    __HAL_TIM_CLEAR_IT(&htim4,   TIM_IT_UPDATE);
+    /* Freeze the countdown to the millisecond (pause keeps the rest) */
+    countdown_disarm();
+    if (mw->heating == HEATING_ON) countdown_sync(mw);
+    mw->heating = HEATING_OFF;
 
-    /* UI: clear top strip then message */
-    LCD_FillRect(0, 0, 128, 35, WHITE);
-    Show_Str(0, 20, BLUE, WHITE, (uint8_t*)"Heating stopped", 16, 0);
+    status_display("Heating stopped");
 }
 
-/* Start heating/rotation + UI + start countdown */
+/* Start heating/rotation + UI + start countdown.
+   When to cook (time set, not already cooking) is decided by the guards in
+   mw_ctrl.c; only the door interlock stays here, as the last line. */
 void start_cooking(MicrowaveCtrl *mw)
 {
-    if ((mw->cooking_time > 0) && (mw->door == DOOR_CLOSED)) {
-
-        mw->heating = HEATING_ON;
-
-        /* Heater duty (TIM3_CH3 @ 1 kHz) */
-        uint16_t duty = heater_duty_from_power(mw->power);
-        __HAL_TIM_SET_COMPARE(MW_HEATER_TIM, MW_HEATER_CH, duty);
-
-        /* Turntable slow (~4% duty on TIM3_CH4 @ 1 kHz) */
-        __HAL_TIM_SET_COMPARE(MW_TURNTABLE_TIM, MW_TURNTABLE_CH, 4);
-
-        /* UI */
-        LCD_FillRect(0, 0, 128, 35, WHITE);
-        Show_Str(0, 20, BLUE, WHITE, (uint8_t*)"Heating", 16, 0);
+    if (mw->door != DOOR_CLOSED) return;
+
+    mw->heating = HEATING_ON;
+
+#if MW_HEATER_PID
+    /* Heater duty follows the temperature loop: N % -> N degC */
+    HeaterPid_Start((int16_t)(mw->power_pct * 10));
+#elif MW_HEATER_SD
+    /* Whole on/off cycles, spread by the sigma-delta scheduler */
+    HeaterSd_Start(mw->power_pct);
+#else
+    /* Heater duty (TIM3_CH3 @ 1 kHz, ARR=99) */
+    uint16_t duty = (uint16_t)((mw->power_pct * 99u + 50u) / 100u);
+    __HAL_TIM_SET_COMPARE(MW_HEATER_TIM, MW_HEATER_CH, duty);
+#endif
 
-        /* Start 1 Hz countdown (TIM4) */
-        __HAL_TIM_CLEAR_IT(&htim4, TIM_IT_UPDATE);
-        __HAL_TIM_ENABLE_IT(&htim4, TIM_IT_UPDATE);
-        HAL_TIM_Base_Start_IT(&htim4);
-    }
-}
+    /* Turntable slow (~4% duty on TIM3_CH4 @ 1 kHz) */
+    __HAL_TIM_SET_COMPARE(MW_TURNTABLE_TIM, MW_TURNTABLE_CH, 4);
 
-/* ===== Tickless Idle hooks (optional) ==================================== */
-#if configUSE_TICKLESS_IDLE
-void PRE_SLEEP_PROCESSING(uint32_t ulExpectedIdleTime)
-{
-    (void)ulExpectedIdleTime;
-    /* Gate off some GPIO clocks as a demo (AHB1 on F4) */
-    __HAL_RCC_GPIOA_CLK_DISABLE();
-    __HAL_RCC_GPIOB_CLK_DISABLE();
-    __HAL_RCC_GPIOC_CLK_DISABLE();
-}
+    /* UI (0 % is a program's rest stage) */
+    status_display(mw->power_pct ? "Heating" : "Resting");
 
-void POST_SLEEP_PROCESSING(uint32_t ulExpectedIdleTime)
-{
-    (void)ulExpectedIdleTime;
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-    __HAL_RCC_GPIOB_CLK_ENABLE();
-    __HAL_RCC_GPIOC_CLK_ENABLE();
+    /* Countdown resumes from now */
+    s_cd_mark = (uint16_t)__HAL_TIM_GET_COUNTER(MW_COUNTDOWN_TIM);
+    countdown_arm(mw);
 }
-#endif
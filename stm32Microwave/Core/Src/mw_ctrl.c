@@ -0,0 +1,540 @@
+#include <stdio.h>
+#include "mw_ctrl.h"
+#include "fsm.h"
+#include "recipe.h"
+#include "kvs.h"
+#include "button.h"
+#include "lowpower.h"
+#include "heater_pid.h"
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Event-driven controller task, see mw_ctrl.h
+******************************************************/
+
+static MicrowaveCtrl *s_mw = NULL;
+static fsm_t          s_fsm;
+static rcp_run_t      s_prog;
+static uint8_t        s_sel;       /* PROG_SETTING choice: 0 manual, n = program n-1 */
+static uint8_t        s_stage_posted; /* a STAGE_* event is queued */
+static QueueHandle_t  s_q  = NULL;
+static StaticQueue_t  s_q_struct;
+static uint8_t        s_q_storage[MW_CTRL_QUEUE_LEN * sizeof(MwEvent)];
+static MemPool        s_msg_pool;
+MEMPOOL_STORAGE(s_msg_mem, MW_MSG_SIZE, MW_MSG_POOL_COUNT);
+static void          *s_msg;          /* payload of the event being dispatched */
+static uint8_t        s_dirty;        /* STORE_* not yet written to flash */
+static uint32_t       s_cycles;       /* completed cooks */
+static int16_t        s_cal;          /* thermistor offset, 0.1 degC */
+
+/* --- event sources -------------------------------------------------------- */
+
+uint8_t MwCtrl_PostMsg(MwEventType type, uint16_t arg, void *msg)
+{
+    MwEvent ev = { (uint8_t)type, 0, arg, msg };
+    BaseType_t ok = pdFALSE;
+
+    if (s_q == NULL) {
+        /* nothing to post to */
+    } else if (__get_IPSR() != 0U) {
+        BaseType_t woken = pdFALSE;
+        ok = xQueueSendFromISR(s_q, &ev, &woken);
+        portYIELD_FROM_ISR(woken);
+    } else {
+        ok = xQueueSend(s_q, &ev, 0);
+    }
+    if (ok != pdTRUE) MemPool_Free(&s_msg_pool, msg);
+    return (ok == pdTRUE);
+}
+
+uint8_t MwCtrl_Post(MwEventType type, uint16_t arg)
+{
+    return MwCtrl_PostMsg(type, arg, NULL);
+}
+
+void *MwCtrl_MsgAlloc(void)
+{
+    return MemPool_Alloc(&s_msg_pool);
+}
+
+void MwCtrl_MsgFree(void *msg)
+{
+    MemPool_Free(&s_msg_pool, msg);
+}
+
+void MwCtrl_MsgStats(MemPoolStats *out, uint8_t reset)
+{
+    MemPool_GetStats(&s_msg_pool, out, reset);
+}
+
+/* PB1 / PB12, first rising edge of a press */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+    Button_Edge(GPIO_Pin);
+}
+
+/* Debounced key events, from TIM7 */
+static void key_event(ButtonId key, ButtonEvent ev)
+{
+    switch (ev) {
+        case BTN_EV_PRESS:   MwCtrl_Post((MwEventType)key, 0);    break;
+        case BTN_EV_RELEASE: MwCtrl_Post(MW_EV_KEY_RELEASE, key); break;
+        case BTN_EV_LONG:    MwCtrl_Post(MW_EV_KEY_LONG, key);    break;
+        case BTN_EV_REPEAT:  MwCtrl_Post(MW_EV_KEY_REPEAT, key);  break;
+        default: break;
+    }
+}
+
+/* TIM4 CH1: the countdown crossed a whole second */
+void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+{
+    if (htim->Instance == TIM4) MwCtrl_Post(MW_EV_TICK, 0);
+}
+
+/* --- state machine -------------------------------------------------------- *
+ * Actions and guards get the MicrowaveCtrl as ctx. Heating only ever happens
+ * inside COOKING: its entry closes the door and starts, its exit stops, so
+ * every way out of COOKING (pause, door, abort, done) turns the heater off.
+ */
+
+static void door_open(void *ctx, uint16_t arg)
+{
+    MicrowaveCtrl *mw = ctx;
+    (void)arg;
+    if (mw->door == DOOR_OPEN) return;
+    end_cooking();
+    mw->door = DOOR_OPEN;
+}
+
+static void door_close(void *ctx, uint16_t arg)
+{
+    MicrowaveCtrl *mw = ctx;
+    (void)arg;
+    if (mw->door == DOOR_CLOSED) return;
+    plan_cooking();
+    mw->door = DOOR_CLOSED;
+}
+
+static uint8_t has_time(void *ctx, uint16_t arg)
+{
+    (void)arg;
+    return ((MicrowaveCtrl *)ctx)->cooking_time > 0;
+}
+
+static uint8_t time_up(void *ctx, uint16_t arg)
+{
+    return !has_time(ctx, arg);
+}
+
+static void set_time(void *ctx, uint16_t arg)
+{
+    MicrowaveCtrl *mw = ctx;
+    mw->cooking_time = ((arg > 999u) ? 999u : arg) * 1000u;
+    time_display(mw);
+}
+
+static uint8_t is_action_key(void *ctx, uint16_t arg)
+{
+    (void)ctx;
+    return arg == BTN_ACTION;
+}
+
+static void step_time(void *ctx, uint16_t arg)
+{
+    MicrowaveCtrl *mw = ctx;
+    (void)arg;
+    /* wraps to 0 past 999 s; a paused cook may have a part second left */
+    mw->cooking_time = (mw->cooking_time + 10000u > 999000u) ? 0u : mw->cooking_time + 10000u;
+    time_display(mw);
+}
+
+/* --- flash store ---
+ * A write may compact the store, and erasing a sector stalls the CPU for
+ * 1-2 s (kvs.h). So actions only mark what changed, and dispatch() writes
+ * it once the machine is in IDLE: never while heating, never between a
+ * START and the heater coming on.
+ */
+enum {
+    STORE_POWER  = 1u << 0,
+    STORE_CYCLES = 1u << 1,
+    STORE_CAL    = 1u << 2,
+    STORE_PROG0  = 1u << 3          /* user slot n: STORE_PROG0 << n */
+};
+
+static void store_flush(const MicrowaveCtrl *mw)
+{
+    uint8_t ok = 1, lvl = (uint8_t)mw->power;
+
+    if (s_dirty & STORE_POWER)  ok &= Kvs_Put(KVS_KEY_POWER, &lvl, 1);
+    if (s_dirty & STORE_CYCLES) ok &= Kvs_Put(KVS_KEY_CYCLES, &s_cycles, sizeof(s_cycles));
+    if (s_dirty & STORE_CAL)    ok &= Kvs_Put(KVS_KEY_THERM_CAL, &s_cal, sizeof(s_cal));
+    for (uint8_t i = 0; i < RCP_USER_SLOTS; i++) {
+        uint8_t n;
+        if (!(s_dirty & (STORE_PROG0 << i))) continue;
+        const rcp_stage_t *st = rcp_user(i, &n);
+        ok &= n ? Kvs_Put((uint16_t)(KVS_KEY_RECIPE0 + i), st, (uint16_t)(n * sizeof(st[0])))
+                : Kvs_Delete((uint16_t)(KVS_KEY_RECIPE0 + i));
+    }
+    s_dirty = 0;
+    if (!ok) printf("ERR FLASH\r\n");
+}
+
+/* Remember the level for the next power-up (no write if unchanged) */
+static void save_power(void *ctx, uint16_t arg)
+{
+    (void)ctx; (void)arg;
+    s_dirty |= STORE_POWER;
+}
+
+/* CAL: the offset applies at once, the flash copy waits for IDLE */
+static void set_cal(void *ctx, uint16_t arg)
+{
+    (void)ctx;
+    s_cal = (int16_t)arg;
+#if MW_HEATER_PID
+    HeaterPid_SetCalibration(s_cal);
+#endif
+    s_dirty |= STORE_CAL;
+}
+
+static void set_power(void *ctx, uint16_t arg)
+{
+    MicrowaveCtrl *mw = ctx;
+    if (arg > POWER_HIGH) return;
+    mw->power     = (PowerLevel)arg;
+    mw->power_pct = power_pct_from_level(mw->power);
+    power_display(mw);
+    save_power(ctx, 0);
+}
+
+static void step_power(void *ctx, uint16_t arg)
+{
+    MicrowaveCtrl *mw = ctx;
+    (void)arg;
+    mw->power     = (PowerLevel)((mw->power + 1) % 3);
+    mw->power_pct = power_pct_from_level(mw->power);
+    power_display(mw);
+}
+
+static void tick(void *ctx, uint16_t arg)
+{
+    (void)arg;
+    if (countdown_tick((MicrowaveCtrl *)ctx)) MwCtrl_Post(MW_EV_DONE, 0);
+}
+
+/* --- programs ---
+ * A program is a chain of COOKING / WAIT_DOOR visits. When one is over,
+ * prog_step() asks the interpreter for the next stage and posts its kind;
+ * the STAGE_* cells move there and stage_load() sets time and power.
+ */
+
+static void prog_beep(void *ctx, uint16_t count)
+{
+    (void)ctx;
+    beep_signal((uint8_t)count);
+}
+
+static void prog_step(void *ctx, uint16_t arg)
+{
+    (void)arg;
+    if (s_stage_posted) return;             /* one advance per stage */
+    const rcp_stage_t *st = rcp_next(&s_prog, prog_beep, ctx);
+    MwEventType ev = (st == NULL)              ? MW_EV_STAGE_END  :
+                     (st->op == RCP_WAIT_DOOR) ? MW_EV_STAGE_WAIT : MW_EV_STAGE_COOK;
+    s_stage_posted = MwCtrl_Post(ev, 0);
+}
+
+static uint8_t prog_running(void *ctx, uint16_t arg)
+{
+    (void)ctx; (void)arg;
+    return rcp_running(&s_prog);
+}
+
+static uint8_t prog_valid(void *ctx, uint16_t arg)
+{
+    (void)ctx;
+    return arg < rcp_count();
+}
+
+static void prog_start(void *ctx, uint16_t arg)
+{
+    rcp_load(&s_prog, (uint8_t)arg);
+    prog_step(ctx, 0);
+}
+
+static uint8_t prog_selected(void *ctx, uint16_t arg)
+{
+    (void)ctx; (void)arg;
+    return s_sel != 0;
+}
+
+static void prog_start_selected(void *ctx, uint16_t arg)
+{
+    (void)arg;
+    uint8_t idx = (uint8_t)(s_sel - 1u);
+    s_sel = 0;
+    prog_start(ctx, idx);
+}
+
+static void prog_show(void *ctx, uint16_t arg)
+{
+    (void)ctx; (void)arg;
+    status_display(s_sel ? rcp_name((uint8_t)(s_sel - 1u)) : "Manual");
+}
+
+static void step_prog(void *ctx, uint16_t arg)
+{
+    s_sel = (uint8_t)((s_sel + 1u) % (rcp_count() + 1u));
+    prog_show(ctx, arg);
+}
+
+static void stage_load(void *ctx, uint16_t arg)
+{
+    MicrowaveCtrl *mw = ctx;
+    (void)arg;
+    if (s_prog.cur == NULL) return;
+    mw->cooking_time = (uint32_t)s_prog.cur->arg * 1000u;
+    mw->power_pct    = s_prog.cur->pct;
+    time_display(mw);
+    power_display(mw);
+}
+
+/* PROGDEF: replace user program `slot` and store it (from IDLE); refused
+   while a program runs, since it may be the one being replaced. This is
+   the one reply to the console command. */
+static void prog_define(void *ctx, uint16_t slot)
+{
+    const MwProgDef *d = s_msg;
+    (void)ctx;
+    if (d == NULL) return;
+    if (rcp_running(&s_prog)) { printf("ERR BUSY\r\n"); return; }
+    if (!rcp_set_user((uint8_t)slot, d->st, d->n)) { printf("ERR STAGE\r\n"); return; }
+    s_dirty |= (uint8_t)(STORE_PROG0 << slot);
+    printf("OK\r\n");
+}
+
+/* Back to manual settings */
+static void prog_clear(void *ctx, uint16_t arg)
+{
+    MicrowaveCtrl *mw = ctx;
+    (void)arg;
+    if (!rcp_running(&s_prog) && mw->power_pct == power_pct_from_level(mw->power)) return;
+    rcp_clear(&s_prog);
+    mw->power_pct = power_pct_from_level(mw->power);
+    power_display(mw);
+}
+
+static uint8_t door_is_open(void *ctx, uint16_t arg)
+{
+    (void)arg;
+    return ((MicrowaveCtrl *)ctx)->door == DOOR_OPEN;
+}
+
+static void door_close_next(void *ctx, uint16_t arg)
+{
+    door_close(ctx, arg);
+    prog_step(ctx, arg);
+}
+
+static void wait_door_entry(void *ctx, uint16_t arg)
+{
+    (void)ctx; (void)arg;
+    status_display("Open+close door");
+}
+
+/* Nothing runs off the bus clocks in IDLE, so the idle task may STOP;
+   ACTIVE keeps TIM3/TIM4 going and only allows WFI */
+static void idle_entry(void *ctx, uint16_t arg)
+{
+    (void)ctx; (void)arg;
+    LowPower_SetMode(LP_MODE_STOP);
+}
+
+static void active_entry(void *ctx, uint16_t arg)
+{
+    (void)ctx; (void)arg;
+    LowPower_SetMode(LP_MODE_SLEEP);
+}
+
+static void cooking_entry(void *ctx, uint16_t arg)
+{
+    door_close(ctx, arg);
+    start_cooking((MicrowaveCtrl *)ctx);
+}
+
+static void cooking_exit(void *ctx, uint16_t arg)
+{
+    (void)arg;
+    stop_cooking((MicrowaveCtrl *)ctx);
+}
+
+static void paused_entry(void *ctx, uint16_t arg)
+{
+    (void)ctx; (void)arg;
+    status_display("Paused");
+}
+
+static void door_open_entry(void *ctx, uint16_t arg)
+{
+    door_open(ctx, arg);
+    status_display("Door open");
+}
+
+static void completed_entry(void *ctx, uint16_t arg)
+{
+    door_open(ctx, arg);
+    status_display("Done");
+    s_cycles++;
+    s_dirty |= STORE_CYCLES;
+}
+
+static const fsm_state_t k_states[STATE_COUNT] = {
+    [STATE_IDLE]          = { FSM_NONE,     STATE_STANDBY, idle_entry,      NULL         },
+    [STATE_STANDBY]       = { STATE_IDLE,   FSM_NONE,      NULL,            NULL         },
+    [STATE_TIME_SETTING]  = { STATE_IDLE,   FSM_NONE,      NULL,            NULL         },
+    [STATE_POWER_SETTING] = { STATE_IDLE,   FSM_NONE,      NULL,            save_power   },
+    [STATE_PROG_SETTING]  = { STATE_IDLE,   FSM_NONE,      prog_show,       NULL         },
+    [STATE_COMPLETED]     = { STATE_IDLE,   FSM_NONE,      completed_entry, NULL         },
+    [STATE_ACTIVE]        = { FSM_NONE,     STATE_COOKING, active_entry,    NULL         },
+    [STATE_COOKING]       = { STATE_ACTIVE, FSM_NONE,      cooking_entry,   cooking_exit },
+    [STATE_PAUSED]        = { STATE_ACTIVE, FSM_NONE,      paused_entry,    NULL         },
+    [STATE_DOOR_OPEN]     = { STATE_ACTIVE, FSM_NONE,      door_open_entry, NULL         },
+    [STATE_WAIT_DOOR]     = { STATE_ACTIVE, FSM_NONE,      wait_door_entry, NULL         },
+};
+
+/* Empty cells fall through to the parent; unhandled at the top is dropped */
+static const fsm_trans_t k_table[STATE_COUNT][MW_EV_COUNT] = {
+    [STATE_IDLE] = {
+        [MW_EV_KEY_ACTION]  = FSM_TRAN(STATE_COOKING, has_time, NULL),
+        [MW_EV_SET_TIME]    = FSM_INT(NULL, set_time),
+        [MW_EV_SET_POWER]   = FSM_INT(NULL, set_power),
+        [MW_EV_DOOR_OPEN]   = FSM_INT(NULL, door_open),
+        [MW_EV_DOOR_CLOSE]  = FSM_INT(NULL, door_close),
+        [MW_EV_START]       = FSM_TRAN(STATE_COOKING, has_time, NULL),
+        [MW_EV_PROGRAM]     = FSM_INT(prog_valid, prog_start),
+        [MW_EV_STAGE_COOK]  = FSM_TRAN(STATE_COOKING, prog_running, stage_load),
+        [MW_EV_STAGE_WAIT]  = FSM_TRAN(STATE_WAIT_DOOR, prog_running, NULL),
+        [MW_EV_STAGE_END]   = FSM_INT(NULL, prog_clear),
+        [MW_EV_PROGDEF]     = FSM_INT(NULL, prog_define),
+        [MW_EV_SET_CAL]     = FSM_INT(NULL, set_cal),
+    },
+    [STATE_STANDBY] = {
+        [MW_EV_KEY_MODE]    = FSM_TRAN(STATE_TIME_SETTING, NULL, NULL),
+        [MW_EV_KEY_ACTION]  = FSM_INT(prog_selected, prog_start_selected),
+    },
+    [STATE_TIME_SETTING] = {
+        [MW_EV_KEY_MODE]    = FSM_TRAN(STATE_POWER_SETTING, NULL, NULL),
+        [MW_EV_KEY_ACTION]  = FSM_INT(NULL, step_time),
+        [MW_EV_KEY_LONG]    = FSM_INT(is_action_key, step_time),
+        [MW_EV_KEY_REPEAT]  = FSM_INT(is_action_key, step_time),
+    },
+    [STATE_POWER_SETTING] = {
+        [MW_EV_KEY_MODE]    = FSM_TRAN(STATE_PROG_SETTING, NULL, NULL),
+        [MW_EV_KEY_ACTION]  = FSM_INT(NULL, step_power),
+    },
+    [STATE_PROG_SETTING] = {
+        [MW_EV_KEY_MODE]    = FSM_TRAN(STATE_STANDBY, NULL, NULL),
+        [MW_EV_KEY_ACTION]  = FSM_INT(NULL, step_prog),
+    },
+    [STATE_COMPLETED] = {                           /* any key acknowledges */
+        [MW_EV_KEY_MODE]    = FSM_TRAN(STATE_STANDBY, NULL, NULL),
+        [MW_EV_KEY_ACTION]  = FSM_TRAN(STATE_STANDBY, NULL, NULL),
+    },
+    [STATE_ACTIVE] = {
+        [MW_EV_KEY_MODE]    = FSM_TRAN(STATE_STANDBY, NULL, prog_clear),
+        [MW_EV_STOP]        = FSM_TRAN(STATE_STANDBY, NULL, prog_clear),
+        [MW_EV_DOOR_OPEN]   = FSM_TRAN(STATE_DOOR_OPEN, NULL, NULL),
+        [MW_EV_STAGE_COOK]  = FSM_TRAN(STATE_COOKING, prog_running, stage_load),
+        [MW_EV_STAGE_WAIT]  = FSM_TRAN(STATE_WAIT_DOOR, prog_running, NULL),
+        [MW_EV_STAGE_END]   = FSM_TRAN(STATE_COMPLETED, NULL, prog_clear),
+        [MW_EV_PROGDEF]     = FSM_INT(NULL, prog_define),
+        [MW_EV_SET_CAL]     = FSM_INT(NULL, set_cal),
+        /* paused in the instant the stage ran out: its DONE was dropped */
+        [MW_EV_KEY_ACTION]  = FSM_INT(time_up, prog_step),
+        [MW_EV_START]       = FSM_INT(time_up, prog_step),
+    },
+    [STATE_COOKING] = {
+        [MW_EV_TICK]        = FSM_INT(NULL, tick),
+        [MW_EV_DONE]        = FSM_INT(NULL, prog_step),     /* next stage or end */
+        [MW_EV_KEY_ACTION]  = FSM_TRAN(STATE_PAUSED, NULL, NULL),
+    },
+    [STATE_PAUSED] = {
+        [MW_EV_KEY_ACTION]  = FSM_TRAN(STATE_COOKING, has_time, NULL),
+        [MW_EV_START]       = FSM_TRAN(STATE_COOKING, has_time, NULL),
+    },
+    [STATE_DOOR_OPEN] = {                           /* close it first */
+        [MW_EV_DOOR_OPEN]   = FSM_INT(NULL, NULL),
+        [MW_EV_KEY_ACTION]  = FSM_INT(NULL, NULL),
+        [MW_EV_START]       = FSM_INT(NULL, NULL),
+        [MW_EV_DOOR_CLOSE]  = FSM_TRAN(STATE_PAUSED, NULL, door_close),
+    },
+    [STATE_WAIT_DOOR] = {
+        [MW_EV_DOOR_OPEN]   = FSM_INT(NULL, door_open),
+        [MW_EV_DOOR_CLOSE]  = FSM_INT(door_is_open, door_close_next),
+        [MW_EV_KEY_ACTION]  = FSM_INT(NULL, prog_step),     /* skip */
+        [MW_EV_START]       = FSM_INT(NULL, prog_step),
+    },
+};
+
+static const fsm_def_t k_mw_fsm = {
+    &k_states[0], &k_table[0][0], STATE_COUNT, MW_EV_COUNT
+};
+
+/* Safety invariants, checked after every event */
+static void check_invariants(const MicrowaveCtrl *mw)
+{
+    uint32_t duty = __HAL_TIM_GET_COMPARE(MW_HEATER_TIM, MW_HEATER_CH);
+    configASSERT(!(mw->door == DOOR_OPEN && duty != 0u));
+    configASSERT((mw->heating == HEATING_ON) == (mw->state == STATE_COOKING));
+}
+
+static void dispatch(MicrowaveCtrl *mw, const MwEvent *ev)
+{
+    if (ev->type >= MW_EV_STAGE_COOK && ev->type <= MW_EV_STAGE_END) s_stage_posted = 0;
+    s_msg = ev->msg;
+    fsm_dispatch(&s_fsm, ev->type, ev->arg);
+    s_msg = NULL;
+    MemPool_Free(&s_msg_pool, ev->msg);
+    mw->state = (MicrowaveState)s_fsm.cur;
+    check_invariants(mw);
+    if (s_dirty && fsm_in(&s_fsm, STATE_IDLE)) store_flush(mw);
+}
+
+/* --- task ----------------------------------------------------------------- */
+
+void MwCtrl_Init(MicrowaveCtrl *mw)
+{
+    s_mw = mw;
+    MemPool_Init(&s_msg_pool, s_msg_mem, MW_MSG_SIZE, MW_MSG_POOL_COUNT);
+    Button_Init(key_event);
+    fsm_init(&s_fsm, &k_mw_fsm, mw->state, mw);
+    LowPower_SetMode(fsm_in(&s_fsm, STATE_IDLE) ? LP_MODE_STOP : LP_MODE_SLEEP);
+
+    s_dirty  = 0;
+    s_cycles = 0;
+    s_cal    = 0;
+    Kvs_Get(KVS_KEY_CYCLES, &s_cycles, sizeof(s_cycles));
+    Kvs_Get(KVS_KEY_THERM_CAL, &s_cal, sizeof(s_cal));
+
+    /* user programs saved by PROGDEF */
+    for (uint8_t i = 0; i < RCP_USER_SLOTS; i++) {
+        rcp_stage_t st[RCP_USER_STAGES];
+        uint16_t len = Kvs_Get((uint16_t)(KVS_KEY_RECIPE0 + i), st, sizeof(st));
+        if (len && len <= sizeof(st) && len % sizeof(st[0]) == 0)
+            rcp_set_user(i, st, (uint8_t)(len / sizeof(st[0])));
+    }
+    if (s_q == NULL)
+        s_q = xQueueCreateStatic(MW_CTRL_QUEUE_LEN, sizeof(MwEvent), s_q_storage, &s_q_struct);
+}
+
+void MwCtrl_Run(void)
+{
+    MwEvent ev;
+    for (;;) {
+        if (xQueueReceive(s_q, &ev, portMAX_DELAY) == pdTRUE)
+            dispatch(s_mw, &ev);
+    }
+}
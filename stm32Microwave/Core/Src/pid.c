@@ -0,0 +1,45 @@
+#include "pid.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Fixed-point PID, see pid.h
+******************************************************/
+
+static inline int64_t clamp64(int64_t v, int64_t lo, int64_t hi)
+{
+    return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+
+void pid_reset(pid_q16_t *p, int32_t meas, int32_t out)
+{
+    p->integ     = 0;
+    p->prev_meas = meas;
+    p->out       = out;
+}
+
+int32_t pid_step(pid_q16_t *p, int32_t setpoint, int32_t meas)
+{
+    int32_t err = setpoint - meas;
+    int64_t pt  = (int64_t)p->kp * err;
+    int64_t dt  = -(int64_t)p->kd * (meas - p->prev_meas);
+    p->prev_meas = meas;
+
+    int64_t integ = p->integ + (int64_t)p->ki * err;
+    integ = clamp64(integ, (int64_t)p->i_min << 16, (int64_t)p->i_max << 16);
+
+    int64_t u = (pt + integ + dt + 0x8000) >> 16;
+
+    if (p->aw == PID_AW_CONDITIONAL &&
+        ((u > p->out_max && err > 0) || (u < p->out_min && err < 0))) {
+        u = (pt + p->integ + dt + 0x8000) >> 16;    /* keep the old integral */
+    } else {
+        p->integ = integ;
+    }
+
+    u = clamp64(u, p->out_min, p->out_max);
+    if (p->slew > 0)
+        u = clamp64(u, (int64_t)p->out - p->slew, (int64_t)p->out + p->slew);
+
+    p->out = (int32_t)u;
+    return p->out;
+}
@@ -0,0 +1,143 @@
+#include <string.h>
+#include "prof.h"
+#include "retarget.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : DWT profiler and snapshot frame, see prof.h
+******************************************************/
+
+uint16_t Prof_Crc16(uint16_t crc, const uint8_t *p, uint32_t n)
+{
+    while (n--) {
+        crc ^= (uint16_t)(*p++ << 8);
+        for (uint8_t b = 0; b < 8u; b++)
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+#if MW_PROF
+
+#define PROF_NAME_LEN   16u
+#define PROF_HDR_SIZE   24u
+#define PROF_TASK_SIZE  (PROF_NAME_LEN + 8u)
+#define PROF_IRQ_SIZE   12u
+#define PROF_FRAME_MAX  (PROF_HDR_SIZE + PROF_MAX_TASKS * PROF_TASK_SIZE + PROF_IRQ_COUNT * PROF_IRQ_SIZE + 2u)
+
+typedef struct {
+    uint32_t calls;
+    uint64_t cycles;
+} ProfIrqStat;
+
+static uint32_t     s_cyc_last;        /* CYCCNT at the last read */
+static uint32_t     s_cyc_hi;          /* its wraps */
+static ProfIrqStat  s_irq[PROF_IRQ_COUNT];
+static TaskStatus_t s_tasks[PROF_MAX_TASKS];
+static uint8_t      s_frame[PROF_FRAME_MAX];
+
+void Prof_Init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+    s_cyc_last = DWT->CYCCNT;
+}
+
+uint32_t Prof_RunTime(void)
+{
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    uint32_t now = DWT->CYCCNT;
+    if (now < s_cyc_last) s_cyc_hi++;
+    s_cyc_last = now;
+    uint64_t t = ((uint64_t)s_cyc_hi << 32) | now;
+    __set_PRIMASK(pm);
+    return (uint32_t)(t >> PROF_RUNTIME_SHIFT);
+}
+
+/* Only the handler itself updates its slot; a handler does not nest with
+   itself, so the 64-bit add needs no lock against other IRQs */
+void Prof_IrqAdd(ProfIrq id, uint32_t cycles)
+{
+    s_irq[id].calls++;
+    s_irq[id].cycles += cycles;
+}
+
+/* --- snapshot ------------------------------------------------------------- */
+
+static uint8_t *put(uint8_t *p, const void *v, uint32_t n)
+{
+    memcpy(p, v, n);
+    return p + n;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) { return put(p, &v, 4u); }
+static uint8_t *put16(uint8_t *p, uint16_t v) { return put(p, &v, 2u); }
+static uint8_t *put8(uint8_t *p, uint8_t v)   { *p = v; return p + 1; }
+
+static uint32_t frame_build(void)
+{
+    uint32_t total = 0;
+    UBaseType_t n = uxTaskGetSystemState(s_tasks, PROF_MAX_TASKS, &total);
+    uint8_t *p = s_frame;
+
+    p = put(p, "PRF1", 4u);
+    p = put16(p, 0);                                /* length, below */
+    p = put8(p, (uint8_t)n);
+    p = put8(p, PROF_IRQ_COUNT);
+    p = put32(p, (uint32_t)xTaskGetTickCount());
+    p = put32(p, SystemCoreClock);
+    p = put32(p, total);
+    p = put8(p, PROF_RUNTIME_SHIFT);
+    p = put8(p, 0); p = put8(p, 0); p = put8(p, 0);
+
+    for (UBaseType_t i = 0; i < n; i++) {
+        char name[PROF_NAME_LEN] = { 0 };
+        strncpy(name, s_tasks[i].pcTaskName, PROF_NAME_LEN);
+        p = put(p, name, PROF_NAME_LEN);
+        p = put32(p, s_tasks[i].ulRunTimeCounter);
+        p = put16(p, (uint16_t)s_tasks[i].usStackHighWaterMark);
+        p = put8(p, (uint8_t)s_tasks[i].uxCurrentPriority);
+        p = put8(p, (uint8_t)s_tasks[i].eCurrentState);
+    }
+
+    for (uint8_t i = 0; i < PROF_IRQ_COUNT; i++) {
+        ProfIrqStat st;
+        uint32_t pm = __get_PRIMASK();
+        __disable_irq();
+        st = s_irq[i];
+        __set_PRIMASK(pm);
+        p = put32(p, st.calls);
+        p = put32(p, (uint32_t)st.cycles);
+        p = put32(p, (uint32_t)(st.cycles >> 32));
+    }
+
+    uint16_t len = (uint16_t)(p - s_frame + 2u);
+    put16(&s_frame[4], len);
+    put16(p, Prof_Crc16(0xFFFFu, s_frame, (uint32_t)(p - s_frame)));
+    return len;
+}
+
+uint8_t Prof_Snapshot(void)
+{
+    uint32_t len = frame_build();
+    TickType_t t0 = xTaskGetTickCount();
+
+    /* one write, so console text cannot land inside the frame */
+    while (Retarget_Room() < len) {
+        if (xTaskGetTickCount() - t0 > pdMS_TO_TICKS(1000)) return 0;
+        vTaskDelay(1);
+    }
+    return Retarget_Write(s_frame, (int)len) == (int)len;
+}
+
+#else /* !MW_PROF */
+
+void     Prof_Init(void) { }
+uint32_t Prof_RunTime(void) { return 0; }
+void     Prof_IrqAdd(ProfIrq id, uint32_t cycles) { (void)id; (void)cycles; }
+uint8_t  Prof_Snapshot(void) { return 0; }
+
+#endif /* MW_PROF */
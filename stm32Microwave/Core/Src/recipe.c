@@ -0,0 +1,106 @@
+#include <stddef.h>
+#include <string.h>
+#include "recipe.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Program interpreter and the preloaded programs, see recipe.h
+******************************************************/
+
+static const rcp_stage_t k_defrost[] = {
+    RCP_STAGE_COOK(30, 180),
+    RCP_STAGE_REST(60),
+    RCP_STAGE_COOK(80, 120),
+    RCP_STAGE_BEEP(3),
+    RCP_STAGE_END
+};
+
+static const rcp_stage_t k_reheat[] = {
+    RCP_STAGE_COOK(70, 60),
+    RCP_STAGE_BEEP(1),
+    RCP_STAGE_WAIT_DOOR,                /* stir */
+    RCP_STAGE_COOK(70, 60),
+    RCP_STAGE_BEEP(3),
+    RCP_STAGE_END
+};
+
+static const rcp_stage_t k_popcorn[] = {
+    RCP_STAGE_COOK(100, 150),
+    RCP_STAGE_BEEP(3),
+    RCP_STAGE_END
+};
+
+static const rcp_program_t k_builtin[] = {
+    { "Defrost", k_defrost },
+    { "Reheat",  k_reheat  },
+    { "Popcorn", k_popcorn },
+};
+#define RCP_BUILTIN  (sizeof(k_builtin) / sizeof(k_builtin[0]))
+
+/* Zero-filled = RCP_END: an undefined slot ends at once */
+static rcp_stage_t s_user[RCP_USER_SLOTS][RCP_USER_STAGES + 1u];
+static const char  k_user_name[][7] = { "User 1", "User 2", "User 3", "User 4" };
+
+uint8_t rcp_count(void)
+{
+    return (uint8_t)(RCP_BUILTIN + RCP_USER_SLOTS);
+}
+
+const char *rcp_name(uint8_t index)
+{
+    if (index < RCP_BUILTIN) return k_builtin[index].name;
+    index = (uint8_t)(index - RCP_BUILTIN);
+    return (index < RCP_USER_SLOTS && index < sizeof(k_user_name) / sizeof(k_user_name[0]))
+           ? k_user_name[index] : "?";
+}
+
+uint8_t rcp_set_user(uint8_t slot, const rcp_stage_t *st, uint8_t n)
+{
+    if (slot >= RCP_USER_SLOTS || n > RCP_USER_STAGES) return 0;
+    for (uint8_t i = 0; i < n; i++) {
+        if (st[i].op == RCP_COOK && st[i].pct <= 100u && st[i].arg <= RCP_COOK_MAX_S) continue;
+        if (st[i].op == RCP_BEEP || st[i].op == RCP_WAIT_DOOR) continue;
+        return 0;
+    }
+    memset(s_user[slot], 0, sizeof(s_user[slot]));
+    memcpy(s_user[slot], st, n * sizeof(*st));
+    return 1;
+}
+
+const rcp_stage_t *rcp_user(uint8_t slot, uint8_t *n)
+{
+    if (slot >= RCP_USER_SLOTS) return NULL;
+    for (*n = 0; s_user[slot][*n].op != RCP_END; (*n)++) { }
+    return s_user[slot];
+}
+
+uint8_t rcp_load(rcp_run_t *r, uint8_t index)
+{
+    if (index >= rcp_count()) return 0;
+    r->pc  = (index < RCP_BUILTIN) ? k_builtin[index].stages
+                                   : s_user[index - RCP_BUILTIN];
+    r->cur = NULL;
+    return 1;
+}
+
+const rcp_stage_t *rcp_next(rcp_run_t *r, rcp_beep_t beep, void *ctx)
+{
+    if (r->pc == NULL) return NULL;
+
+    while (r->pc->op == RCP_BEEP || (r->pc->op == RCP_COOK && r->pc->arg == 0u)) {
+        if (r->pc->op == RCP_BEEP && beep) beep(ctx, r->pc->arg);
+        r->pc++;
+    }
+    if (r->pc->op != RCP_COOK && r->pc->op != RCP_WAIT_DOOR) {   /* END */
+        rcp_clear(r);
+        return NULL;
+    }
+    r->cur = r->pc++;
+    return r->cur;
+}
+
+void rcp_clear(rcp_run_t *r)
+{
+    r->pc  = NULL;
+    r->cur = NULL;
+}
@@ -8,24 +8,127 @@
   * This file overrides the low-level _write() used by newlib/printf
   * so you can use printf() over UART without enabling semihosting.
   *
+  * Output is copied into a RAM ring and drained by USART2_TX DMA
+  * (DMA1_Stream6), so _write() returns right away instead of holding the
+  * caller for ~87 us per byte at 115200 baud. If the ring is full the excess
+  * is dropped and counted (Retarget_Dropped()). A transfer the UART refuses
+  * (not initialised yet, still busy) is started again by Retarget_Poll() from
+  * the 1 ms HAL tick, so queued output does not wait for the next write.
+  *
   * Add this file to your project and make sure USART2 is initialized
   * in CubeMX (MX_USART2_UART_Init).
   ******************************************************************************
   */
 
 #include "usart.h"
+#include "retarget.h"
+#include "trace.h"
 #include <stdio.h>
+#include <string.h>
 
 extern UART_HandleTypeDef huart2;  // generated by CubeMX
 
+/* Free-running indices: writers reserve up to resv and copy with IRQs
+ * enabled; head (what the DMA may send) catches up with resv when the last
+ * writer in progress is done. tail is advanced by the DMA complete callback;
+ * bytes [tail, tail + tx_len) are on the wire. */
+static uint8_t           s_ring[RETARGET_TX_RING];
+static volatile uint32_t s_resv = 0;
+static volatile uint32_t s_head = 0;
+static volatile uint32_t s_tail = 0;
+static volatile uint16_t s_tx_len = 0;      /* 0: DMA idle */
+static volatile uint8_t  s_writers = 0;     /* reserved, not yet copied */
+static volatile uint32_t s_dropped = 0;
+
+#define RING_MASK  (RETARGET_TX_RING - 1U)
+
+/* Start DMA on the next contiguous stretch. PRIMASK held by the caller. */
+static void tx_kick(void)
+{
+    if (s_tx_len || s_head == s_tail) return;
+
+    uint32_t idx   = s_tail & RING_MASK;
+    uint32_t chunk = s_head - s_tail;
+    if (chunk > RETARGET_TX_RING - idx) chunk = RETARGET_TX_RING - idx;  /* up to the wrap */
+
+    s_tx_len = (uint16_t)chunk;
+    if (HAL_UART_Transmit_DMA(&huart2, &s_ring[idx], (uint16_t)chunk) != HAL_OK)
+        s_tx_len = 0;           /* UART not up yet: Retarget_Poll() tries again */
+    else
+        trace_put(TRACE_EV_UART_TX, 0, (uint16_t)chunk);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance != USART2) return;
+    trace_put(TRACE_EV_UART_TX_DONE, 0, 0);
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    s_tail  += s_tx_len;
+    s_tx_len = 0;
+    tx_kick();
+    __set_PRIMASK(pm);
+}
+
+int Retarget_Write(const void *buf, int len)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+    if (len <= 0) return 0;
+
+    /* Callers may be any task or ISR. Only the reservation and the commit
+     * run under PRIMASK; the copy does not. */
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    uint32_t room = RETARGET_TX_RING - (s_resv - s_tail);
+    uint32_t n    = ((uint32_t)len < room) ? (uint32_t)len : room;
+    uint32_t at   = s_resv;
+    s_resv    += n;
+    s_dropped += (uint32_t)len - n;
+    s_writers++;
+    __set_PRIMASK(pm);
+
+    uint32_t idx   = at & RING_MASK;
+    uint32_t first = (n < RETARGET_TX_RING - idx) ? n : RETARGET_TX_RING - idx;
+    memcpy(&s_ring[idx], p, first);
+    memcpy(s_ring, p + first, n - first);                  /* past the wrap */
+
+    pm = __get_PRIMASK();
+    __disable_irq();
+    if (--s_writers == 0) s_head = s_resv;  /* last one out publishes them all */
+    tx_kick();
+    __set_PRIMASK(pm);
+    return (int)n;
+}
+
+void Retarget_Poll(void)
+{
+    if (s_tx_len || s_head == s_tail) return;   /* in flight, or nothing queued */
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    tx_kick();
+    __set_PRIMASK(pm);
+}
+
+uint32_t Retarget_Room(void)
+{
+    return RETARGET_TX_RING - (s_resv - s_tail);
+}
+
+uint32_t Retarget_Dropped(void)
+{
+    return s_dropped;
+}
+
 /**
   * @brief  Retargets the C library printf function to the USART.
   * @param  file Unused
   * @param  ptr  Pointer to string
   * @param  len  String length
-  * @retval Number of characters written
+  * @retval Number of characters written (dropped bytes count as written so
+  *         printf does not retry into a full ring)
   */
 int _write(int file, char *ptr, int len) {
-    HAL_UART_Transmit(&huart2, (uint8_t*)ptr, len, HAL_MAX_DELAY);
+    (void)file;
+    Retarget_Write(ptr, len);
     return len;
 }
@@ -0,0 +1,107 @@
+#include "rtos_bench.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include "rtos_mem.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Context switch latency benchmark, see rtos_bench.h
+******************************************************/
+
+#if MW_RTOS_BENCH
+
+static TaskHandle_t      s_rx = NULL, s_tx = NULL, s_caller = NULL;
+static volatile uint32_t s_t0;
+static RtosBenchMode     s_mode;
+static uint32_t          s_rounds;
+static uint64_t          s_sum;
+static RtosBenchStats    s_st;
+
+static void bench_rx_task(void *argument)
+{
+    (void)argument;
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t dt = DWT->CYCCNT - s_t0;
+        if (dt < s_st.min) s_st.min = dt;
+        if (dt > s_st.max) s_st.max = dt;
+        s_sum += dt;
+    }
+}
+
+static void bench_tx_task(void *argument)
+{
+    (void)argument;
+    volatile float x = 1.0f;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        s_st  = (RtosBenchStats){ .rounds = s_rounds, .min = UINT32_MAX };
+        s_sum = 0;
+
+        /* FPCA stays set once a thread has used the FPU; clear it so the
+           integer run switches out with a basic frame (x lives in memory) */
+        if (s_mode == RTOS_BENCH_INT) {
+            __set_CONTROL(__get_CONTROL() & ~CONTROL_FPCA_Msk);
+            __ISB();
+        }
+        for (uint32_t i = 0; i < s_rounds; i++) {
+            if (s_mode == RTOS_BENCH_FPU) x = x * 1.0001f;
+            s_t0 = DWT->CYCCNT;
+            xTaskNotifyGive(s_rx);
+        }
+        s_st.avg = (uint32_t)(s_sum / s_rounds);
+        xTaskNotifyGive(s_caller);
+    }
+}
+
+static uint8_t bench_start(void)
+{
+    static StaticTask_t rx_tcb, tx_tcb;
+    RTOS_STACK(rx_stack, 128 * 4);
+    RTOS_STACK(tx_stack, 128 * 4);
+    static const osThreadAttr_t rx_attr = {
+        .name = "benchRx",
+        .cb_mem = &rx_tcb, .cb_size = sizeof(rx_tcb),
+        .stack_mem = rx_stack, .stack_size = sizeof(rx_stack),
+        .priority = (osPriority_t) RTOS_PRIO(osPriorityRealtime),
+    };
+    static const osThreadAttr_t tx_attr = {
+        .name = "benchTx",
+        .cb_mem = &tx_tcb, .cb_size = sizeof(tx_tcb),
+        .stack_mem = tx_stack, .stack_size = sizeof(tx_stack),
+        .priority = (osPriority_t) RTOS_PRIO(osPriorityHigh7),     /* one level below benchRx */
+    };
+    if (!s_rx) s_rx = (TaskHandle_t)osThreadNew(bench_rx_task, NULL, &rx_attr);
+    if (!s_tx) s_tx = (TaskHandle_t)osThreadNew(bench_tx_task, NULL, &tx_attr);
+    return s_rx && s_tx;
+}
+
+uint8_t RtosBench_Run(RtosBenchMode mode, uint32_t rounds, RtosBenchStats *out)
+{
+    if (rounds == 0 || rounds > RTOS_BENCH_MAX_ROUNDS || !bench_start()) return 0;
+
+    /* lcd.c normally has it running already; CYCCNT is not reset because
+       delay_us() may be counting on it */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+
+    s_caller = xTaskGetCurrentTaskHandle();
+    s_mode   = mode;
+    s_rounds = rounds;
+    ulTaskNotifyTake(pdTRUE, 0);
+    xTaskNotifyGive(s_tx);
+    if (!ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000))) return 0;
+    *out = s_st;
+    return 1;
+}
+
+#else /* !MW_RTOS_BENCH */
+
+uint8_t RtosBench_Run(RtosBenchMode mode, uint32_t rounds, RtosBenchStats *out)
+{
+    (void)mode; (void)rounds; (void)out;
+    return 0;
+}
+
+#endif /* MW_RTOS_BENCH */
@@ -0,0 +1,128 @@
+#include <string.h>
+#include "trace.h"
+#include "prof.h"
+#include "retarget.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Event trace ring and dump frame, see trace.h
+******************************************************/
+
+#if (TRACE_LEN & (TRACE_LEN - 1u)) != 0u
+#error "TRACE_LEN must be a power of two"
+#endif
+
+#if MW_TRACE
+
+/* CPU only, never a DMA source: CCM (not zeroed, the index says what is valid) */
+TraceRec          g_trace_buf[TRACE_LEN] __attribute__((section(".ccmbss"), aligned(8)));
+volatile uint32_t g_trace_idx;
+volatile uint8_t  g_trace_on = 1;
+
+#define TRACE_NAME_LEN   16u
+#define TRACE_COST_RUNS  32u
+
+static TaskStatus_t s_tasks[PROF_MAX_TASKS];
+static uint16_t     s_crc;
+
+void Trace_Enable(uint8_t on)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+    g_trace_on = on ? 1u : 0u;
+}
+
+/* Feed the console a piece at a time: the frame is bigger than its ring */
+static uint8_t out(const void *v, uint32_t n)
+{
+    const uint8_t *p = (const uint8_t *)v;
+    TickType_t t0 = xTaskGetTickCount();
+
+    s_crc = Prof_Crc16(s_crc, p, n);
+    while (n) {
+        uint32_t k = Retarget_Room();
+        if (k == 0) {
+            if (xTaskGetTickCount() - t0 > pdMS_TO_TICKS(1000)) return 0;
+            vTaskDelay(1);
+            continue;
+        }
+        if (k > n) k = n;
+        if (Retarget_Write(p, (int)k) != (int)k) return 0;
+        p += k;
+        n -= k;
+        t0 = xTaskGetTickCount();
+    }
+    return 1;
+}
+
+static uint8_t out32(uint32_t v) { return out(&v, 4u); }
+static uint8_t out16(uint16_t v) { return out(&v, 2u); }
+static uint8_t out8(uint8_t v)   { return out(&v, 1u); }
+
+uint8_t Trace_Dump(void)
+{
+    uint8_t was_on = g_trace_on;
+    g_trace_on = 0;
+
+    uint32_t    written = g_trace_idx;
+    uint32_t    nrec    = (written < TRACE_LEN) ? written : TRACE_LEN;
+    UBaseType_t ntask   = uxTaskGetSystemState(s_tasks, PROF_MAX_TASKS, NULL);
+    uint32_t    len     = 20u + ntask * (2u + TRACE_NAME_LEN) + nrec * sizeof(TraceRec) + 2u;
+
+    uint8_t ok = 1;
+    s_crc = 0xFFFFu;
+    ok &= out("TRC1", 4u);
+    ok &= out32(len);
+    ok &= out32(SystemCoreClock);
+    ok &= out32(written);
+    ok &= out16((uint16_t)nrec);
+    ok &= out8((uint8_t)ntask);
+    ok &= out8(0);
+
+    for (UBaseType_t i = 0; ok && i < ntask; i++) {
+        char name[TRACE_NAME_LEN] = { 0 };
+        strncpy(name, s_tasks[i].pcTaskName, TRACE_NAME_LEN);
+        ok &= out16((uint16_t)s_tasks[i].xTaskNumber);
+        ok &= out(name, TRACE_NAME_LEN);
+    }
+
+    /* oldest first: the ring may have wrapped */
+    uint32_t first = (written - nrec) & (TRACE_LEN - 1u);
+    uint32_t n1    = TRACE_LEN - first;
+    if (n1 > nrec) n1 = nrec;
+    if (ok) ok &= out(&g_trace_buf[first], n1 * sizeof(TraceRec));
+    if (ok) ok &= out(&g_trace_buf[0], (nrec - n1) * sizeof(TraceRec));
+    if (ok) ok &= out16(s_crc);
+
+    g_trace_idx = 0;
+    g_trace_on  = was_on;
+    return ok;
+}
+
+/* Leaves TRACE_COST_RUNS TRACE_EV_MARK events in the ring */
+uint32_t Trace_Cost(void)
+{
+    uint8_t was_on = g_trace_on;
+    Trace_Enable(1);
+
+    uint32_t pm = __get_PRIMASK();
+    __disable_irq();
+    uint32_t t0 = DWT->CYCCNT;
+    for (uint32_t i = 0; i < TRACE_COST_RUNS; i++)
+        trace_put(TRACE_EV_MARK, 0, (uint16_t)i);
+    uint32_t dt = DWT->CYCCNT - t0;
+    __set_PRIMASK(pm);
+
+    g_trace_on = was_on;
+    return dt / TRACE_COST_RUNS;
+}
+
+#else /* !MW_TRACE */
+
+void     Trace_Enable(uint8_t on) { (void)on; }
+uint8_t  Trace_Dump(void) { return 0; }
+uint32_t Trace_Cost(void) { return 0; }
+
+#endif /* MW_TRACE */
@@ -0,0 +1,333 @@
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "uart_cmd.h"
+#include "mw_ctrl.h"
+#include "recipe.h"
+#include "kvs.h"
+#include "heater_pid.h"
+#include "lowpower.h"
+#include "clock.h"
+#include "rtos_bench.h"
+#include "rtos_mem.h"
+#include "prof.h"
+#include "trace.h"
+#include "usart.h"
+#include "cmsis_os.h"
+#include "stream_buffer.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : USART2 RX command channel, see uart_cmd.h
+******************************************************/
+
+extern UART_HandleTypeDef huart2;
+
+/* --- state ---------------------------------------------------------------- */
+static uint8_t              s_rx_dma[UART_CMD_DMA_SIZE];   /* DMA1 writes here */
+static uint16_t             s_rx_pos = 0;                  /* next unread byte */
+
+static uint8_t              s_sb_storage[UART_CMD_STREAM_SIZE + 1];
+static StaticStreamBuffer_t s_sb_struct;
+static StreamBufferHandle_t s_sb = NULL;
+static volatile uint32_t    s_dropped = 0;
+
+static MicrowaveCtrl       *s_mw = NULL;
+static osThreadId_t         s_task = NULL;
+
+/* --- RX side (ISR) -------------------------------------------------------- */
+
+static void rx_restart(void)
+{
+    s_rx_pos = 0;
+    HAL_UARTEx_ReceiveToIdle_DMA(&huart2, s_rx_dma, UART_CMD_DMA_SIZE);
+}
+
+static void rx_push(const uint8_t *p, uint16_t n, BaseType_t *woken)
+{
+    size_t sent = xStreamBufferSendFromISR(s_sb, p, n, woken);
+    s_dropped += (uint32_t)(n - sent);
+}
+
+/* Called by HAL on IDLE, half transfer and transfer complete; Size is the
+   DMA write position in s_rx_dma (circular, so it wraps back to 0) */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+    if (huart->Instance != USART2 || s_sb == NULL) return;
+
+    BaseType_t woken = pdFALSE;
+    if (Size != s_rx_pos) {
+        trace_put(TRACE_EV_UART_RX, 0,
+                  (uint16_t)((Size + UART_CMD_DMA_SIZE - s_rx_pos) % UART_CMD_DMA_SIZE));
+        if (Size > s_rx_pos) {
+            rx_push(&s_rx_dma[s_rx_pos], (uint16_t)(Size - s_rx_pos), &woken);
+        } else {
+            rx_push(&s_rx_dma[s_rx_pos], (uint16_t)(UART_CMD_DMA_SIZE - s_rx_pos), &woken);
+            rx_push(s_rx_dma, Size, &woken);
+        }
+    }
+    s_rx_pos = (Size == UART_CMD_DMA_SIZE) ? 0 : Size;
+    portYIELD_FROM_ISR(woken);
+}
+
+/* Blocking errors (overrun, DMA) abort the reception in HAL: start over */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+    if (huart->Instance != USART2 || s_sb == NULL) return;
+    if (huart->RxState == HAL_UART_STATE_READY) rx_restart();
+}
+
+/* --- parser (task) -------------------------------------------------------- */
+
+static void cmd_status(void)
+{
+    static const char *const pwr[] = { "LOW", "MEDIUM", "HIGH" };
+    uint32_t ms = s_mw->cooking_time;
+    uint32_t cycles = 0;
+    Kvs_Get(KVS_KEY_CYCLES, &cycles, sizeof(cycles));
+    printf("TIME %lu.%03lu POWER %s CYCLES %lu\r\n",
+           (unsigned long)(ms / 1000u), (unsigned long)(ms % 1000u), pwr[s_mw->power],
+           (unsigned long)cycles);
+}
+
+/* LP [RESET]: idle time per mode since boot / the last reset */
+static void cmd_lowpower(uint8_t reset)
+{
+    LowPowerStats st;
+    LowPower_GetStats(&st, reset);
+    printf("SLEEP %lu %lums STOP %lu %lums BLOCKED %lu ABORTED %lu\r\n",
+           (unsigned long)st.sleep_count, (unsigned long)st.sleep_ms,
+           (unsigned long)st.stop_count, (unsigned long)st.stop_ms,
+           (unsigned long)st.stop_blocked, (unsigned long)st.aborted);
+}
+
+/* BENCH [rounds]: context switch latency without and with FP context */
+static void cmd_bench(uint32_t rounds)
+{
+    static const char *const name[] = { "INT", "FPU" };
+    for (uint8_t m = RTOS_BENCH_INT; m <= RTOS_BENCH_FPU; m++) {
+        RtosBenchStats st;
+        if (!RtosBench_Run((RtosBenchMode)m, rounds, &st)) { printf("ERR BENCH\r\n"); return; }
+        printf("CSW %s %lu MIN %lu AVG %lu MAX %lu\r\n", name[m], (unsigned long)st.rounds,
+               (unsigned long)st.min, (unsigned long)st.avg, (unsigned long)st.max);
+    }
+}
+
+/* PROGDEF <slot> <stage>...  with stages C<pct>/<s>, R<s>, B<n>, W;
+   parsed into a message block, the controller stores the program and it
+   survives power-off. A malformed line is answered here, one that was
+   posted by the controller. */
+static uint8_t progdef_parse(char *args, uint8_t *slot, MwProgDef *d)
+{
+    char *tok = strtok(args, " ");
+    char *end;
+    unsigned long n = tok ? strtoul(tok, &end, 10) : 0;
+
+    if (!tok || *end != '\0' || n == 0 || n > RCP_USER_SLOTS) { printf("ERR SLOT\r\n"); return 0; }
+    *slot = (uint8_t)(n - 1u);
+    d->n  = 0;
+
+    while ((tok = strtok(NULL, " ")) != NULL) {
+        unsigned long a = 0, b = 0;
+        rcp_stage_t *st = &d->st[d->n];
+        if (d->n >= RCP_USER_STAGES) { printf("ERR LONG\r\n"); return 0; }
+        switch (tok[0]) {
+            case 'C':
+                a = strtoul(tok + 1, &end, 10);
+                if (*end != '/') break;
+                b = strtoul(end + 1, &end, 10);
+                if (*end == '\0' && a <= 100u && b <= RCP_COOK_MAX_S) {
+                    *st = (rcp_stage_t)RCP_STAGE_COOK((uint8_t)a, (uint16_t)b);
+                    d->n++;
+                    continue;
+                }
+                break;
+            case 'R':
+                b = strtoul(tok + 1, &end, 10);
+                if (*end == '\0' && b <= RCP_COOK_MAX_S) { *st = (rcp_stage_t)RCP_STAGE_REST((uint16_t)b); d->n++; continue; }
+                break;
+            case 'B':
+                a = strtoul(tok + 1, &end, 10);
+                if (*end == '\0' && a >= 1u && a <= 9u) { *st = (rcp_stage_t)RCP_STAGE_BEEP((uint16_t)a); d->n++; continue; }
+                break;
+            case 'W':
+                if (tok[1] == '\0') { *st = (rcp_stage_t)RCP_STAGE_WAIT_DOOR; d->n++; continue; }
+                break;
+            default:
+                break;
+        }
+        printf("ERR STAGE %s\r\n", tok);
+        return 0;
+    }
+    return 1;
+}
+
+static void cmd_progdef(char *args)
+{
+    uint8_t slot;
+    MwProgDef *d = MwCtrl_MsgAlloc();
+    if (d == NULL) { printf("ERR BUSY\r\n"); return; }
+    if (!progdef_parse(args, &slot, d)) { MwCtrl_MsgFree(d); return; }
+    if (!MwCtrl_PostMsg(MW_EV_PROGDEF, slot, d)) printf("ERR BUSY\r\n");
+    /* else the controller replies */
+}
+
+/* POOL [RESET]: message pool use */
+static void cmd_pool(uint8_t reset)
+{
+    MemPoolStats st;
+    MwCtrl_MsgStats(&st, reset);
+    printf("POOL %lu USED %lu PEAK %lu FAIL %lu\r\n", (unsigned long)st.count,
+           (unsigned long)st.used, (unsigned long)st.peak, (unsigned long)st.fail);
+}
+
+static void cmd_exec(char *line)
+{
+    uint8_t ok = 0;
+    char *arg = strchr(line, ' ');
+    if (arg) { *arg++ = '\0'; while (*arg == ' ') arg++; }
+
+    if (strcmp(line, "TIME") == 0 && arg && *arg) {
+        char *end;
+        unsigned long t = strtoul(arg, &end, 10);
+        if (*end != '\0' || t > 999u) { printf("ERR TIME\r\n"); return; }
+        ok = MwCtrl_Post(MW_EV_SET_TIME, (uint16_t)t);
+    } else if (strcmp(line, "POWER") == 0 && arg && *arg) {
+        PowerLevel p;
+        if      (!strcmp(arg, "LOW")    || !strcmp(arg, "0")) p = POWER_LOW;
+        else if (!strcmp(arg, "MEDIUM") || !strcmp(arg, "1")) p = POWER_MEDIUM;
+        else if (!strcmp(arg, "HIGH")   || !strcmp(arg, "2")) p = POWER_HIGH;
+        else { printf("ERR POWER\r\n"); return; }
+        ok = MwCtrl_Post(MW_EV_SET_POWER, (uint16_t)p);
+    } else if (strcmp(line, "DOOR") == 0 && arg && *arg) {
+        if      (!strcmp(arg, "OPEN"))  ok = MwCtrl_Post(MW_EV_DOOR_OPEN, 0);
+        else if (!strcmp(arg, "CLOSE")) ok = MwCtrl_Post(MW_EV_DOOR_CLOSE, 0);
+        else { printf("ERR DOOR\r\n"); return; }
+    } else if (strcmp(line, "PROG") == 0) {
+        if (!arg || !*arg) {
+            for (uint8_t i = 0; i < rcp_count(); i++)
+                printf("PROG %u %s\r\n", (unsigned)(i + 1u), rcp_name(i));
+            return;
+        }
+        char *end;
+        unsigned long n = strtoul(arg, &end, 10);
+        if (*end != '\0' || n == 0 || n > rcp_count()) { printf("ERR PROG\r\n"); return; }
+        ok = MwCtrl_Post(MW_EV_PROGRAM, (uint16_t)(n - 1u));
+    } else if (strcmp(line, "LP") == 0) {
+        uint8_t reset = (arg && *arg);
+        if (reset && strcmp(arg, "RESET") != 0) { printf("ERR LP\r\n"); return; }
+        cmd_lowpower(reset);
+        return;
+    } else if (strcmp(line, "POOL") == 0) {
+        uint8_t reset = (arg && *arg);
+        if (reset && strcmp(arg, "RESET") != 0) { printf("ERR POOL\r\n"); return; }
+        cmd_pool(reset);
+        return;
+    } else if (strcmp(line, "CLOCK") == 0) {
+        if (arg && *arg) {
+            if      (!strcmp(arg, "FULL")) ok = Clock_SetProfile(CLOCK_PROFILE_FULL);
+            else if (!strcmp(arg, "LOW"))  ok = Clock_SetProfile(CLOCK_PROFILE_LOW);
+            else { printf("ERR CLOCK\r\n"); return; }
+            if (!ok) { printf("ERR CLOCK\r\n"); return; }
+        }
+        printf("CLOCK %s %lu\r\n", (Clock_Profile() == CLOCK_PROFILE_FULL) ? "FULL" : "LOW",
+               (unsigned long)SystemCoreClock);
+        return;
+    } else if (strcmp(line, "PROF") == 0) {
+        if (!Prof_Snapshot()) printf("ERR PROF\r\n");
+        return;
+#if MW_TRACE
+    } else if (strcmp(line, "TRACE") == 0) {
+        if (!arg || !*arg) {
+            if (!Trace_Dump()) printf("ERR TRACE\r\n");
+            return;
+        }
+        if (!strcmp(arg, "COST")) {
+            printf("TRACE COST %lu\r\n", (unsigned long)Trace_Cost());
+            return;
+        }
+        if      (!strcmp(arg, "ON"))  Trace_Enable(1);
+        else if (!strcmp(arg, "OFF")) Trace_Enable(0);
+        else { printf("ERR TRACE\r\n"); return; }
+        ok = 1;
+#endif
+    } else if (strcmp(line, "BENCH") == 0) {
+        unsigned long n = 1000u;
+        if (arg && *arg) {
+            char *end;
+            n = strtoul(arg, &end, 10);
+            if (*end != '\0' || n == 0 || n > RTOS_BENCH_MAX_ROUNDS) { printf("ERR BENCH\r\n"); return; }
+        }
+        cmd_bench((uint32_t)n);
+        return;
+    } else if (strcmp(line, "PROGDEF") == 0 && arg && *arg) {
+        cmd_progdef(arg);
+        return;
+#if MW_HEATER_PID
+    } else if (strcmp(line, "CAL") == 0 && arg && *arg) {
+        char *end;
+        long cal = strtol(arg, &end, 10);
+        if (*end != '\0' || cal < -200 || cal > 200) { printf("ERR CAL\r\n"); return; }
+        ok = MwCtrl_Post(MW_EV_SET_CAL, (uint16_t)(int16_t)cal);
+#endif
+    } else if (strcmp(line, "START") == 0) {
+        ok = MwCtrl_Post(MW_EV_START, 0);
+    } else if (strcmp(line, "STOP") == 0) {
+        ok = MwCtrl_Post(MW_EV_STOP, 0);
+    } else if (strcmp(line, "STATUS") == 0) {
+        cmd_status();
+        return;
+    } else {
+        printf("ERR ?\r\n");
+        return;
+    }
+    printf(ok ? "OK\r\n" : "ERR BUSY\r\n");
+}
+
+static void uart_cmd_task(void *argument)
+{
+    (void)argument;
+    char    line[UART_CMD_LINE_MAX + 1];
+    uint8_t len = 0, overlong = 0;
+    uint8_t chunk[16];
+
+    for (;;) {
+        size_t n = xStreamBufferReceive(s_sb, chunk, sizeof(chunk), portMAX_DELAY);
+        for (size_t i = 0; i < n; i++) {
+            char c = (char)chunk[i];
+            if (c == '\r' || c == '\n') {
+                if (len && !overlong) { line[len] = '\0'; cmd_exec(line); }
+                else if (overlong)    printf("ERR LONG\r\n");
+                len = 0; overlong = 0;
+            } else if (len < UART_CMD_LINE_MAX) {
+                line[len++] = (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+            } else {
+                overlong = 1;
+            }
+        }
+    }
+}
+
+/* --- API ------------------------------------------------------------------ */
+
+void UartCmd_Start(MicrowaveCtrl *mw)
+{
+    static StaticTask_t tcb;
+    RTOS_STACK(stack, 512 * 4);         /* printf */
+    static const osThreadAttr_t attr = {
+        .name = "uartCmd",
+        .cb_mem = &tcb, .cb_size = sizeof(tcb),
+        .stack_mem = stack, .stack_size = sizeof(stack),
+        .priority = (osPriority_t) RTOS_PRIO(osPriorityBelowNormal),
+    };
+    if (s_task) return;
+    s_mw = mw;
+    s_sb = xStreamBufferCreateStatic(UART_CMD_STREAM_SIZE, 1, s_sb_storage, &s_sb_struct);
+    s_task = osThreadNew(uart_cmd_task, NULL, &attr);
+    rx_restart();
+}
+
+uint32_t UartCmd_Dropped(void)
+{
+    return s_dropped;
+}
@@ -290,7 +290,19 @@
   #error "Definition configUSE_16_BIT_TICKS must be zero to implement CMSIS-RTOS2 API."
 #endif
 
-#if (configMAX_PRIORITIES != 56)
+#ifndef configCMSIS_PRIORITY_SHIFT
+  /*
+    Local patch (tools/freertos_os2_prio.patch): the application passes CMSIS-RTOS2 priorities
+    shifted right by configCMSIS_PRIORITY_SHIFT, so fewer FreeRTOS priorities are needed.
+  */
+  #define configCMSIS_PRIORITY_SHIFT  0
+#endif
+/*
+  Marks the patched header; the application (freertos.c) refuses to build without it, so a
+  stock copy put back by code generation does not go unnoticed.
+*/
+#define FREERTOS_OS2_PRIO_PATCH       1
+#if (configCMSIS_PRIORITY_SHIFT == 0) && (configMAX_PRIORITIES != 56)
   /*
     CMSIS-RTOS2 defines 56 different priorities (see osPriority_t) and portable CMSIS-RTOS2
     implementation should implement the same number of priorities.
@@ -298,7 +310,10 @@
   */
   #error "Definition configMAX_PRIORITIES must equal 56 to implement Thread Management API."
 #endif
-#if (configUSE_PORT_OPTIMISED_TASK_SELECTION != 0)
+#if ((55 >> configCMSIS_PRIORITY_SHIFT) >= configMAX_PRIORITIES)
+  #error "Definition configMAX_PRIORITIES too small for configCMSIS_PRIORITY_SHIFT."
+#endif
+#if (configUSE_PORT_OPTIMISED_TASK_SELECTION != 0) && (configMAX_PRIORITIES > 32)
   /*
     CMSIS-RTOS2 requires handling of 56 different priorities (see osPriority_t) while FreeRTOS port
     optimised selection for Cortex core only handles 32 different priorities.
@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stm32f4xx_hal.h"
+#include "hal_stub.h"
+#include "main.h"
+#include "delay.h"
+#include "usart.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Host HAL: peripheral registers in RAM, recorded SPI traffic,
+*           see hal_stub.h
+******************************************************/
+
+GPIO_TypeDef       host_gpio[9];
+SPI_TypeDef        host_spi1;
+DMA_Stream_TypeDef host_dma2_stream3;
+TIM_TypeDef        host_tim[14];
+USART_TypeDef      host_usart2;
+DWT_Type           host_dwt;
+CoreDebug_Type     host_coredebug;
+
+uint32_t host_ipsr;
+uint32_t host_primask;
+uint32_t SystemCoreClock = 168000000u;
+
+DMA_HandleTypeDef hdma_spi1_tx = { .Instance = DMA2_Stream3 };
+SPI_HandleTypeDef hspi1 = {
+    .Instance = SPI1,
+    .Init     = { .DataSize = SPI_DATASIZE_8BIT },
+    .hdmatx   = &hdma_spi1_tx,
+};
+
+TIM_HandleTypeDef htim2 = { .Instance = TIM2 };
+TIM_HandleTypeDef htim3 = { .Instance = TIM3 };
+TIM_HandleTypeDef htim4 = { .Instance = TIM4 };
+
+UART_HandleTypeDef huart2 = { .Instance = USART2, .gState = HAL_UART_STATE_READY,
+                              .RxState = HAL_UART_STATE_READY };
+
+HostSpiStats host_spi;
+HostPanel    host_panel;
+uint8_t      host_spi_dma_defer;
+HostUartStats host_uart;
+uint32_t     host_uart_refuse;
+uint32_t     host_hal_delay_ms;
+
+void host_spi_reset(void)
+{
+    host_spi.tx = host_spi.tx_dma = host_spi.bytes = 0;
+    host_spi.overlap = host_spi.torn = 0;
+}
+
+void Error_Handler(void)
+{
+    fprintf(stderr, "Error_Handler\n");
+    abort();
+}
+
+/* ---- GPIO ---- */
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init)
+{
+    (void)port; (void)init;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState s)
+{
+    if (s == GPIO_PIN_SET) port->ODR |= pin;
+    else                   port->ODR &= ~(uint32_t)pin;
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin)
+{
+    port->ODR ^= pin;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin)
+{
+    return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+/* ---- SPI ---- */
+static uint32_t frame_bytes(const SPI_HandleTypeDef *h)
+{
+    return (h->Init.DataSize == SPI_DATASIZE_16BIT) ? 2u : 1u;
+}
+
+/* Panel decoder (see hal_stub.h) */
+static struct {
+    uint8_t  on;
+    uint8_t  cmd;
+    uint8_t  arg[4], nargs, want;
+    uint8_t  hi, have_hi;               /* first byte of a pixel */
+    uint16_t xs, xe, ys, ye, x, y;
+} s_pd;
+
+static void panel_byte(uint8_t b)
+{
+    if (s_pd.nargs < s_pd.want) {
+        s_pd.arg[s_pd.nargs++] = b;
+        if (s_pd.nargs < s_pd.want) return;
+        uint16_t a = (uint16_t)(s_pd.arg[0] << 8 | s_pd.arg[1]);
+        uint16_t e = (uint16_t)(s_pd.arg[2] << 8 | s_pd.arg[3]);
+        if (s_pd.cmd == 0x2A) { s_pd.xs = a; s_pd.xe = e; }
+        if (s_pd.cmd == 0x2B) { s_pd.ys = a; s_pd.ye = e; }
+        return;
+    }
+    if (s_pd.cmd != 0x2C) return;
+    if (!s_pd.have_hi) { s_pd.hi = b; s_pd.have_hi = 1; return; }
+    s_pd.have_hi = 0;
+
+    host_panel.pixels++;
+    if (s_pd.x < HOST_PANEL_W && s_pd.y < HOST_PANEL_H)
+        host_panel.ram[s_pd.y * HOST_PANEL_W + s_pd.x] = (uint16_t)(s_pd.hi << 8 | b);
+    else
+        host_panel.clipped++;
+    if (s_pd.x++ == s_pd.xe) {
+        s_pd.x = s_pd.xs;
+        s_pd.y = (s_pd.y == s_pd.ye) ? s_pd.ys : (uint16_t)(s_pd.y + 1u);
+    }
+}
+
+static void panel_cmd(uint8_t c)
+{
+    s_pd.cmd = c;
+    s_pd.nargs = s_pd.want = s_pd.have_hi = 0;
+    switch (c) {
+    case 0x2A: case 0x2B: s_pd.want = 4; break;
+    case 0x36:            s_pd.want = 1; break;
+    case 0x2C:            s_pd.x = s_pd.xs; s_pd.y = s_pd.ys; break;
+    default:              host_panel.unknown++; break;
+    }
+}
+
+/* n frames from p; 16-bit frames go out MSB first, from one address
+   unless the stream increments */
+static void panel_feed(const SPI_HandleTypeDef *h, const uint8_t *p, uint32_t n, uint8_t inc)
+{
+    if (!s_pd.on) return;
+    if (h->Init.DataSize != SPI_DATASIZE_16BIT) {
+        if (n == 1u && s_pd.nargs == s_pd.want) { panel_cmd(p[0]); return; }
+        for (uint32_t i = 0; i < n; i++) panel_byte(p[i]);
+        return;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        uint16_t v;
+        memcpy(&v, inc ? p + 2u * i : p, 2);
+        panel_byte((uint8_t)(v >> 8));
+        panel_byte((uint8_t)v);
+    }
+}
+
+void host_panel_reset(uint16_t fill)
+{
+    memset(&host_panel, 0, sizeof host_panel);
+    for (uint32_t i = 0; i < HOST_PANEL_W * HOST_PANEL_H; i++) host_panel.ram[i] = fill;
+    memset(&s_pd, 0, sizeof s_pd);
+    s_pd.on = 1;
+}
+
+/* The DMA in flight, with a copy of its source as it was at the start */
+static struct {
+    SPI_HandleTypeDef *h;
+    const uint8_t     *p;
+    uint16_t           n;
+    uint8_t            inc;
+    uint8_t            snap[0x10000u * 2u];
+} s_dma;
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *h, uint8_t *p, uint16_t n, uint32_t timeout)
+{
+    (void)timeout;
+    if (s_dma.h) host_spi.overlap++;
+    host_spi.tx++;
+    host_spi.bytes += n * frame_bytes(h);
+    panel_feed(h, p, n, 1);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *h, uint8_t *p, uint16_t n)
+{
+    if (n == 0) return HAL_ERROR;
+    if (s_dma.h) host_spi.overlap++;
+    host_spi.tx_dma++;
+    host_spi.bytes += n * frame_bytes(h);
+    s_dma.h   = h;
+    s_dma.p   = p;
+    s_dma.n   = n;
+    s_dma.inc = h->Init.DataSize != SPI_DATASIZE_16BIT || (h->hdmatx->Instance->CR & DMA_SxCR_MINC);
+    memcpy(s_dma.snap, p, s_dma.inc ? n * frame_bytes(h) : frame_bytes(h));
+    if (!host_spi_dma_defer) host_spi_dma_done();
+    return HAL_OK;
+}
+
+void host_spi_dma_done(void)
+{
+    SPI_HandleTypeDef *h = s_dma.h;
+    if (!h) return;
+    if (memcmp(s_dma.snap, s_dma.p, s_dma.inc ? s_dma.n * frame_bytes(h) : frame_bytes(h)) != 0)
+        host_spi.torn++;
+    panel_feed(h, s_dma.p, s_dma.n, s_dma.inc);
+    s_dma.h = NULL;
+    HAL_SPI_TxCpltCallback(h);
+}
+
+__attribute__((weak)) void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *h)
+{
+    (void)h;
+}
+
+/* ---- TIM ---- */
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *h)
+{
+    h->Instance->CR1 |= 1u;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *h)
+{
+    h->Instance->DIER |= TIM_IT_UPDATE;
+    return HAL_TIM_Base_Start(h);
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *h, uint32_t ch)
+{
+    h->Instance->CCER |= 1u << ch;
+    return HAL_TIM_Base_Start(h);
+}
+
+/* ---- UART ---- */
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *h, const uint8_t *p, uint16_t n)
+{
+    (void)p;
+    host_uart.calls++;
+    if (host_uart_refuse || h->gState != HAL_UART_STATE_READY || n == 0) {
+        if (host_uart_refuse) host_uart_refuse--;
+        host_uart.refused++;
+        return HAL_BUSY;
+    }
+    h->gState = HAL_UART_STATE_BUSY_TX;
+    host_uart.bytes += n;
+    host_uart.in_flight = n;
+    return HAL_OK;
+}
+
+void host_uart_tx_done(void)
+{
+    if (!host_uart.in_flight) return;
+    host_uart.in_flight = 0;
+    huart2.gState = HAL_UART_STATE_READY;
+    HAL_UART_TxCpltCallback(&huart2);
+}
+
+__attribute__((weak)) void HAL_UART_TxCpltCallback(UART_HandleTypeDef *h)
+{
+    (void)h;
+}
+
+/* ---- System ---- */
+void HAL_Delay(uint32_t ms)
+{
+    host_hal_delay_ms += ms;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return host_hal_delay_ms;
+}
+
+/* delay.h: no cycle counter on the host, waits only add up */
+uint8_t  delay_init(void)                      { return 0; }
+void     delay_us(uint32_t us)                 { (void)us; }
+void     delay_ms(uint32_t ms)                 { HAL_Delay(ms); }
+uint32_t delay_cycles(void)                    { return 0; }
+uint32_t delay_cycles_to_us(uint32_t cycles)   { return cycles / (SystemCoreClock / 1000000u); }
@@ -0,0 +1,75 @@
+#ifndef HAL_STUB_H
+#define HAL_STUB_H
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : What the host HAL (hal_stub.c) records for the tests.
+*           SPI: every HAL_SPI_Transmit / HAL_SPI_Transmit_DMA call is one
+*           transaction; bytes count 2 per frame while SPI1 is in 16-bit
+*           mode. A DMA transfer completes inside the call
+*           (HAL_SPI_TxCpltCallback runs before it returns), unless the
+*           test defers it (host_spi_dma_defer).
+******************************************************/
+
+#include <stdint.h>
+#include "stm32f4xx_hal.h"
+
+typedef struct {
+    uint32_t tx;          /* blocking transactions */
+    uint32_t tx_dma;      /* DMA transactions */
+    uint32_t bytes;       /* bytes on the wire, both kinds */
+    uint32_t overlap;     /* transfers started while a DMA was in flight */
+    uint32_t torn;        /* DMA sources written to while in flight */
+} HostSpiStats;
+
+extern HostSpiStats host_spi;
+
+static inline uint32_t host_spi_transactions(void) { return host_spi.tx + host_spi.tx_dma; }
+void host_spi_reset(void);
+
+/* Deferred DMA: with host_spi_dma_defer set a transfer stays in flight
+   until host_spi_dma_done(); its bytes are read from the source only
+   then, as the stream would, and compared with what the source held at
+   the start (torn). Hook host_spi_dma_done into host_wait_hook with the
+   scheduler RUNNING, so the drivers' waits are what finish it. */
+extern uint8_t host_spi_dma_defer;
+void host_spi_dma_done(void);
+
+/* Panel: the bytes that reach the wire are decoded as the ST7735 command
+   subset lcd.c sends once it is up (CASET, RASET, RAMWR + pixels, MADCTL
+   whose parameter is skipped) into host_panel[], the controller RAM at
+   the addresses written (MADCTL is not applied). A 1-byte transfer in
+   8-bit mode is a command, everything else parameters or pixels.
+   host_panel_reset() starts decoding with the RAM filled with `fill`. */
+#define HOST_PANEL_W    132u
+#define HOST_PANEL_H    162u
+
+typedef struct {
+    uint16_t ram[HOST_PANEL_W * HOST_PANEL_H];   /* RGB565, native order */
+    uint32_t pixels;      /* pixels written */
+    uint32_t clipped;     /* of those, outside the RAM */
+    uint32_t unknown;     /* commands outside the subset */
+} HostPanel;
+
+extern HostPanel host_panel;
+void host_panel_reset(uint16_t fill);
+
+/* UART: HAL_UART_Transmit_DMA takes a transfer unless told to refuse
+   (HAL_BUSY, as while the UART is not initialised); it stays in flight
+   until host_uart_tx_done() runs HAL_UART_TxCpltCallback. */
+typedef struct {
+    uint32_t calls;       /* HAL_UART_Transmit_DMA calls */
+    uint32_t refused;     /* of those, answered HAL_BUSY */
+    uint32_t bytes;       /* bytes of the accepted transfers */
+    uint16_t in_flight;   /* length of the current transfer, 0 = idle */
+} HostUartStats;
+
+extern HostUartStats host_uart;
+extern uint32_t      host_uart_refuse;   /* refuse this many more calls */
+
+void host_uart_tx_done(void);
+
+/* Milliseconds passed to HAL_Delay so far */
+extern uint32_t host_hal_delay_ms;
+
+#endif /* HAL_STUB_H */
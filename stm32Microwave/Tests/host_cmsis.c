@@ -0,0 +1,69 @@
+#include <stdatomic.h>
+#include <sched.h>
+#include "stm32f4xx.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : LDREX/STREX for host threads. Each LDREXW records, per
+*           thread, the address and the number of exclusive stores made
+*           to it so far; STREXW stores only if that number has not moved,
+*           i.e. no other STREXW hit the address in between. That is the
+*           monitor's rule rather than compare-and-swap, so a value that
+*           went A -> B -> A still fails the store, as on the core.
+*           One spinlock orders the bookkeeping; addresses share a counter
+*           when they hash to the same slot, which can only add spurious
+*           failures (the caller retries, as it must on the target too).
+******************************************************/
+
+#define MON_SLOTS   64u
+
+static atomic_flag           s_lock = ATOMIC_FLAG_INIT;
+static uint32_t              s_stores[MON_SLOTS];
+
+static _Thread_local volatile uint32_t *t_addr;
+static _Thread_local uint32_t           t_stores;
+
+static inline uint32_t slot(volatile uint32_t *a)
+{
+    return (uint32_t)(((uintptr_t)a >> 2) % MON_SLOTS);
+}
+
+static void lock(void)
+{
+    while (atomic_flag_test_and_set_explicit(&s_lock, memory_order_acquire))
+        sched_yield();
+}
+
+static void unlock(void)
+{
+    atomic_flag_clear_explicit(&s_lock, memory_order_release);
+}
+
+uint32_t __LDREXW(volatile uint32_t *addr)
+{
+    lock();
+    uint32_t v = *addr;
+    t_addr   = addr;
+    t_stores = s_stores[slot(addr)];
+    unlock();
+    return v;
+}
+
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+    uint32_t fail = 1;
+    lock();
+    if (t_addr == addr && t_stores == s_stores[slot(addr)]) {
+        *addr = value;
+        s_stores[slot(addr)]++;
+        fail = 0;
+    }
+    t_addr = NULL;
+    unlock();
+    return fail;
+}
+
+void __CLREX(void)
+{
+    t_addr = NULL;
+}
@@ -0,0 +1,95 @@
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Single-threaded FreeRTOS stand-in, see stub/FreeRTOS.h
+******************************************************/
+
+TickType_t host_tick;
+void     (*host_assert_hook)(void);
+void     (*host_wait_hook)(void);
+BaseType_t host_scheduler_state = taskSCHEDULER_NOT_STARTED;
+
+void host_assert(const char *file, int line, const char *expr)
+{
+    fprintf(stderr, "%s:%d: configASSERT(%s) failed\n", file, line, expr);
+    if (host_assert_hook) host_assert_hook();
+    abort();
+}
+
+BaseType_t xTaskGetSchedulerState(void) { return host_scheduler_state; }
+TickType_t xTaskGetTickCount(void)      { return host_tick; }
+void       vTaskDelay(TickType_t ticks) { host_tick += ticks; }
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buf)
+{
+    buf->count = 0;
+    return buf;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait)
+{
+    if (!s->count && host_wait_hook) host_wait_hook();
+    if (s->count) { s->count--; return pdTRUE; }
+    host_tick += (wait == portMAX_DELAY) ? 0u : wait;
+    return pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    if (s->count) return pdFALSE;
+    s->count = 1;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t *woken)
+{
+    if (woken) *woken = pdFALSE;
+    return xSemaphoreGive(s);
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+                                 uint8_t *storage, StaticQueue_t *q)
+{
+    q->storage   = storage;
+    q->length    = length;
+    q->item_size = item_size;
+    q->head = q->count = 0;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t wait)
+{
+    (void)wait;
+    if (q->count == q->length) return pdFALSE;
+    memcpy(&q->storage[((q->head + q->count) % q->length) * q->item_size], item, q->item_size);
+    q->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    if (woken) *woken = pdFALSE;
+    return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t wait)
+{
+    (void)wait;
+    if (q->count == 0) return pdFALSE;
+    memcpy(item, &q->storage[q->head * q->item_size], q->item_size);
+    q->head = (q->head + 1u) % q->length;
+    q->count--;
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    return q->count;
+}
@@ -0,0 +1,108 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "kvs_file.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : File-backed kvs flash, see kvs_file.h
+******************************************************/
+
+uint32_t kvs_file_ops;
+uint32_t kvs_file_cut_at;
+uint32_t kvs_file_bad_programs;
+uint32_t kvs_file_seed = 1u;
+void   (*kvs_file_cut)(void);
+
+static kvs_flash_t s_fl;
+static uint8_t    *s_map;
+static int         s_fd = -1;
+
+static uint32_t rnd32(void)
+{
+    kvs_file_seed ^= kvs_file_seed << 13;
+    kvs_file_seed ^= kvs_file_seed >> 17;
+    kvs_file_seed ^= kvs_file_seed << 5;
+    return kvs_file_seed;
+}
+
+/* Count one operation; 1 if it is the one the power goes out in */
+static uint8_t cut_now(void)
+{
+    return ++kvs_file_ops == kvs_file_cut_at;
+}
+
+static void power_off(void)
+{
+    if (kvs_file_cut) kvs_file_cut();
+}
+
+static uint8_t f_erase(uint8_t sector)
+{
+    uint32_t *w = (uint32_t *)kvs_file_sector(sector);
+    uint32_t  n = s_fl.size / 4u;
+
+    if (cut_now()) {
+        for (uint32_t i = 0; i < n; i++) {
+            switch (rnd32() % 3u) {
+                case 0:  w[i] = 0xFFFFFFFFu; break;
+                case 1:  w[i] |= rnd32();    break;
+                default: break;
+            }
+        }
+        power_off();
+    }
+    memset(w, 0xFF, s_fl.size);
+    return 1;
+}
+
+static uint8_t f_program(uintptr_t addr, uint32_t word)
+{
+    uint32_t *w = (uint32_t *)addr;
+
+    if (~*w & word) kvs_file_bad_programs++;        /* would need an erase */
+    if (cut_now()) {
+        *w &= word | rnd32();                       /* some of the zeros */
+        power_off();
+    }
+    *w &= word;
+    return 1;
+}
+
+const kvs_flash_t *kvs_file_open(const char *path, uint32_t size)
+{
+    struct stat st;
+
+    kvs_file_close();
+    s_fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (s_fd < 0) return NULL;
+    uint8_t fresh = (fstat(s_fd, &st) != 0 || (uint32_t)st.st_size != 2u * size);
+    if (fresh && ftruncate(s_fd, 2 * (off_t)size) != 0) { kvs_file_close(); return NULL; }
+
+    void *m = mmap(NULL, 2u * size, PROT_READ | PROT_WRITE, MAP_SHARED, s_fd, 0);
+    if (m == MAP_FAILED) { kvs_file_close(); return NULL; }
+    s_map = m;
+    if (fresh) memset(s_map, 0xFF, 2u * size);
+
+    s_fl.base[0] = (uintptr_t)s_map;
+    s_fl.base[1] = (uintptr_t)s_map + size;
+    s_fl.size    = size;
+    s_fl.erase   = f_erase;
+    s_fl.program = f_program;
+    return &s_fl;
+}
+
+void kvs_file_close(void)
+{
+    if (s_map) munmap(s_map, 2u * s_fl.size);
+    if (s_fd >= 0) close(s_fd);
+    s_map = NULL;
+    s_fd  = -1;
+}
+
+uint8_t *kvs_file_sector(uint8_t sec)
+{
+    return s_map + (uint32_t)sec * s_fl.size;
+}
@@ -0,0 +1,35 @@
+#ifndef KVS_FILE_H
+#define KVS_FILE_H
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : kvs backend on a file, mmap'ed so kvs.c reads it in place as
+*           it reads the memory-mapped flash. Two sectors of `size` bytes
+*           back to back. NOR rules: erase sets a sector to 0xFF,
+*           program can only clear bits (a 0 -> 1 request is counted in
+*           kvs_file_bad_programs and not applied).
+*           Power cuts: each erase / program is one operation. When the
+*           operation count reaches kvs_file_cut_at it is torn (a program
+*           clears a random part of its bits, an erase leaves each word
+*           erased, half erased or untouched) and kvs_file_cut() runs; it
+*           must not return (the tests longjmp back and reboot).
+******************************************************/
+
+#include <stdint.h>
+#include "kvs.h"
+
+extern uint32_t kvs_file_ops;           /* operations so far */
+extern uint32_t kvs_file_cut_at;        /* 0 = never */
+extern uint32_t kvs_file_bad_programs;
+extern uint32_t kvs_file_seed;          /* what the torn bits come from */
+extern void   (*kvs_file_cut)(void);
+
+/* Map `path` (created or resized to 2 * size, erased if new); NULL on error */
+const kvs_flash_t *kvs_file_open(const char *path, uint32_t size);
+void               kvs_file_close(void);
+
+/* Start of sector `sec` in the mapping, for tests that look at or poke
+   the raw image */
+uint8_t *kvs_file_sector(uint8_t sec);
+
+#endif /* KVS_FILE_H */
@@ -0,0 +1,210 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "oven_rig.h"
+#include "font.h"
+#include "lcd.h"
+#include "hal_stub.h"
+
+/* The controller's statics (queue, machine, program) are reset per run,
+   and its console replies land in rig_console */
+int rig_printf(const char *fmt, ...);
+#define printf rig_printf
+#include "mw_ctrl.c"
+#undef printf
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Host rig around the controller, see oven_rig.h
+******************************************************/
+
+led_d              led1 = { GPIOD, GPIO_PIN_12 };
+Beep_HandleTypeDef hbeep = { GPIOA, GPIO_PIN_8, GPIO_PIN_SET };
+MicrowaveCtrl      mw1;
+
+LowPowerMode rig_lp_mode;
+uint32_t     rig_lp_holds;
+uint32_t     rig_beeps;
+uint32_t     rig_kvs_writes;
+uint32_t     rig_kvs_writes_heating;
+char         rig_console[64];
+
+int rig_printf(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(rig_console, sizeof rig_console, fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+/* --- stubs ---------------------------------------------------------------- */
+
+void Button_Init(ButtonSink sink) { (void)sink; }
+void Button_Edge(uint16_t pin)    { (void)pin; }
+
+void LowPower_SetMode(LowPowerMode mode) { rig_lp_mode = mode; }
+void LowPower_Hold(uint32_t ms)          { (void)ms; rig_lp_holds++; }
+
+void Beep_Beep(Beep_HandleTypeDef *hb, uint8_t times, uint32_t on_ms, uint32_t off_ms)
+{
+    (void)hb; (void)on_ms; (void)off_ms;
+    rig_beeps += times;
+}
+
+/* Flash store: a RAM table with the real store's "same value is not
+   rewritten" rule */
+static struct {
+    uint16_t len;
+    uint8_t  data[KVS_MAX_VALUE];
+} s_kvs[KVS_MAX_KEYS];
+
+static void kvs_wrote(void)
+{
+    rig_kvs_writes++;
+    if (mw1.heating == HEATING_ON) rig_kvs_writes_heating++;
+}
+
+uint16_t Kvs_Get(uint16_t key, void *dst, uint16_t max)
+{
+    if (key >= KVS_MAX_KEYS || s_kvs[key].len == 0) return 0;
+    memcpy(dst, s_kvs[key].data, (max < s_kvs[key].len) ? max : s_kvs[key].len);
+    return s_kvs[key].len;
+}
+
+uint8_t Kvs_Put(uint16_t key, const void *src, uint16_t len)
+{
+    if (key >= KVS_MAX_KEYS || len == 0 || len > KVS_MAX_VALUE) return 0;
+    if (s_kvs[key].len == len && memcmp(s_kvs[key].data, src, len) == 0) return 1;
+    memcpy(s_kvs[key].data, src, len);
+    s_kvs[key].len = len;
+    kvs_wrote();
+    return 1;
+}
+
+uint8_t Kvs_Delete(uint16_t key)
+{
+    if (key >= KVS_MAX_KEYS) return 0;
+    if (s_kvs[key].len) { s_kvs[key].len = 0; kvs_wrote(); }
+    return 1;
+}
+
+/* --- driving -------------------------------------------------------------- */
+
+void rig_reset(void)
+{
+    static uint8_t lcd_up;
+    if (!lcd_up) {
+        Font_Init();
+        LCD_Init();
+        lcd_up = 1;
+    }
+
+    memset(&host_tim[4], 0, sizeof host_tim[4]);
+    memset(&host_tim[3], 0, sizeof host_tim[3]);
+    memset(&host_tim[2], 0, sizeof host_tim[2]);
+    host_tim[3].ARR = 99u;
+
+    memset(s_kvs, 0, sizeof s_kvs);
+    for (uint8_t i = 0; i < RCP_USER_SLOTS; i++) rcp_set_user(i, NULL, 0);
+    rig_beeps = rig_kvs_writes = rig_kvs_writes_heating = rig_lp_holds = 0;
+    rig_console[0] = '\0';
+
+    s_q = NULL;
+    s_sel = 0;
+    s_stage_posted = 0;
+    s_msg = NULL;
+    rcp_clear(&s_prog);
+
+    micro_wave_init(&mw1);
+    MwCtrl_Init(&mw1);
+}
+
+uint8_t rig_post(MwEventType type, uint16_t arg)
+{
+    return MwCtrl_Post(type, arg);
+}
+
+uint8_t rig_post_progdef(uint8_t slot, const rcp_stage_t *st, uint8_t n)
+{
+    MwProgDef *d = MwCtrl_MsgAlloc();
+    if (d == NULL) return 0;
+    d->n = n;
+    memcpy(d->st, st, (size_t)n * sizeof(st[0]));
+    return MwCtrl_PostMsg(MW_EV_PROGDEF, slot, d);
+}
+
+uint32_t rig_run(void)
+{
+    MwEvent  ev;
+    uint32_t n = 0;
+    while (xQueueReceive(s_q, &ev, 0) == pdTRUE) {
+        dispatch(s_mw, &ev);
+        n++;
+    }
+    return n;
+}
+
+void rig_elapse_ms(uint32_t ms)
+{
+    TIM_TypeDef *t = htim4.Instance;
+    while (ms--) {
+        uint16_t prev = (uint16_t)t->CNT;
+        t->CNT = (uint16_t)(prev + MW_COUNTDOWN_CPMS);
+        /* compare crossed during this millisecond */
+        if ((t->DIER & TIM_IT_CC1) &&
+            (uint16_t)((uint16_t)t->CCR1 - prev - 1u) < MW_COUNTDOWN_CPMS)
+            HAL_TIM_OC_DelayElapsedCallback(&htim4);
+    }
+}
+
+void rig_advance_ms(uint32_t ms)
+{
+    while (ms--) {
+        rig_elapse_ms(1);
+        rig_run();
+    }
+}
+
+/* --- outputs -------------------------------------------------------------- */
+
+MicrowaveState rig_state(void)     { return (MicrowaveState)s_fsm.cur; }
+uint8_t rig_in(MicrowaveState s)   { return fsm_in(&s_fsm, (uint8_t)s); }
+uint32_t rig_heater_duty(void)     { return __HAL_TIM_GET_COMPARE(MW_HEATER_TIM, MW_HEATER_CH); }
+uint32_t rig_turntable_duty(void)  { return __HAL_TIM_GET_COMPARE(MW_TURNTABLE_TIM, MW_TURNTABLE_CH); }
+uint32_t rig_door_us(void)         { return __HAL_TIM_GET_COMPARE(MW_DOOR_TIM, MW_DOOR_CH); }
+uint8_t rig_countdown_armed(void)  { return (htim4.Instance->DIER & TIM_IT_CC1) != 0u; }
+uint8_t rig_prog_running(void)     { return rcp_running(&s_prog); }
+
+uint8_t rig_heater_on(void)
+{
+    return rig_heater_duty() != 0u || (htim3.Instance->DIER & TIM_IT_UPDATE) != 0u;
+}
+
+uint8_t rig_store_pending(void)    { return s_dirty != 0u; }
+
+uint32_t rig_msg_used(void)
+{
+    MemPoolStats st;
+    MwCtrl_MsgStats(&st, 0);
+    return st.used;
+}
+
+const char *rig_event_name(uint8_t ev)
+{
+    static const char *const k[MW_EV_COUNT] = {
+        "KEY_MODE", "KEY_ACTION", "KEY_RELEASE", "KEY_LONG", "KEY_REPEAT", "TICK",
+        "SET_TIME", "SET_POWER", "DOOR_OPEN", "DOOR_CLOSE", "START", "STOP", "DONE",
+        "PROGRAM", "STAGE_COOK", "STAGE_WAIT", "STAGE_END", "PROGDEF", "SET_CAL",
+    };
+    return (ev < MW_EV_COUNT) ? k[ev] : "?";
+}
+
+const char *rig_state_name(uint8_t s)
+{
+    static const char *const k[STATE_COUNT] = {
+        "STANDBY", "TIME_SETTING", "POWER_SETTING", "COMPLETED", "COOKING", "PAUSED",
+        "DOOR_OPEN", "PROG_SETTING", "WAIT_DOOR", "IDLE", "ACTIVE",
+    };
+    return (s < STATE_COUNT) ? k[s] : "?";
+}
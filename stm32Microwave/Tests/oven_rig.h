@@ -0,0 +1,62 @@
+#ifndef OVEN_RIG_H
+#define OVEN_RIG_H
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : The controller on the host: mw_ctrl.c (its table, guards and
+*           actions) over the real micro_wave_oven.c, recipe.c and LCD
+*           code, with the HAL registers in RAM. Keys, low power and the
+*           flash store are stubbed and recorded here.
+*           The controller task is the caller: rig_post() queues an event
+*           like any source would, rig_run() dispatches until the queue is
+*           empty (including what the controller posts itself), and
+*           rig_advance_ms() runs TIM4 at 2 counts per ms and raises the
+*           CH1 compare callback when the countdown compare is armed.
+******************************************************/
+
+#include <stdint.h>
+#include "mw_ctrl.h"
+#include "lowpower.h"
+
+/* Fresh oven: micro_wave_init + MwCtrl_Init in STANDBY, door open */
+void rig_reset(void);
+
+/* Queue one event (0 if the queue is full) / a PROGDEF with its block */
+uint8_t rig_post(MwEventType type, uint16_t arg);
+uint8_t rig_post_progdef(uint8_t slot, const rcp_stage_t *st, uint8_t n);
+
+/* Dispatch everything queued; returns the number of events */
+uint32_t rig_run(void);
+
+/* Let `ms` pass, dispatching each countdown tick as it comes */
+void rig_advance_ms(uint32_t ms);
+
+/* Same, ISR side only: ticks are queued but not dispatched */
+void rig_elapse_ms(uint32_t ms);
+
+/* What the outputs say */
+MicrowaveState rig_state(void);
+uint8_t        rig_in(MicrowaveState s);         /* s or one of its substates */
+uint8_t        rig_heater_on(void);              /* PWM duty or burst IRQ armed */
+uint32_t       rig_heater_duty(void);
+uint32_t       rig_turntable_duty(void);
+uint32_t       rig_door_us(void);
+uint8_t        rig_countdown_armed(void);
+uint8_t        rig_prog_running(void);
+uint32_t       rig_msg_used(void);
+uint8_t        rig_store_pending(void);          /* settings not yet written */
+
+/* Stubs' records */
+extern LowPowerMode rig_lp_mode;
+extern uint32_t     rig_lp_holds;                /* LowPower_Hold calls (servo writes) */
+extern uint32_t     rig_beeps;                   /* prog_beep counts */
+extern uint32_t     rig_kvs_writes;              /* Kvs_Put / Kvs_Delete that wrote */
+extern uint32_t     rig_kvs_writes_heating;      /* of those, while the heater ran */
+extern char         rig_console[64];             /* last console reply (printf) */
+
+/* The oven and, for printing, event names */
+extern MicrowaveCtrl mw1;
+const char *rig_event_name(uint8_t ev);
+const char *rig_state_name(uint8_t s);
+
+#endif /* OVEN_RIG_H */
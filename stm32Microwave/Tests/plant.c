@@ -0,0 +1,25 @@
+#include <math.h>
+#include <string.h>
+#include "plant.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Thermal plant, see plant.h
+******************************************************/
+
+void plant_reset(plant_t *p)
+{
+    p->temp = p->ambient;
+    memset(p->line, 0, sizeof(p->line));
+    p->k = 0;
+}
+
+int32_t plant_step(plant_t *p, int32_t u)
+{
+    int32_t late = p->line[p->k % PLANT_MAX_DELAY];     /* u from `delay` steps ago */
+    p->line[(p->k + p->delay) % PLANT_MAX_DELAY] = u;
+    p->k++;
+    if (p->delay == 0u) late = u;
+    p->temp += (p->ambient + p->gain * late - p->temp) / p->tau;
+    return (int32_t)lround(p->temp);
+}
@@ -0,0 +1,35 @@
+#ifndef PLANT_H
+#define PLANT_H
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : First-order thermal plant with dead time, for the PID tests.
+*           One step is one controller period. The heater input u (duty
+*           counts) reaches the load `delay` steps later; the temperature
+*           then moves towards ambient + gain * u with time constant
+*           `tau` steps:  T += (ambient + gain * u(k - delay) - T) / tau.
+*           Temperatures are 0.1 degC, as heater_pid.c measures them.
+******************************************************/
+
+#include <stdint.h>
+
+#define PLANT_MAX_DELAY  256u
+
+typedef struct {
+    double   ambient;       /* 0.1 degC */
+    double   gain;          /* 0.1 degC per duty count, steady state */
+    double   tau;           /* steps */
+    uint32_t delay;         /* steps, < PLANT_MAX_DELAY */
+    /* state */
+    double   temp;
+    int32_t  line[PLANT_MAX_DELAY];
+    uint32_t k;
+} plant_t;
+
+/* At ambient, nothing in the delay line */
+void    plant_reset(plant_t *p);
+
+/* Apply u for one step; returns the measurement (rounded to 0.1 degC) */
+int32_t plant_step(plant_t *p, int32_t u);
+
+#endif /* PLANT_H */
@@ -0,0 +1,47 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Host stand-in for the FreeRTOS kernel: no scheduler, one
+*           thread. The scheduler reads as not started unless a test
+*           says otherwise; objects are counters in host_rtos.c.
+******************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stm32f4xx.h"
+
+typedef long          BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t      TickType_t;
+
+#define pdFALSE            ((BaseType_t)0)
+#define pdTRUE             ((BaseType_t)1)
+#define pdPASS             pdTRUE
+#define pdFAIL             pdFALSE
+#define portMAX_DELAY      ((TickType_t)0xFFFFFFFFUL)
+
+/* the application's own config (Core/Inc) */
+#include "FreeRTOSConfig.h"
+
+#define pdMS_TO_TICKS(ms)  ((TickType_t)(((TickType_t)(ms) * (TickType_t)configTICK_RATE_HZ) / (TickType_t)1000U))
+
+#define portYIELD_FROM_ISR(w)      ((void)(w))
+#define taskDISABLE_INTERRUPTS()   __disable_irq()
+
+/* A failed configASSERT reports and aborts instead of spinning; a test
+   can dump its own context first through host_assert_hook */
+#undef configASSERT
+#define configASSERT(x) do { if (!(x)) host_assert(__FILE__, __LINE__, #x); } while (0)
+void host_assert(const char *file, int line, const char *expr);
+extern void (*host_assert_hook)(void);
+
+/* Ticks since start; tests advance it with host_rtos_advance() */
+extern TickType_t host_tick;
+
+/* Runs when a semaphore take finds nothing to take, before it gives up:
+   whatever the task would have slept through (a deferred DMA) ends here */
+extern void (*host_wait_hook)(void);
+
+#endif /* HOST_FREERTOS_H */
@@ -0,0 +1,21 @@
+#ifndef HOST_QUEUE_H
+#define HOST_QUEUE_H
+
+#include "FreeRTOS.h"
+
+/* A FIFO of fixed-size items; receive never blocks on the host */
+typedef struct {
+    uint8_t    *storage;
+    UBaseType_t length, item_size;
+    UBaseType_t head, count;
+} StaticQueue_t;
+typedef StaticQueue_t *QueueHandle_t;
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+                                 uint8_t *storage, StaticQueue_t *q);
+BaseType_t    xQueueSend(QueueHandle_t q, const void *item, TickType_t wait);
+BaseType_t    xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken);
+BaseType_t    xQueueReceive(QueueHandle_t q, void *item, TickType_t wait);
+UBaseType_t   uxQueueMessagesWaiting(QueueHandle_t q);
+
+#endif /* HOST_QUEUE_H */
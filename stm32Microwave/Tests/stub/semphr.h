@@ -0,0 +1,15 @@
+#ifndef HOST_SEMPHR_H
+#define HOST_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+/* A binary / counting semaphore is its count: nothing can block on the host */
+typedef struct { volatile UBaseType_t count; } StaticSemaphore_t;
+typedef StaticSemaphore_t *SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buf);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t s, TickType_t wait);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t s);
+BaseType_t        xSemaphoreGiveFromISR(SemaphoreHandle_t s, BaseType_t *woken);
+
+#endif /* HOST_SEMPHR_H */
@@ -0,0 +1,106 @@
+#ifndef HOST_STM32F4XX_H
+#define HOST_STM32F4XX_H
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Host stand-in for the CMSIS device header. Only what the
+*           modules under test touch: the peripheral registers are plain
+*           structs in host memory (hal_stub.c) and the core intrinsics
+*           act on host variables.
+******************************************************/
+
+#include <stdint.h>
+
+#define __IO volatile
+#define __STATIC_INLINE static inline
+
+typedef enum { RESET = 0, SET = !RESET } FlagStatus, ITStatus;
+typedef enum { DISABLE = 0, ENABLE = !DISABLE } FunctionalState;
+
+typedef struct {
+    __IO uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1, CR2, SR, DR, CRCPR, RXCRCR, TXCRCR, I2SCFGR, I2SPR;
+} SPI_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR, NDTR, PAR, M0AR, M1AR, FCR;
+} DMA_Stream_TypeDef;
+
+typedef struct {
+    __IO uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR,
+                  RCR, CCR1, CCR2, CCR3, CCR4, BDTR, DCR, DMAR, OR;
+} TIM_TypeDef;
+
+typedef struct {
+    __IO uint32_t SR, DR, BRR, CR1, CR2, CR3, GTPR;
+} USART_TypeDef;
+
+typedef struct {
+    __IO uint32_t CTRL, CYCCNT;
+} DWT_Type;
+
+typedef struct {
+    __IO uint32_t DHCSR, DCRSR, DCRDR, DEMCR;
+} CoreDebug_Type;
+
+extern GPIO_TypeDef       host_gpio[9];
+extern SPI_TypeDef        host_spi1;
+extern DMA_Stream_TypeDef host_dma2_stream3;
+extern TIM_TypeDef        host_tim[14];
+extern USART_TypeDef      host_usart2;
+extern DWT_Type           host_dwt;
+extern CoreDebug_Type     host_coredebug;
+
+#define GPIOA             (&host_gpio[0])
+#define GPIOB             (&host_gpio[1])
+#define GPIOC             (&host_gpio[2])
+#define GPIOD             (&host_gpio[3])
+#define GPIOE             (&host_gpio[4])
+#define SPI1              (&host_spi1)
+#define DMA2_Stream3      (&host_dma2_stream3)
+#define TIM2              (&host_tim[2])
+#define TIM3              (&host_tim[3])
+#define TIM4              (&host_tim[4])
+#define TIM7              (&host_tim[7])
+#define USART2            (&host_usart2)
+#define DWT               (&host_dwt)
+#define CoreDebug         (&host_coredebug)
+
+#define CCMDATARAM_BASE   0x10000000UL
+
+#define SPI_CR1_SPE       (1UL << 6)
+#define SPI_CR1_DFF       (1UL << 11)
+
+#define DMA_SxCR_PSIZE_0  (1UL << 11)
+#define DMA_SxCR_PSIZE    (3UL << 11)
+#define DMA_SxCR_MSIZE_0  (1UL << 13)
+#define DMA_SxCR_MSIZE    (3UL << 13)
+#define DMA_SxCR_MINC     (1UL << 10)
+
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+/* Core intrinsics. IPSR is 0 (thread mode) unless a test plays an ISR. */
+extern uint32_t host_ipsr;
+extern uint32_t host_primask;
+
+static inline uint32_t __get_IPSR(void)         { return host_ipsr; }
+static inline uint32_t __get_PRIMASK(void)      { return host_primask; }
+static inline void     __set_PRIMASK(uint32_t v) { host_primask = v; }
+static inline void     __disable_irq(void)      { host_primask = 1; }
+static inline void     __enable_irq(void)       { host_primask = 0; }
+static inline void     __DSB(void)              { }
+static inline void     __ISB(void)              { }
+static inline void     __NOP(void)              { }
+
+/* Exclusive access, emulated across host threads (host_cmsis.c) */
+uint32_t __LDREXW(volatile uint32_t *addr);
+uint32_t __STREXW(uint32_t value, volatile uint32_t *addr);
+void     __CLREX(void);
+
+extern uint32_t SystemCoreClock;
+
+#endif /* HOST_STM32F4XX_H */
@@ -0,0 +1,133 @@
+#ifndef HOST_STM32F4XX_HAL_H
+#define HOST_STM32F4XX_HAL_H
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Host stand-in for the HAL: handle types, the macros the
+*           drivers use and the calls hal_stub.c records.
+******************************************************/
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stm32f4xx.h"
+
+typedef enum { HAL_OK = 0, HAL_ERROR, HAL_BUSY, HAL_TIMEOUT } HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY      0xFFFFFFFFU
+#define UNUSED(x)          ((void)(x))
+
+/* ---- GPIO ---- */
+typedef enum { GPIO_PIN_RESET = 0, GPIO_PIN_SET } GPIO_PinState;
+
+typedef struct {
+    uint32_t Pin, Mode, Pull, Speed, Alternate;
+} GPIO_InitTypeDef;
+
+#define GPIO_PIN_0    ((uint16_t)0x0001)
+#define GPIO_PIN_1    ((uint16_t)0x0002)
+#define GPIO_PIN_2    ((uint16_t)0x0004)
+#define GPIO_PIN_3    ((uint16_t)0x0008)
+#define GPIO_PIN_4    ((uint16_t)0x0010)
+#define GPIO_PIN_5    ((uint16_t)0x0020)
+#define GPIO_PIN_6    ((uint16_t)0x0040)
+#define GPIO_PIN_7    ((uint16_t)0x0080)
+#define GPIO_PIN_8    ((uint16_t)0x0100)
+#define GPIO_PIN_9    ((uint16_t)0x0200)
+#define GPIO_PIN_10   ((uint16_t)0x0400)
+#define GPIO_PIN_11   ((uint16_t)0x0800)
+#define GPIO_PIN_12   ((uint16_t)0x1000)
+#define GPIO_PIN_13   ((uint16_t)0x2000)
+#define GPIO_PIN_14   ((uint16_t)0x4000)
+#define GPIO_PIN_15   ((uint16_t)0x8000)
+
+#define GPIO_MODE_INPUT        0x0U
+#define GPIO_MODE_OUTPUT_PP    0x1U
+#define GPIO_NOPULL            0x0U
+#define GPIO_PULLUP            0x1U
+#define GPIO_SPEED_FREQ_LOW    0x0U
+#define GPIO_SPEED_FREQ_HIGH   0x2U
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOD_CLK_ENABLE()  ((void)0)
+#define __HAL_RCC_GPIOE_CLK_ENABLE()  ((void)0)
+
+void          HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+void          HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState s);
+void          HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+
+/* ---- DMA / SPI ---- */
+typedef struct {
+    DMA_Stream_TypeDef *Instance;
+} DMA_HandleTypeDef;
+
+#define SPI_DATASIZE_8BIT    0x00000000U
+#define SPI_DATASIZE_16BIT   SPI_CR1_DFF
+
+typedef struct {
+    uint32_t DataSize;
+} SPI_InitTypeDef;
+
+typedef struct {
+    SPI_TypeDef       *Instance;
+    SPI_InitTypeDef    Init;
+    DMA_HandleTypeDef *hdmatx;
+} SPI_HandleTypeDef;
+
+#define __HAL_SPI_ENABLE(h)   ((h)->Instance->CR1 |= SPI_CR1_SPE)
+#define __HAL_SPI_DISABLE(h)  ((h)->Instance->CR1 &= ~SPI_CR1_SPE)
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *h, uint8_t *p, uint16_t n, uint32_t timeout);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef *h, uint8_t *p, uint16_t n);
+void              HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *h);
+
+/* ---- TIM ---- */
+typedef struct {
+    TIM_TypeDef *Instance;
+} TIM_HandleTypeDef;
+
+#define TIM_CHANNEL_1        0x00000000U
+#define TIM_CHANNEL_2        0x00000004U
+#define TIM_CHANNEL_3        0x00000008U
+#define TIM_CHANNEL_4        0x0000000CU
+
+#define TIM_IT_UPDATE        (1U << 0)
+#define TIM_IT_CC1           (1U << 1)
+
+#define __HAL_TIM_SET_COMPARE(h, ch, v) (*(&(h)->Instance->CCR1 + ((ch) >> 2U)) = (v))
+#define __HAL_TIM_GET_COMPARE(h, ch)    (*(&(h)->Instance->CCR1 + ((ch) >> 2U)))
+#define __HAL_TIM_GET_COUNTER(h)        ((h)->Instance->CNT)
+#define __HAL_TIM_SET_COUNTER(h, v)     ((h)->Instance->CNT = (v))
+#define __HAL_TIM_GET_AUTORELOAD(h)     ((h)->Instance->ARR)
+#define __HAL_TIM_CLEAR_IT(h, it)       ((h)->Instance->SR = ~(it))
+#define __HAL_TIM_ENABLE_IT(h, it)      ((h)->Instance->DIER |= (it))
+#define __HAL_TIM_DISABLE_IT(h, it)     ((h)->Instance->DIER &= ~(it))
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *h);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *h);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *h, uint32_t ch);
+
+/* ---- UART ---- */
+typedef enum {
+    HAL_UART_STATE_RESET   = 0x00U,
+    HAL_UART_STATE_READY   = 0x20U,
+    HAL_UART_STATE_BUSY_TX = 0x21U,
+    HAL_UART_STATE_BUSY_RX = 0x22U,
+} HAL_UART_StateTypeDef;
+
+typedef struct {
+    USART_TypeDef                  *Instance;
+    volatile HAL_UART_StateTypeDef  gState;
+    volatile HAL_UART_StateTypeDef  RxState;
+} UART_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *h, const uint8_t *p, uint16_t n);
+void              HAL_UART_TxCpltCallback(UART_HandleTypeDef *h);
+
+/* ---- System ---- */
+void     HAL_Delay(uint32_t ms);
+uint32_t HAL_GetTick(void);
+
+#endif /* HOST_STM32F4XX_HAL_H */
@@ -0,0 +1,17 @@
+#ifndef HOST_TASK_H
+#define HOST_TASK_H
+
+#include "FreeRTOS.h"
+
+#define taskSCHEDULER_SUSPENDED    ((BaseType_t)0)
+#define taskSCHEDULER_NOT_STARTED  ((BaseType_t)1)
+#define taskSCHEDULER_RUNNING      ((BaseType_t)2)
+
+/* Set to taskSCHEDULER_RUNNING to take the drivers' blocking paths */
+extern BaseType_t host_scheduler_state;
+
+BaseType_t xTaskGetSchedulerState(void);
+TickType_t xTaskGetTickCount(void);
+void       vTaskDelay(TickType_t ticks);
+
+#endif /* HOST_TASK_H */
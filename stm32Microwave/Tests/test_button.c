@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <string.h>
+#include "button.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : btn_scan() against the contact traces in data/bounce_*.txt
+*           (synthetic, run-length: "<level> <duration_us>" per line).
+*           The replay does what button.c does with the hardware: the
+*           first rising edge while the EXTI line is armed masks it and
+*           calls btn_edge(), then the level is sampled every BTN_SCAN_MS
+*           until the key is idle again, and only then is the line armed
+*           (edges in between are lost, as the pending bit is cleared).
+*           Each trace is one press: exactly one PRESS and one RELEASE,
+*           and LONG / REPEAT on the schedule of button.h.
+******************************************************/
+
+#define RUNS_MAX    256u
+#define EVENTS_MAX  64u
+#define SCAN_US     (BTN_SCAN_MS * 1000u)
+
+typedef struct {
+    uint8_t  level;
+    uint32_t start, end;    /* us */
+} Run;
+
+typedef struct {
+    ButtonEvent ev;
+    uint32_t    t;          /* us */
+} Event;
+
+static Run      s_run[RUNS_MAX];
+static uint32_t s_runs;
+static Event    s_ev[EVENTS_MAX];
+static uint32_t s_evs;
+
+static int load(const char *name)
+{
+    char  path[256], line[64];
+    FILE *f;
+    uint32_t t = 0;
+
+    snprintf(path, sizeof path, MW_TEST_DATA "/bounce_%s.txt", name);
+    f = fopen(path, "r");
+    if (f == NULL) { fprintf(stderr, "cannot open %s\n", path); return 0; }
+    s_runs = 0;
+    while (fgets(line, sizeof line, f) && s_runs < RUNS_MAX) {
+        unsigned level, us;
+        if (line[0] == '#' || sscanf(line, "%u %u", &level, &us) != 2) continue;
+        s_run[s_runs].level = (uint8_t)(level != 0u);
+        s_run[s_runs].start = t;
+        s_run[s_runs].end   = t += us;
+        s_runs++;
+    }
+    fclose(f);
+    return s_runs != 0u;
+}
+
+/* Level at `t`; after the trace it stays where it ended */
+static uint8_t level_at(uint32_t t)
+{
+    for (uint32_t i = 0; i < s_runs; i++)
+        if (t < s_run[i].end) return s_run[i].level;
+    return s_run[s_runs - 1u].level;
+}
+
+/* First rising edge after `t`, 0 if none */
+static uint32_t edge_after(uint32_t t)
+{
+    for (uint32_t i = 1; i < s_runs; i++)
+        if (s_run[i].start > t && s_run[i].level && !s_run[i - 1u].level) return s_run[i].start;
+    return 0;
+}
+
+/* Start of the run `t` falls in */
+static uint32_t run_start(uint32_t t)
+{
+    for (uint32_t i = 0; i < s_runs; i++)
+        if (t < s_run[i].end) return s_run[i].start;
+    return s_run[s_runs - 1u].start;
+}
+
+/* EXTI + TIM7 replay; returns the number of edges that got through */
+static uint32_t replay(void)
+{
+    btn_t    b = { .phase = BTN_IDLE };
+    uint32_t t = 0, edges = 0;
+
+    s_evs = 0;
+    for (;;) {
+        uint32_t e = edge_after(t);                 /* line armed */
+        if (e == 0u) break;
+        btn_edge(&b);
+        edges++;
+        t = e;
+        do {                                        /* line masked, TIM7 shots */
+            t += SCAN_US;
+            ButtonEvent ev = btn_scan(&b, level_at(t));
+            if (ev != BTN_EV_NONE && s_evs < EVENTS_MAX) s_ev[s_evs++] = (Event){ ev, t };
+        } while (b.phase != BTN_IDLE);
+    }
+    return edges;
+}
+
+static uint32_t count(ButtonEvent ev)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < s_evs; i++) n += (s_ev[i].ev == ev);
+    return n;
+}
+
+/* One press: PRESS ... [LONG REPEAT*] ... RELEASE. LONG comes BTN_LONG_MS
+   after PRESS, then the repeats, each period 1/4 shorter than the last
+   down to BTN_REPEAT_MIN_MS, on the scan grid. Nothing is due in between
+   the last of them and RELEASE. */
+static void check_press(const char *name, uint32_t repeats)
+{
+    CHECK_EQ(count(BTN_EV_PRESS), 1);
+    CHECK_EQ(count(BTN_EV_RELEASE), 1);
+    CHECK_EQ(count(BTN_EV_LONG), repeats ? 1 : 0);
+    CHECK_EQ(count(BTN_EV_REPEAT), repeats ? repeats - 1u : 0);
+    if (s_evs < 2u || s_ev[0].ev != BTN_EV_PRESS || s_ev[s_evs - 1u].ev != BTN_EV_RELEASE) {
+        fprintf(stderr, "%s: events out of order\n", name);
+        unit_failed++;
+        return;
+    }
+
+    uint32_t press = s_ev[0].t, release = s_ev[s_evs - 1u].t;
+    CHECK(level_at(press) && !level_at(release));
+    CHECK_LE(press, edge_after(0) + 8u * SCAN_US);  /* soon after the first edge */
+    CHECK_LE(release, run_start(release) + BTN_DEBOUNCE_SCANS * SCAN_US);   /* and once open */
+
+    uint32_t due = press + BTN_LONG_MS * 1000u, period = BTN_REPEAT_MS;
+    for (uint32_t i = 1; i + 1u < s_evs; i++) {
+        CHECK_EQ(s_ev[i].ev, (i == 1u) ? BTN_EV_LONG : BTN_EV_REPEAT);
+        CHECK_EQ(s_ev[i].t, due);
+        if (i > 1u) {
+            period -= period / 4u;
+            if (period < BTN_REPEAT_MIN_MS) period = BTN_REPEAT_MIN_MS;
+        }
+        due = s_ev[i].t + (period + BTN_SCAN_MS - 1u) / BTN_SCAN_MS * SCAN_US;
+    }
+    CHECK(release <= due);
+}
+
+static const struct {
+    const char *name;
+    uint32_t    repeats;    /* LONG + REPEATs */
+} k_traces[] = {
+    { "clean",        0  },
+    { "chatter",      0  },
+    { "release_tail", 0  },
+    { "dropout",      0  },
+    { "long",         10 },
+    { "late",         0  },
+};
+
+static void test_traces(void)
+{
+    for (uint32_t i = 0; i < sizeof(k_traces) / sizeof(k_traces[0]); i++) {
+        int before = unit_failed;
+        if (!load(k_traces[i].name)) { unit_failed++; continue; }
+        replay();
+        check_press(k_traces[i].name, k_traces[i].repeats);
+        if (unit_failed != before) fprintf(stderr, "  in bounce_%s.txt\n", k_traces[i].name);
+    }
+}
+
+/* The bounce costs nothing: one edge per press, and the stray one after
+   the release only starts a confirmation that finds the key low */
+static void test_edges(void)
+{
+    CHECK(load("chatter"));
+    CHECK_EQ(replay(), 1);
+    CHECK(load("release_tail"));
+    CHECK_EQ(replay(), 1);
+    CHECK(load("late"));
+    CHECK_EQ(replay(), 2);
+    CHECK_EQ(s_evs, 2);
+}
+
+/* The repeat period settles at BTN_REPEAT_MIN_MS */
+static void test_repeat_floor(void)
+{
+    btn_t    b = { .phase = BTN_IDLE };
+    uint32_t last = 0, gap = 0, n = 0;
+
+    btn_edge(&b);
+    for (uint32_t t = SCAN_US; t <= 5000u * 1000u; t += SCAN_US) {
+        ButtonEvent ev = btn_scan(&b, 1);
+        if (ev != BTN_EV_REPEAT) continue;
+        if (last) gap = t - last;
+        last = t;
+        n++;
+    }
+    CHECK(n > 20u);
+    CHECK_EQ(gap, BTN_REPEAT_MIN_MS * 1000u);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_traces);
+    UNIT_RUN(test_edges);
+    UNIT_RUN(test_repeat_floor);
+    UNIT_DONE();
+}
@@ -0,0 +1,107 @@
+#include <stdint.h>
+#include "heater_sd.h"
+#include "micro_wave_oven.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Burst-fire modulator. sd_step() over long runs at every level:
+*           the exact average, every SD_FULL-cycle window, and the
+*           flicker (longest on / off run, switches per window); then the
+*           TIM3 side of heater_sd.c (built with MW_HEATER_SD = 1).
+******************************************************/
+
+#define WINDOWS     50u             /* SD_FULL-cycle windows per level */
+
+static uint32_t ceil_div(uint32_t a, uint32_t b) { return (a + b - 1u) / b; }
+
+static void test_levels(void)
+{
+    for (uint32_t level = 0; level <= SD_FULL; level++) {
+        sd_mod_t m = { (uint8_t)level, 0 };
+        uint8_t  hist[SD_FULL] = { 0 };
+        uint32_t on = 0, win = 0, run = 0, max_on = 0, max_off = 0, switches = 0;
+        uint8_t  prev = 2;
+
+        for (uint32_t k = 0; k < WINDOWS * SD_FULL; k++) {
+            uint8_t s = sd_step(&m);
+            on += s;
+            /* sliding window of SD_FULL cycles, once it is full */
+            win += s;
+            win -= hist[k % SD_FULL];
+            hist[k % SD_FULL] = s;
+            if (k >= SD_FULL - 1u) CHECK_EQ(win, level);
+
+            run = (s == prev) ? run + 1u : 1u;
+            if (prev != 2 && s != prev) switches++;
+            prev = s;
+            if (s && run > max_on)   max_on  = run;
+            if (!s && run > max_off) max_off = run;
+        }
+        CHECK_EQ(on, level * WINDOWS);
+        /* on-cycles as evenly spread as whole cycles allow */
+        if (level > 0u && level < SD_FULL) {
+            CHECK_LE(max_off, ceil_div(SD_FULL - level, level));
+            CHECK_LE(max_on,  ceil_div(level, SD_FULL - level));
+        }
+        /* switch count: 2 per on-burst, min(level, SD_FULL - level) bursts */
+        uint32_t bursts = (level < SD_FULL - level) ? level : SD_FULL - level;
+        CHECK_LE(switches, 2u * bursts * WINDOWS);
+    }
+}
+
+/* The level may change at any cycle: the on-count never drifts more
+   than one cycle from the sum of the requested levels */
+static void test_changing_level(void)
+{
+    sd_mod_t m = { 0, 0 };
+    uint64_t want = 0, on = 0;
+    uint32_t rng = 12345u;
+
+    for (uint32_t k = 0; k < 200000u; k++) {
+        if ((k & 63u) == 0u) {
+            rng = rng * 1664525u + 1013904223u;
+            m.level = (uint8_t)((rng >> 8) % (SD_FULL + 1u));
+        }
+        want += m.level;
+        on   += sd_step(&m);
+        CHECK(on * SD_FULL <= want && want < (on + 1u) * SD_FULL);
+    }
+}
+
+/* HeaterSd_Tick from the TIM3 update: one decision per MW_SD_CYCLE_TICKS,
+   the first on the tick after Start; Stop clears the IRQ and the output */
+static void test_tim3(void)
+{
+    TIM_TypeDef *t = htim3.Instance;
+    uint32_t on = 0;
+
+    t->ARR = 99u;
+    HeaterSd_Start(37);
+    CHECK(t->DIER & TIM_IT_UPDATE);
+    CHECK_EQ(t->CCR3, 0);
+    for (uint32_t tick = 0; tick < 1000u * MW_SD_CYCLE_TICKS; tick++) {
+        HeaterSd_Tick();
+        if (tick % MW_SD_CYCLE_TICKS == 0u) {
+            CHECK(t->CCR3 == 0u || t->CCR3 == t->ARR + 1u);
+            on += (t->CCR3 != 0u);
+        }
+    }
+    CHECK_EQ(on, 370);
+
+    HeaterSd_Set(250);                      /* clamped to SD_FULL */
+    for (uint32_t tick = 0; tick < 3u * MW_SD_CYCLE_TICKS; tick++) HeaterSd_Tick();
+    CHECK_EQ(t->CCR3, t->ARR + 1u);
+
+    HeaterSd_Stop();
+    CHECK(!(t->DIER & TIM_IT_UPDATE));
+    CHECK_EQ(t->CCR3, 0);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_levels);
+    UNIT_RUN(test_changing_level);
+    UNIT_RUN(test_tim3);
+    UNIT_DONE();
+}
@@ -0,0 +1,348 @@
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "kvs.h"
+#include "kvs_file.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Flash key/value store on the file backend (kvs_file.h) with
+*           small sectors, so compaction comes often. Scripted cases for
+*           the torn-record skip, the order of a compaction, the pick
+*           between two headed sectors and tombstones; then a fuzzer that
+*           cuts the power at random erase / program operations (in Init
+*           too), reboots and checks that every key reads back its last
+*           committed value. A write cut short may come back as either
+*           its old or its new value, never as anything else.
+******************************************************/
+
+#define IMAGE       "kvs_flash.bin"     /* in the build directory */
+#define SECTOR      1024u
+#define KEYS        8u
+#define VAL_MAX     40u
+#define MAGIC       0x3153564Bu
+#define STEPS       200000u
+
+typedef struct {
+    uint16_t len;                       /* 0 = absent */
+    uint8_t  d[VAL_MAX];
+} Value;
+
+static const kvs_flash_t *s_fl;
+static jmp_buf            s_boot;
+static Value              s_model[KEYS];
+static uint8_t            s_snap[2u * SECTOR];
+
+static uint32_t s_cuts;
+
+static void cut(void)
+{
+    s_cuts++;
+    longjmp(s_boot, 1);
+}
+
+static uint32_t s_rng = 1u;
+static uint32_t rnd(uint32_t n)
+{
+    s_rng = s_rng * 1664525u + 1013904223u;
+    return (s_rng >> 8) % n;
+}
+
+static uint32_t rd32(uint8_t sec, uint32_t off)
+{
+    uint32_t w;
+    memcpy(&w, kvs_file_sector(sec) + off, 4);
+    return w;
+}
+
+static void wr32(uint8_t sec, uint32_t off, uint32_t w)
+{
+    memcpy(kvs_file_sector(sec) + off, &w, 4);
+}
+
+/* Power up; a cut inside Init powers up again */
+static void boot(void)
+{
+    while (setjmp(s_boot) != 0) { }
+    CHECK(Kvs_Init(s_fl));
+    kvs_file_cut_at = 0;
+}
+
+static void fresh(void)
+{
+    memset(kvs_file_sector(0), 0xFF, 2u * SECTOR);
+    memset(s_model, 0, sizeof(s_model));
+    kvs_file_cut_at = 0;
+    kvs_file_cut = cut;
+    boot();
+}
+
+static uint8_t reads(uint16_t key, const Value *v)
+{
+    uint8_t  buf[KVS_MAX_VALUE];
+    uint16_t len = Kvs_Get(key, buf, sizeof(buf));
+    return len == v->len && memcmp(buf, v->d, len) == 0;
+}
+
+static uint8_t all_read_back(void)
+{
+    uint8_t ok = 1;
+    for (uint16_t k = 0; k < KEYS; k++) ok &= reads(k, &s_model[k]);
+    return ok;
+}
+
+static void put(uint16_t key, uint16_t len, uint8_t fill)
+{
+    s_model[key].len = len;
+    memset(s_model[key].d, fill, len);
+    CHECK(Kvs_Put(key, s_model[key].d, len));
+}
+
+/* Active sector as boot would pick it */
+static uint8_t active(void)
+{
+    uint8_t v0 = rd32(0, 0) == MAGIC, v1 = rd32(1, 0) == MAGIC;
+    if (v0 && v1) return ((int32_t)(rd32(1, 4) - rd32(0, 4)) > 0) ? 1u : 0u;
+    return v1;
+}
+
+/* Records of `key` in sector `sec`, tombstones included */
+static uint32_t records_of(uint8_t sec, uint16_t key)
+{
+    uint32_t off = 8u, n = 0;
+    while (off + 4u <= SECTOR) {
+        uint32_t hdr = rd32(sec, off);
+        if (hdr == 0xFFFFFFFFu) break;
+        n += ((uint16_t)hdr == key);
+        off += 4u + (((hdr >> 16) + 3u) & ~3u) + 4u;
+    }
+    return n;
+}
+
+/* Writes until the next Put of `len` bytes has to compact */
+static void fill_to_compaction(uint16_t len)
+{
+    Value saved[KEYS];
+    for (uint32_t i = 0;; i++) {
+        uint8_t  a = active();
+        uint32_t seq = rd32(a, 4);
+        memcpy(s_snap, kvs_file_sector(0), sizeof(s_snap));
+        memcpy(saved, s_model, sizeof(saved));
+        put((uint16_t)(i % KEYS), len, (uint8_t)i);
+        if (active() != a || rd32(active(), 4) != seq) {
+            /* that one compacted: roll it back */
+            memcpy(kvs_file_sector(0), s_snap, sizeof(s_snap));
+            memcpy(s_model, saved, sizeof(saved));
+            boot();
+            return;
+        }
+    }
+}
+
+/* --- scripted -------------------------------------------------------------- */
+
+static void test_reopen(void)
+{
+    fresh();
+    put(1, 4, 0x11);
+    put(2, 9, 0x22);
+    CHECK(Kvs_Delete(1));
+    s_model[1].len = 0;
+
+    s_fl = kvs_file_open(IMAGE, SECTOR);        /* new mapping, same file */
+    CHECK(s_fl != NULL);
+    boot();
+    CHECK(all_read_back());
+    CHECK_EQ(kvs_file_bad_programs, 0);
+}
+
+/* A record without its CRC is skipped, and the log goes on after it */
+static void test_torn_record(void)
+{
+    static const uint32_t words = 1u + 2u + 1u;     /* header, 8 bytes, CRC */
+    for (uint32_t at = 1; at <= words; at++) {
+        fresh();
+        put(3, 8, 0xA1);
+        Value before = s_model[3];
+
+        kvs_file_cut_at = kvs_file_ops + at;
+        if (setjmp(s_boot) == 0) {
+            uint8_t v[8];
+            memset(v, 0xB2, sizeof(v));
+            Kvs_Put(3, v, sizeof(v));
+            CHECK(0);                               /* the cut never came */
+        }
+        boot();
+        CHECK(reads(3, &before));
+
+        put(4, 5, 0xC3);                            /* appends after the torn one */
+        put(3, 6, 0xD4);
+        boot();
+        CHECK(all_read_back());
+    }
+    CHECK_EQ(kvs_file_bad_programs, 0);
+}
+
+/* Cut a compaction at every one of its operations: until the new header's
+   magic is in, boot keeps the old sector; after it, the new one */
+static void test_compact_order(void)
+{
+    uint8_t  image[2u * SECTOR];
+    Value    model[KEYS];
+    uint32_t at;
+
+    fresh();
+    fill_to_compaction(20);
+    memcpy(image, kvs_file_sector(0), sizeof(image));
+    memcpy(model, s_model, sizeof(model));
+    uint8_t  old_act = active();
+    uint32_t old_seq = rd32(old_act, 4);
+
+    for (at = 1;; at++) {
+        memcpy(kvs_file_sector(0), image, sizeof(image));
+        memcpy(s_model, model, sizeof(model));
+        boot();
+        kvs_file_cut_at = kvs_file_ops + at;
+        if (setjmp(s_boot) == 0) {
+            put(7, 20, 0x77);
+            kvs_file_cut_at = 0;
+            break;                                  /* ran to the end */
+        }
+        s_model[7] = model[7];
+        boot();
+        if (rd32(old_act ^ 1u, 0) != MAGIC) {
+            CHECK_EQ(active(), old_act);
+            CHECK_EQ(rd32(old_act, 4), old_seq);
+        } else {                                    /* (Init may have compacted again) */
+            CHECK((int32_t)(rd32(active(), 4) - old_seq) > 0);
+        }
+        CHECK(all_read_back());
+    }
+    CHECK(at > KEYS);                               /* erase + records + header */
+    CHECK(active() != old_act);
+    boot();
+    CHECK(all_read_back());
+    CHECK_EQ(kvs_file_bad_programs, 0);
+}
+
+/* Right after a compaction both sectors are headed; the later sequence
+   wins, across the 32-bit wrap as well */
+static void test_both_headed(void)
+{
+    fresh();
+    fill_to_compaction(20);
+    Value    old5 = s_model[5];
+    put(5, 3, 0x55);                                /* compacts */
+    Value    new5 = s_model[5];
+    uint8_t  a = active(), o = (uint8_t)(a ^ 1u);
+    CHECK_EQ(rd32(o, 0), MAGIC);
+    CHECK_EQ(rd32(a, 4), rd32(o, 4) + 1u);
+
+    boot();
+    CHECK(reads(5, &new5));
+
+    wr32(o, 4, 0xFFFFFFFFu);                        /* new one wrapped to 0 */
+    wr32(a, 4, 0x00000000u);
+    boot();
+    CHECK(reads(5, &new5));
+
+    wr32(o, 4, 0x00000001u);                        /* the other way round */
+    boot();
+    CHECK(reads(5, &old5));
+}
+
+static void test_tombstone(void)
+{
+    fresh();
+    uint32_t ops = kvs_file_ops;
+    CHECK(Kvs_Delete(6));                           /* absent: nothing written */
+    CHECK_EQ(kvs_file_ops, ops);
+
+    put(6, 12, 0x66);
+    CHECK(Kvs_Delete(6));
+    s_model[6].len = 0;
+    CHECK(reads(6, &s_model[6]));
+    boot();
+    CHECK(reads(6, &s_model[6]));
+    CHECK_EQ(records_of(active(), 6), 2);           /* value + tombstone */
+
+    /* compaction copies live records only: the key is gone for good */
+    fill_to_compaction(20);
+    CHECK(Kvs_Delete(6));
+    s_model[6].len = 0;
+    put(7, 20, 0x70);                               /* compacts */
+    CHECK_EQ(records_of(active(), 6), 0);
+    boot();
+    CHECK(all_read_back());
+}
+
+/* --- power-cut fuzzer ------------------------------------------------------ */
+
+static uint16_t s_key;
+static Value    s_old, s_new;
+
+static void fuzz_step(void)
+{
+    s_key = (uint16_t)rnd(KEYS);
+    s_old = s_model[s_key];
+    if (rnd(5) == 0) {
+        s_new.len = 0;
+    } else if (rnd(4) == 0 && s_old.len) {
+        s_new = s_old;                              /* same again: no write */
+    } else {
+        s_new.len = (uint16_t)(1u + rnd(VAL_MAX));
+        for (uint16_t i = 0; i < s_new.len; i++) s_new.d[i] = (uint8_t)rnd(256);
+    }
+
+    kvs_file_cut_at = rnd(2) ? 0u : kvs_file_ops + 1u + rnd(rnd(2) ? 16u : 120u);
+    if (setjmp(s_boot) == 0) {
+        uint8_t ok = s_new.len ? Kvs_Put(s_key, s_new.d, s_new.len) : Kvs_Delete(s_key);
+        CHECK(ok);
+        s_model[s_key] = s_new;
+        if (kvs_file_cut_at > kvs_file_ops) kvs_file_cut_at = 0;
+        if (rnd(10) == 0) boot();
+    } else {
+        boot();                                     /* lost the write, or not */
+        if (reads(s_key, &s_new)) s_model[s_key] = s_new;
+        else CHECK(reads(s_key, &s_old));
+    }
+}
+
+static void test_power_cuts(void)
+{
+    uint32_t compactions = 0, seq;
+
+    fresh();
+    kvs_file_seed = 0x2545F491u;
+    s_cuts = 0;
+    seq = rd32(active(), 4);
+    for (uint32_t i = 0; i < STEPS; i++) {
+        fuzz_step();
+        if (rd32(active(), 4) != seq) { seq = rd32(active(), 4); compactions++; }
+        if (!all_read_back()) {
+            fprintf(stderr, "step %u: key %u does not read back\n", (unsigned)i, (unsigned)s_key);
+            unit_failed++;
+            return;
+        }
+    }
+    CHECK(s_cuts > 1000u);
+    CHECK(compactions > 100u);
+    CHECK_EQ(kvs_file_bad_programs, 0);
+}
+
+int main(void)
+{
+    s_fl = kvs_file_open(IMAGE, SECTOR);
+    if (s_fl == NULL) { fprintf(stderr, "cannot map " IMAGE "\n"); return 1; }
+
+    UNIT_RUN(test_reopen);
+    UNIT_RUN(test_torn_record);
+    UNIT_RUN(test_compact_order);
+    UNIT_RUN(test_both_headed);
+    UNIT_RUN(test_tombstone);
+    UNIT_RUN(test_power_cuts);
+    kvs_file_close();
+    UNIT_DONE();
+}
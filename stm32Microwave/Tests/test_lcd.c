@@ -0,0 +1,91 @@
+#include "lcd.h"
+#include "gui.h"
+#include "hal_stub.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : SPI traffic of the LCD primitives (DMA + 16-bit repeat fills,
+*           no framebuffer). A window costs CASET + 4 bytes, RASET + 4
+*           bytes and RAMWR: five blocking transactions, fewer when an
+*           axis is unchanged since the last window.
+******************************************************/
+
+#define WIN_TX       5u
+#define WIN_BYTES    11u
+
+/* Forget the cached window (MADCTL resend), then count from zero */
+static void cold(void)
+{
+    LCD_SetRotation(0);
+    host_spi_reset();
+}
+
+static void test_clear_cold(void)
+{
+    cold();
+    LCD_Clear(BLUE);
+    CHECK_EQ(host_spi.tx, WIN_TX);
+    CHECK_EQ(host_spi.tx_dma, 1);
+    CHECK_EQ(host_spi.bytes, WIN_BYTES + 128u * 160u * 2u);
+    CHECK_EQ(hspi1.Init.DataSize, SPI_DATASIZE_8BIT);     /* 16-bit mode undone */
+}
+
+static void test_clear_warm(void)
+{
+    cold();
+    LCD_Clear(BLUE);
+    host_spi_reset();
+    LCD_Clear(RED);                                       /* same window: RAMWR only */
+    CHECK_EQ(host_spi_transactions(), 2);
+}
+
+static void test_fill(void)
+{
+    cold();
+    LCD_FillRect(4, 4, 8, 4, GREEN);                      /* one 64-byte line burst */
+    CHECK_EQ(host_spi.tx, WIN_TX);
+    CHECK_EQ(host_spi.tx_dma, 1);
+    CHECK_EQ(host_spi.bytes, WIN_BYTES + 8u * 4u * 2u);
+
+    cold();
+    LCD_FillRect(0, 0, 128, 100, GREEN);                  /* 16-bit repeat, one DMA */
+    CHECK_LE(host_spi_transactions(), WIN_TX + 1u);
+    CHECK_EQ(host_spi.bytes, WIN_BYTES + 128u * 100u * 2u);
+
+    cold();
+    LCD_FillRect(0, 0, 10, 1, GREEN);                     /* below LCD_DMA_MIN_BYTES */
+    CHECK_EQ(host_spi.tx, WIN_TX + 1u);
+    CHECK_EQ(host_spi.tx_dma, 0);
+}
+
+static void test_text(void)
+{
+    static const uint8_t s[] = "12:34";
+    const uint32_t n = sizeof s - 1u;
+    const uint32_t cell = 8u * 16u * 2u;
+    const uint32_t per_cell = (cell + LCD_TXBUF_PIXELS * 2u - 1u) / (LCD_TXBUF_PIXELS * 2u);
+
+    cold();
+    LCD_ShowChar(0, 0, WHITE, BLACK, 'A', 16, 0);         /* one window, one burst per staging buffer */
+    CHECK_LE(host_spi_transactions(), WIN_TX + per_cell);
+    CHECK_EQ(host_spi.bytes, WIN_BYTES + cell);
+
+    /* along a row only CASET moves: RASET is skipped after the first cell */
+    cold();
+    LCD_ShowString(0, 0, 16, (uint8_t *)s, 0);
+    CHECK_LE(host_spi_transactions(), (WIN_TX + per_cell) + (n - 1u) * (WIN_TX - 2u + per_cell));
+    CHECK_LE(host_spi.bytes, n * (WIN_BYTES + cell));
+}
+
+int main(void)
+{
+    Font_Init();
+    LCD_Init();
+
+    UNIT_RUN(test_clear_cold);
+    UNIT_RUN(test_clear_warm);
+    UNIT_RUN(test_fill);
+    UNIT_RUN(test_text);
+    UNIT_DONE();
+}
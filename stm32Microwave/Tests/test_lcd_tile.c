@@ -0,0 +1,214 @@
+#include <string.h>
+#include "lcd.h"
+#include "lcd_tile.h"
+#include "gui.h"
+#include "task.h"
+#include "hal_stub.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : lcd_tile.c against gui.c. One scene is drawn twice, with the
+*           gui.c / lcd.c primitives and as a display list through
+*           TILE_Render, and the two panel images the SPI mock decodes
+*           (hal_stub.h) must match pixel for pixel. The scene runs ops
+*           across the tile seams (80 px tiles, 16 px bands) and off the
+*           screen edges. With the DMA deferred, a tile buffer may not be
+*           touched while it is on the wire.
+******************************************************/
+
+#define W       ST7735_WIDTH
+#define H       ST7735_HEIGHT
+#define BG      DARKBLUE
+#define TILES   (((W + LCD_TILE_PIXELS / LCD_TILE_ROWS - 1u) / (LCD_TILE_PIXELS / LCD_TILE_ROWS)) * \
+                 ((H + LCD_TILE_ROWS - 1u) / LCD_TILE_ROWS))
+
+static uint16_t s_img[12][16];
+static uint16_t s_ref[HOST_PANEL_W * HOST_PANEL_H];
+
+static const struct { uint16_t x, y; uint8_t r; uint16_t c; uint8_t fill; } k_circle[] = {
+    {  80,  48, 20, WHITE,   0 },     /* centred on a tile corner */
+    {   5, 150, 12, MAGENTA, 0 },     /* off the left and bottom edges */
+    {  80, 100, 15, BLUE,    1 },     /* chords across the seam */
+    {   0,  70, 10, GREEN,   1 },     /* half off the left edge */
+    { 125, 120,  8, CYAN,    1 },     /* and the right one */
+    { 300, 300, 10, RED,     1 },     /* nowhere near the screen */
+};
+
+/* gui.c has no filled circle: the reference draws the chords t_circle
+   draws, clipped here instead of per tile */
+static void ref_span(int xa, int xb, int y, uint16_t c)
+{
+    if (y < 0 || y >= (int)H) return;
+    if (xa < 0) xa = 0;
+    if (xb >= (int)W) xb = W - 1;
+    if (xa <= xb) LCD_FillRect((uint16_t)xa, (uint16_t)y, (uint16_t)(xb - xa + 1), 1, c);
+}
+
+static void ref_fill_circle(int xc, int yc, int r, uint16_t c)
+{
+    int a = 0, b = r, di = 3 - 2 * r;
+    while (a <= b) {
+        ref_span(xc - b, xc + b, yc + a, c);
+        ref_span(xc - b, xc + b, yc - a, c);
+        ref_span(xc - a, xc + a, yc + b, c);
+        ref_span(xc - a, xc + a, yc - b, c);
+        if (di < 0) di += 4 * a + 6;
+        else { di += 4 * (a - b) + 10; b--; }
+        a++;
+    }
+}
+
+static void scene_gui(void)
+{
+    LCD_Clear(BG);
+    LCD_FillRect(70, 10, 20, 30, RED);                    /* both seams */
+    LCD_FillRect(120, 150, 20, 20, GREEN);                /* off the corner */
+
+    POINT_COLOR = YELLOW; LCD_DrawLine(0, 0, W - 1, H - 1);
+    POINT_COLOR = CYAN;   LCD_DrawLine(W - 1, 5, 2, 47);
+    POINT_COLOR = GRAY;   LCD_DrawLine(40, 100, 40, 140);
+
+    for (uint32_t i = 0; i < sizeof k_circle / sizeof k_circle[0]; i++) {
+        if (k_circle[i].fill) ref_fill_circle(k_circle[i].x, k_circle[i].y, k_circle[i].r, k_circle[i].c);
+        else                  Draw_Circle(k_circle[i].x, k_circle[i].y, k_circle[i].c, k_circle[i].r);
+    }
+
+    POINT_COLOR = WHITE; BACK_COLOR = BLACK;
+    LCD_ShowString(60, 24, 16, (uint8_t *)"Tile 12", 0);
+    POINT_COLOR = RED;
+    LCD_ShowString(74, 58, 12, (uint8_t *)"seam", 1);     /* transparent, over the circle */
+    POINT_COLOR = BLACK; BACK_COLOR = YELLOW;
+    LCD_ShowString(124, 130, 16, (uint8_t *)"XY", 0);     /* cut at the right edge */
+
+    LCD_DrawImage565(72, 74, 16, 12, &s_img[0][0]);
+}
+
+static void scene_tile(void)
+{
+    TILE_Begin(BG);
+    CHECK(TILE_Rect(70, 10, 20, 30, RED));
+    CHECK(TILE_Rect(120, 150, 20, 20, GREEN));
+
+    CHECK(TILE_Line(0, 0, W - 1, H - 1, YELLOW));
+    CHECK(TILE_Line(W - 1, 5, 2, 47, CYAN));
+    CHECK(TILE_Line(40, 100, 40, 140, GRAY));
+
+    for (uint32_t i = 0; i < sizeof k_circle / sizeof k_circle[0]; i++)
+        CHECK(TILE_Circle(k_circle[i].x, k_circle[i].y, k_circle[i].r, k_circle[i].c, k_circle[i].fill));
+
+    CHECK(TILE_Text(60, 24, WHITE, BLACK, "Tile 12", 16, 0));
+    CHECK(TILE_Text(74, 58, RED, BLACK, "seam", 12, 1));
+    CHECK(TILE_Text(124, 130, BLACK, YELLOW, "XY", 16, 0));
+
+    CHECK(TILE_Image(72, 74, 16, 12, &s_img[0][0]));
+}
+
+/* Pixels of the screen area that differ from the reference */
+static uint32_t diff_area(uint16_t x, uint16_t y, uint16_t w, uint16_t h)
+{
+    uint32_t n = 0;
+    for (uint16_t r = y; r < y + h; r++)
+        for (uint16_t c = x; c < x + w; c++)
+            n += host_panel.ram[r * HOST_PANEL_W + c] != s_ref[r * HOST_PANEL_W + c];
+    return n;
+}
+
+static void draw_reference(void)
+{
+    host_panel_reset(0);
+    scene_gui();
+    CHECK_EQ(host_panel.unknown, 0);
+    memcpy(s_ref, host_panel.ram, sizeof s_ref);
+}
+
+static void test_scene(void)
+{
+    draw_reference();
+
+    host_panel_reset(0x5A5A);
+    host_spi_reset();
+    scene_tile();
+    TILE_Render();
+    CHECK_EQ(diff_area(0, 0, W, H), 0);
+    CHECK_EQ(host_panel.pixels, W * H);                   /* every pixel once */
+    CHECK_EQ(host_panel.clipped, 0);
+    CHECK_EQ(host_panel.unknown, 0);
+    CHECK_EQ(host_spi.tx_dma, TILES);                     /* one block per tile */
+}
+
+/* Only the area is sent, on its own tile grid */
+static void test_area(void)
+{
+    draw_reference();
+
+    host_panel_reset(0x5A5A);
+    scene_tile();
+    TILE_RenderArea(70, 20, 30, 30);
+    CHECK_EQ(diff_area(70, 20, 30, 30), 0);
+    CHECK_EQ(host_panel.pixels, 30u * 30u);
+
+    host_panel_reset(0x5A5A);
+    TILE_RenderArea(100, 150, 100, 100);                  /* cut to the screen */
+    CHECK_EQ(diff_area(100, 150, W - 100u, H - 150u), 0);
+    CHECK_EQ(host_panel.pixels, (W - 100u) * (H - 150u));
+}
+
+static uint32_t s_waits;
+
+static void finish_dma(void)
+{
+    s_waits++;
+    host_spi_dma_done();
+}
+
+/* Each tile renders while the one before it is on the wire: the buffer it
+   draws into went out two tiles ago and must be idle by then */
+static void test_dma_overlap(void)
+{
+    host_scheduler_state = taskSCHEDULER_RUNNING;
+    host_wait_hook = finish_dma;
+    host_spi_dma_defer = 1;
+
+    draw_reference();
+
+    host_panel_reset(0x5A5A);
+    host_spi_reset();
+    s_waits = 0;
+    scene_tile();
+    TILE_Render();
+    CHECK_EQ(diff_area(0, 0, W, H), 0);
+    CHECK_EQ(host_spi.torn, 0);
+    CHECK_EQ(host_spi.overlap, 0);
+    CHECK_EQ(s_waits, TILES);                             /* each block waited for, once */
+
+    host_spi_dma_defer = 0;
+    host_wait_hook = NULL;
+    host_scheduler_state = taskSCHEDULER_NOT_STARTED;
+}
+
+static void test_list_full(void)
+{
+    TILE_Begin(BG);
+    for (uint32_t i = 0; i < LCD_TILE_OPS; i++) CHECK(TILE_Rect(0, 0, 1, 1, RED));
+    CHECK(!TILE_Rect(0, 0, 1, 1, RED));
+    CHECK(!TILE_Text(0, 0, WHITE, BLACK, "A", 16, 0));
+    CHECK(TILE_Rect(0, 0, 0, 1, RED));                    /* empty: nothing to record */
+}
+
+int main(void)
+{
+    for (uint16_t y = 0; y < 12; y++)
+        for (uint16_t x = 0; x < 16; x++)
+            s_img[y][x] = (uint16_t)((x * 2u) << 11 | (y * 5u) << 5 | (x + y));
+
+    Font_Init();
+    LCD_Init();
+    LCD_SetRotation(0);
+
+    UNIT_RUN(test_scene);
+    UNIT_RUN(test_area);
+    UNIT_RUN(test_dma_overlap);
+    UNIT_RUN(test_list_full);
+    UNIT_DONE();
+}
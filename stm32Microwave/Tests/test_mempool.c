@@ -0,0 +1,193 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "mempool.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Message pool. Single-thread behaviour, then a stress run:
+*           producer threads allocate, stamp and hand blocks to consumer
+*           threads (or free them themselves), with LDREX/STREX emulated
+*           by host_cmsis.c. Every block must be owned by at most one
+*           thread at a time, and all of them must be back on the free
+*           list at the end.
+******************************************************/
+
+#define BLK_SIZE    20u             /* rounds up to 24 */
+#define BLK_COUNT   8u
+#define PRODUCERS   4
+#define CONSUMERS   4
+#define ITER        100000u
+
+MEMPOOL_STORAGE(s_mem, BLK_SIZE, BLK_COUNT);
+static MemPool s_pool;
+
+static uint32_t blk_index(const void *b)
+{
+    return (uint32_t)(((const uint8_t *)b - (const uint8_t *)s_mem) / s_pool.block_size);
+}
+
+/* Walk the free list: 1 if it holds each block exactly once */
+static int free_list_complete(void)
+{
+    uint8_t  seen[BLK_COUNT] = { 0 };
+    uint32_t n = s_pool.head, len = 0;
+    while (n != 0u) {
+        if (n > BLK_COUNT || seen[n - 1u] || ++len > BLK_COUNT) return 0;
+        seen[n - 1u] = 1;
+        n = ((const MemPoolBlock *)((const uint8_t *)s_mem + (n - 1u) * s_pool.block_size))->next;
+    }
+    return len == BLK_COUNT;
+}
+
+static void test_single(void)
+{
+    void *b[BLK_COUNT];
+    MemPoolStats st;
+
+    MemPool_Init(&s_pool, s_mem, BLK_SIZE, BLK_COUNT);
+    CHECK_EQ(s_pool.block_size, 24);
+    CHECK(free_list_complete());
+
+    for (uint32_t i = 0; i < BLK_COUNT; i++) {
+        b[i] = MemPool_Alloc(&s_pool);
+        CHECK(b[i] != NULL);
+        CHECK_EQ((uintptr_t)b[i] % 8u, 0);
+    }
+    CHECK(MemPool_Alloc(&s_pool) == NULL);
+
+    MemPool_Free(&s_pool, (uint8_t *)b[0] + 4);     /* not a block start */
+    MemPool_Free(&s_pool, &st);                     /* not from the pool */
+    MemPool_GetStats(&s_pool, &st, 0);
+    CHECK_EQ(st.used, BLK_COUNT);
+    CHECK_EQ(st.peak, BLK_COUNT);
+    CHECK_EQ(st.fail, 1);
+
+    for (uint32_t i = 0; i < BLK_COUNT; i++) MemPool_Free(&s_pool, b[i]);
+    MemPool_GetStats(&s_pool, &st, 1);
+    CHECK_EQ(st.used, 0);
+    CHECK(free_list_complete());
+    MemPool_GetStats(&s_pool, &st, 0);
+    CHECK_EQ(st.peak, 0);
+    CHECK_EQ(st.fail, 0);
+}
+
+/* --- stress --------------------------------------------------------------- */
+
+typedef struct {
+    uint32_t producer;
+    uint32_t seq;
+} Stamp;
+
+static atomic_int   s_owned[BLK_COUNT];
+static atomic_uint  s_errors;
+static atomic_uint  s_nulls;
+static atomic_int   s_producers_left;
+
+/* Hand-off ring between the threads; the pool is what is under test */
+static pthread_mutex_t s_mx = PTHREAD_MUTEX_INITIALIZER;
+static void           *s_ring[BLK_COUNT];
+static uint32_t        s_ring_head, s_ring_tail;
+
+static void take(void *b, uint32_t producer, uint32_t seq)
+{
+    uint32_t i = blk_index(b);
+    if (atomic_exchange(&s_owned[i], 1) != 0) atomic_fetch_add(&s_errors, 1);  /* handed out twice */
+    Stamp s = { producer, seq };
+    memcpy(b, &s, sizeof s);
+}
+
+static void give_back(void *b, uint32_t producer, uint32_t seq)
+{
+    Stamp s;
+    memcpy(&s, b, sizeof s);
+    if (s.producer != producer || s.seq != seq) atomic_fetch_add(&s_errors, 1);   /* overwritten */
+    if (atomic_exchange(&s_owned[blk_index(b)], 0) != 1) atomic_fetch_add(&s_errors, 1);
+    MemPool_Free(&s_pool, b);
+}
+
+static void *producer(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    for (uint32_t seq = 0; seq < ITER; seq++) {
+        void *b;
+        while ((b = MemPool_Alloc(&s_pool)) == NULL) {
+            atomic_fetch_add(&s_nulls, 1);
+            sched_yield();
+        }
+        take(b, id, seq);
+
+        if (seq & 1u) {                         /* every other one: free here */
+            give_back(b, id, seq);
+            continue;
+        }
+        for (;;) {
+            pthread_mutex_lock(&s_mx);
+            if (s_ring_head - s_ring_tail < BLK_COUNT) {
+                s_ring[s_ring_head++ % BLK_COUNT] = b;
+                pthread_mutex_unlock(&s_mx);
+                break;
+            }
+            pthread_mutex_unlock(&s_mx);
+            sched_yield();
+        }
+    }
+    atomic_fetch_sub(&s_producers_left, 1);
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    (void)arg;
+    for (;;) {
+        void *b = NULL;
+        pthread_mutex_lock(&s_mx);
+        if (s_ring_head != s_ring_tail) b = s_ring[s_ring_tail++ % BLK_COUNT];
+        pthread_mutex_unlock(&s_mx);
+
+        if (b == NULL) {
+            if (atomic_load(&s_producers_left) == 0) {
+                pthread_mutex_lock(&s_mx);
+                int empty = (s_ring_head == s_ring_tail);
+                pthread_mutex_unlock(&s_mx);
+                if (empty) return NULL;
+            }
+            sched_yield();
+            continue;
+        }
+        Stamp s;
+        memcpy(&s, b, sizeof s);
+        give_back(b, s.producer, s.seq);
+    }
+}
+
+static void test_stress(void)
+{
+    pthread_t    tp[PRODUCERS], tc[CONSUMERS];
+    MemPoolStats st;
+
+    MemPool_Init(&s_pool, s_mem, BLK_SIZE, BLK_COUNT);
+    atomic_store(&s_producers_left, PRODUCERS);
+
+    for (int i = 0; i < CONSUMERS; i++) pthread_create(&tc[i], NULL, consumer, NULL);
+    for (int i = 0; i < PRODUCERS; i++) pthread_create(&tp[i], NULL, producer, (void *)(uintptr_t)i);
+    for (int i = 0; i < PRODUCERS; i++) pthread_join(tp[i], NULL);
+    for (int i = 0; i < CONSUMERS; i++) pthread_join(tc[i], NULL);
+
+    CHECK_EQ(atomic_load(&s_errors), 0);
+    MemPool_GetStats(&s_pool, &st, 0);
+    CHECK_EQ(st.used, 0);                       /* nothing lost */
+    CHECK_LE(st.peak, BLK_COUNT);
+    CHECK_EQ(st.fail, atomic_load(&s_nulls));
+    CHECK(free_list_complete());                /* nothing duplicated */
+    for (uint32_t i = 0; i < BLK_COUNT; i++) CHECK_EQ(atomic_load(&s_owned[i]), 0);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_single);
+    UNIT_RUN(test_stress);
+    UNIT_DONE();
+}
@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "oven_rig.h"
+#include "kvs.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Controller fuzz run. Each seed resets the oven and feeds it a
+*           random mix of what the outside world can post (keys, console
+*           commands, door, stale ticks, PROGDEF) in bursts, with time
+*           passing in between. After every burst, and every second of
+*           time, the outputs are checked against the safety and
+*           bookkeeping invariants below. A failure prints the seed and
+*           the last events; `test_mw_fsm <seed>` replays one seed.
+******************************************************/
+
+#define SEEDS       300u
+#define STEPS       400u
+#define TRAIL       24u
+
+static uint32_t s_rng;
+static uint32_t s_seed;
+
+static uint32_t rnd(uint32_t n)
+{
+    s_rng = s_rng * 1664525u + 1013904223u;
+    return (s_rng >> 8) % n;
+}
+
+/* Last events, for the report */
+static struct { uint8_t type; uint8_t after; uint32_t arg; } s_trail[TRAIL];
+static uint32_t s_trail_n;
+
+static void trail_dump(void)
+{
+    uint32_t first = (s_trail_n > TRAIL) ? s_trail_n - TRAIL : 0u;
+    fprintf(stderr, "seed %u, last events (-> state after the burst):\n", (unsigned)s_seed);
+    for (uint32_t i = first; i < s_trail_n; i++) {
+        uint8_t t = s_trail[i % TRAIL].type;
+        if (t == 0xFF)
+            fprintf(stderr, "  +%u ms", (unsigned)s_trail[i % TRAIL].arg);
+        else
+            fprintf(stderr, "  %s(%u)", rig_event_name(t), (unsigned)s_trail[i % TRAIL].arg);
+        fprintf(stderr, " -> %s\n", rig_state_name(s_trail[i % TRAIL].after));
+    }
+}
+
+static void trail_add(uint8_t type, uint32_t arg)
+{
+    s_trail[s_trail_n % TRAIL].type  = type;
+    s_trail[s_trail_n % TRAIL].arg   = arg;
+    s_trail[s_trail_n % TRAIL].after = 0xFF;
+    s_trail_n++;
+}
+
+static uint32_t s_visits[STATE_COUNT];
+
+static void trail_settle(uint32_t from)
+{
+    s_visits[rig_state()]++;
+    for (uint32_t i = from; i < s_trail_n; i++) s_trail[i % TRAIL].after = (uint8_t)rig_state();
+}
+
+/* --- invariants ------------------------------------------------------------ */
+
+/* Name of the first broken invariant, NULL if all hold */
+static const char *broken(void)
+{
+    uint8_t cooking = (rig_state() == STATE_COOKING);
+
+    if (mw1.state != rig_state())                          return "mw->state follows the machine";
+    if (mw1.door == DOOR_OPEN && rig_heater_on())          return "no heater while the door is open";
+    if (rig_heater_on() && !cooking)                       return "heater only while COOKING";
+    if ((mw1.heating == HEATING_ON) != cooking)            return "heating flag == COOKING";
+    if (cooking && mw1.door != DOOR_CLOSED)                return "door closed while COOKING";
+    if ((mw1.door == DOOR_CLOSED) != (rig_door_us() == DOOR_CLOSE_US))
+                                                           return "servo follows the door";
+    if ((rig_turntable_duty() != 0u) != cooking)           return "turntable only while COOKING";
+    if (rig_countdown_armed() != cooking)                  return "countdown armed only while COOKING";
+    if (rig_lp_mode != (rig_in(STATE_IDLE) ? LP_MODE_STOP : LP_MODE_SLEEP))
+                                                           return "STOP in IDLE, SLEEP in ACTIVE";
+    if (rig_in(STATE_IDLE) == rig_in(STATE_ACTIVE))        return "in exactly one superstate";
+    if (rig_state() == STATE_WAIT_DOOR && !rig_prog_running())
+                                                           return "WAIT_DOOR only in a program";
+    if (mw1.cooking_time > 999000u)                        return "time fits the display";
+    if (rig_msg_used() != 0u)                              return "message blocks all freed";
+    if (rig_kvs_writes_heating != 0u)                      return "no flash write while heating";
+    if (rig_in(STATE_IDLE) && rig_store_pending())         return "settings stored once in IDLE";
+    return NULL;
+}
+
+static int check(void)
+{
+    const char *why = broken();
+    if (why == NULL) return 1;
+    fprintf(stderr, "invariant \"%s\" broken in %s\n", why, rig_state_name((uint8_t)rig_state()));
+    trail_dump();
+    unit_failed++;
+    return 0;
+}
+
+/* --- inputs ---------------------------------------------------------------- */
+
+static void post_random(void)
+{
+    uint8_t  type;
+    uint16_t arg = 0;
+
+    switch (rnd(16)) {
+        case 0: case 1: case 2: type = MW_EV_KEY_MODE;   break;
+        case 3: case 4: case 5: type = MW_EV_KEY_ACTION; break;
+        case 6:  type = (uint8_t)(MW_EV_KEY_RELEASE + rnd(3)); arg = (uint16_t)rnd(2); break;
+        case 7:  type = MW_EV_SET_TIME;  arg = (uint16_t)rnd(1100); break;
+        case 8:  type = MW_EV_SET_POWER; arg = (uint16_t)rnd(4);    break;
+        case 9:  case 10: type = MW_EV_DOOR_OPEN;  break;
+        case 11: case 12: type = MW_EV_DOOR_CLOSE; break;
+        case 13: type = rnd(2) ? MW_EV_START : MW_EV_STOP; break;
+        case 14:
+            if (rnd(8)) { type = MW_EV_PROGRAM; arg = (uint16_t)rnd(rcp_count() + 1u); }
+            else        { type = MW_EV_SET_CAL; arg = (uint16_t)(int16_t)(rnd(401) - 200); }
+            break;
+        default:
+            if (rnd(2)) { type = MW_EV_TICK; break; }       /* stale compare */
+            {
+                rcp_stage_t st[RCP_USER_STAGES];
+                uint8_t     n    = (uint8_t)rnd(RCP_USER_STAGES + 1u);
+                uint8_t     slot = (uint8_t)rnd(RCP_USER_SLOTS);
+                for (uint8_t i = 0; i < n; i++) {
+                    st[i].op  = (uint8_t)(RCP_COOK + rnd(3));
+                    st[i].pct = (uint8_t)rnd(101);
+                    st[i].arg = (uint16_t)((st[i].op == RCP_COOK) ? rnd(5) * rnd(300) : 1u + rnd(3));
+                }
+                trail_add(MW_EV_PROGDEF, slot);
+                rig_post_progdef(slot, st, n);
+            }
+            return;
+    }
+    trail_add(type, arg);
+    rig_post((MwEventType)type, arg);
+}
+
+/* Let `ms` pass a second at a time; a plain cook must be over on time */
+static int pass_time(uint32_t ms)
+{
+    uint32_t from = s_trail_n;
+    trail_add(0xFF, ms);
+    while (ms) {
+        uint32_t step  = (ms > 1000u) ? 1000u : ms;
+        uint8_t  plain = (rig_state() == STATE_COOKING && !rig_prog_running());
+        uint32_t left  = mw1.cooking_time;
+        rig_advance_ms(step);
+        ms -= step;
+        trail_settle(from);
+        if (!check()) return 0;
+        if (plain && step >= left && rig_state() == STATE_COOKING) {
+            fprintf(stderr, "cook of %u ms still running after %u ms\n", (unsigned)left, (unsigned)step);
+            trail_dump();
+            unit_failed++;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int fuzz_seed(uint32_t seed)
+{
+    s_seed = seed;
+    s_rng = seed * 2654435761u + 1u;
+    s_trail_n = 0;
+    rig_reset();
+    if (!check()) return 0;
+
+    for (uint32_t step = 0; step < STEPS; step++) {
+        if (rnd(4) == 0) {
+            if (!pass_time(rnd(8) ? 1u + rnd(1500) : rnd(200000))) return 0;
+            continue;
+        }
+        uint32_t from = s_trail_n, burst = 1u + (rnd(4) == 0 ? rnd(4) : 0u);
+        while (burst--) post_random();
+        rig_run();
+        trail_settle(from);
+        if (!check()) return 0;
+    }
+    return 1;
+}
+
+static void test_fuzz(void)
+{
+    for (uint32_t seed = 1; seed <= SEEDS; seed++)
+        if (!fuzz_seed(seed)) return;
+    for (uint8_t s = 0; s < STATE_COUNT; s++) {     /* every leaf reached */
+        if (s == STATE_IDLE || s == STATE_ACTIVE) continue;
+        if (s_visits[s] == 0u) fprintf(stderr, "%s never reached\n", rig_state_name(s));
+        CHECK(s_visits[s] != 0u);
+    }
+}
+
+/* --- scripted -------------------------------------------------------------- */
+
+static void test_door_interlock(void)
+{
+    rig_reset();
+    rig_post(MW_EV_SET_TIME, 5);
+    rig_post(MW_EV_START, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_COOKING);
+    CHECK(rig_heater_on());
+    CHECK_EQ(rig_door_us(), DOOR_CLOSE_US);
+
+    rig_advance_ms(2000);
+    rig_post(MW_EV_DOOR_OPEN, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_DOOR_OPEN);
+    CHECK(!rig_heater_on());
+    CHECK_EQ(mw1.cooking_time, 3000);
+
+    rig_post(MW_EV_START, 0);                       /* no start with the door open */
+    rig_post(MW_EV_KEY_ACTION, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_DOOR_OPEN);
+    CHECK(!rig_heater_on());
+
+    rig_post(MW_EV_DOOR_CLOSE, 0);
+    rig_post(MW_EV_START, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_COOKING);
+    uint32_t holds = rig_lp_holds;
+    rig_advance_ms(3000);
+    CHECK_EQ(rig_state(), STATE_COMPLETED);
+    CHECK(!rig_heater_on());
+    CHECK_EQ(mw1.door, DOOR_OPEN);
+    CHECK(rig_lp_holds > holds);                    /* no STOP while the door swings open */
+    CHECK(broken() == NULL);
+}
+
+static void test_stale_tick(void)
+{
+    rig_reset();
+    rig_post(MW_EV_SET_TIME, 2);
+    rig_post(MW_EV_START, 0);
+    rig_run();
+    rig_advance_ms(500);
+    rig_post(MW_EV_KEY_ACTION, 0);                  /* pause, then a tick that was queued behind */
+    rig_post(MW_EV_TICK, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_PAUSED);
+    CHECK_EQ(mw1.cooking_time, 1500);
+    rig_advance_ms(5000);
+    CHECK_EQ(mw1.cooking_time, 1500);
+    CHECK(broken() == NULL);
+}
+
+/* Settings changed on the way into a cook, or during one, are written
+   when it is over */
+static void test_store_deferred(void)
+{
+    static const rcp_stage_t st[] = { RCP_STAGE_COOK(40, 2) };
+    rcp_stage_t back[RCP_USER_STAGES];
+    uint8_t     lvl = 0xFF;
+    uint32_t    cycles = 0;
+    int16_t     cal = 0;
+
+    rig_reset();
+    rig_post(MW_EV_DOOR_CLOSE, 0);
+    rig_post(MW_EV_SET_TIME, 3);
+    rig_post(MW_EV_KEY_MODE, 0);                    /* TIME_SETTING */
+    rig_post(MW_EV_KEY_MODE, 0);                    /* POWER_SETTING */
+    rig_post(MW_EV_KEY_ACTION, 0);                  /* next level */
+    rig_post(MW_EV_START, 0);                       /* leaving it saves the level */
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_COOKING);
+    CHECK_EQ(rig_kvs_writes, 0);
+    CHECK(rig_store_pending());
+
+    rig_post_progdef(1, st, 1);
+    rig_post(MW_EV_SET_CAL, (uint16_t)-15);
+    rig_run();
+    CHECK(rig_heater_on());
+    CHECK_EQ(rig_kvs_writes, 0);
+
+    rig_advance_ms(3000);
+    CHECK_EQ(rig_state(), STATE_COMPLETED);
+    CHECK(!rig_store_pending());
+    CHECK_EQ(rig_kvs_writes, 4);                    /* level, count, offset, program */
+    CHECK_EQ(rig_kvs_writes_heating, 0);
+    CHECK_EQ(Kvs_Get(KVS_KEY_POWER, &lvl, 1), 1);
+    CHECK_EQ(lvl, mw1.power);
+    CHECK_EQ(Kvs_Get(KVS_KEY_CYCLES, &cycles, sizeof(cycles)), sizeof(cycles));
+    CHECK_EQ(cycles, 1);
+    CHECK_EQ(Kvs_Get(KVS_KEY_RECIPE0 + 1, back, sizeof(back)), sizeof(st));
+    CHECK_EQ(Kvs_Get(KVS_KEY_THERM_CAL, &cal, sizeof(cal)), sizeof(cal));
+    CHECK_EQ(cal, -15);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {                                 /* replay one seed */
+        uint32_t seed = (uint32_t)strtoul(argv[1], NULL, 0);
+        fuzz_seed(seed);
+        UNIT_DONE();
+    }
+    UNIT_RUN(test_door_interlock);
+    UNIT_RUN(test_stale_tick);
+    UNIT_RUN(test_store_deferred);
+    UNIT_RUN(test_fuzz);
+    UNIT_DONE();
+}
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <string.h>
+#include "micro_wave_oven.h"
+#include "kvs.h"
+#include "lowpower.h"
+#include "lcd.h"
+#include "font.h"
+#include "hal_stub.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Golden image of the start screen. micro_wave_init() draws
+*           into the shadow framebuffer (LCD_USE_FRAMEBUFFER = 1), the
+*           result is read back with LCD_ReadImage565 and compared with
+*           data/mw_init.ppm (binary PPM, RGB565 widened to 8 bits).
+*           On a mismatch the rendering is left in mw_init.actual.ppm in
+*           the build directory; --update rewrites the golden file.
+******************************************************/
+
+#define GOLDEN  MW_TEST_DATA "/mw_init.ppm"
+#define W       ST7735_WIDTH
+#define H       ST7735_HEIGHT
+
+led_d              led1 = { GPIOD, GPIO_PIN_12 };
+Beep_HandleTypeDef hbeep;
+MicrowaveCtrl      mw1;
+
+/* Nothing stored: the screen shows the default power level */
+uint16_t Kvs_Get(uint16_t key, void *dst, uint16_t max)
+{
+    (void)key; (void)dst; (void)max;
+    return 0;
+}
+
+void LowPower_Hold(uint32_t ms) { (void)ms; }
+
+static uint16_t s_px[W * H];
+static uint8_t  s_rgb[W * H * 3];
+static uint8_t  s_gold[W * H * 3];
+
+static void to_rgb(void)
+{
+    for (uint32_t i = 0; i < W * H; i++) {
+        uint16_t c = s_px[i];
+        uint8_t  r = (uint8_t)(c >> 11), g = (uint8_t)((c >> 5) & 0x3F), b = (uint8_t)(c & 0x1F);
+        s_rgb[3*i]     = (uint8_t)((r << 3) | (r >> 2));
+        s_rgb[3*i + 1] = (uint8_t)((g << 2) | (g >> 4));
+        s_rgb[3*i + 2] = (uint8_t)((b << 3) | (b >> 2));
+    }
+}
+
+static int ppm_write(const char *path, const uint8_t *rgb)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    fprintf(f, "P6\n%d %d\n255\n", W, H);
+    int ok = fwrite(rgb, 1, W * H * 3, f) == W * H * 3;
+    return fclose(f) == 0 && ok;
+}
+
+static int ppm_read(const char *path, uint8_t *rgb)
+{
+    FILE *f = fopen(path, "rb");
+    int w = 0, h = 0, max = 0;
+    if (!f) return 0;
+    int ok = fscanf(f, "P6 %d %d %d", &w, &h, &max) == 3 && fgetc(f) == '\n' &&
+             w == W && h == H && max == 255 &&
+             fread(rgb, 1, W * H * 3, f) == W * H * 3;
+    fclose(f);
+    return ok;
+}
+
+static void test_init_screen(void)
+{
+    micro_wave_init(&mw1);
+
+    CHECK(LCD_ReadImage565(0, 0, W, H, s_px));
+    to_rgb();
+
+    CHECK(ppm_read(GOLDEN, s_gold));
+    uint32_t diff = 0;
+    for (uint32_t i = 0; i < W * H; i++)
+        if (memcmp(&s_rgb[3*i], &s_gold[3*i], 3) != 0) diff++;
+    CHECK_EQ(diff, 0);
+    if (diff) ppm_write("mw_init.actual.ppm", s_rgb);
+
+    /* the screen reached the panel: nothing left for the next flush */
+    host_spi_reset();
+    LCD_Flush();
+    CHECK_EQ(host_spi_transactions(), 0);
+}
+
+int main(int argc, char **argv)
+{
+    Font_Init();
+    LCD_Init();
+
+    if (argc > 1 && strcmp(argv[1], "--update") == 0) {
+        micro_wave_init(&mw1);
+        LCD_ReadImage565(0, 0, W, H, s_px);
+        to_rgb();
+        if (!ppm_write(GOLDEN, s_rgb)) { perror(GOLDEN); return 1; }
+        printf("wrote %s\n", GOLDEN);
+        return 0;
+    }
+
+    UNIT_RUN(test_init_screen);
+    UNIT_DONE();
+}
@@ -0,0 +1,187 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "heater_pid.h"
+#include "plant.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : pid.c against a thermal plant (plant.h) with the gains,
+*           limits and slew of heater_pid.h: step response overshoot and
+*           settling, then the fixed-point edges (Q16 products at the
+*           int32 limits, output clamps) and the anti-windup strategies.
+******************************************************/
+
+/* The firmware's tuning */
+#define I_LIMIT     MW_PID_I_LIMIT
+#define SLEW        MW_PID_SLEW
+#define DUTY_MAX    MW_HEATER_DUTY_MAX
+#define PERIOD_MS   MW_PID_PERIOD_MS
+
+/* A loaded cavity: +1.0 degC per % at steady state, 40 s time constant,
+   2 s before the load feels a change */
+static plant_t s_plant = { .ambient = 200.0, .gain = 10.0, .tau = 400.0, .delay = 20u };
+
+static pid_q16_t heater_pid(uint8_t aw)
+{
+    pid_q16_t p = {
+        .kp = MW_PID_KP, .ki = MW_PID_KI, .kd = MW_PID_KD,
+        .out_min = 0, .out_max = DUTY_MAX,
+        .i_min = -I_LIMIT, .i_max = I_LIMIT,
+        .slew = SLEW, .aw = aw,
+    };
+    return p;
+}
+
+typedef struct {
+    int32_t  peak;          /* highest measurement */
+    uint32_t settle_ms;     /* end of the last period outside the band */
+    int32_t  final;
+    uint32_t max_move;      /* largest output change in one period */
+} Response;
+
+/* `steps` periods towards sp from the plant's and controller's current
+   state; band in 0.1 degC */
+static Response run(pid_q16_t *p, int32_t sp, uint32_t steps, int32_t band)
+{
+    Response r = { INT32_MIN, 0, 0, 0 };
+    int32_t  meas = (int32_t)s_plant.temp;
+    for (uint32_t k = 1; k <= steps; k++) {
+        int32_t  before = p->out;
+        int32_t  u = pid_step(p, sp, meas);
+        uint32_t move = (uint32_t)((u > before) ? u - before : before - u);
+        if (move > r.max_move) r.max_move = move;
+        meas = plant_step(&s_plant, u);
+        if (meas > r.peak) r.peak = meas;
+        if (meas < sp - band || meas > sp + band) r.settle_ms = k * PERIOD_MS;
+    }
+    r.final = meas;
+    return r;
+}
+
+/* Cold load, heater off, as HeaterPid_Start finds it */
+static void start(pid_q16_t *p)
+{
+    plant_reset(&s_plant);
+    pid_reset(p, (int32_t)s_plant.temp, 0);
+}
+
+/* Low / Medium / High setpoints (HeaterPid_Start: N % -> N degC) from
+   20 degC: at most 10 degC over, within 1 degC after two minutes, and
+   the output never moves faster than the slew limit */
+static void test_step_response(void)
+{
+    static const int32_t sp[] = { 500, 700, 1000 };
+    for (uint32_t i = 0; i < sizeof(sp) / sizeof(sp[0]); i++) {
+        pid_q16_t p = heater_pid(PID_AW_CONDITIONAL);
+        start(&p);
+        Response r = run(&p, sp[i], 3000u, 10);
+        CHECK_LE(r.peak, sp[i] + 100);
+        CHECK_LE(r.settle_ms, 120000u);
+        CHECK_EQ(r.final, sp[i]);
+        CHECK_LE(r.max_move, SLEW);
+    }
+}
+
+/* The integral alone holds the duty at the setpoint: High needs 80 %
+   on this plant, and an integrator limit below that leaves an offset */
+static void test_holds_high_duty(void)
+{
+    pid_q16_t p = heater_pid(PID_AW_CONDITIONAL);
+    start(&p);
+    run(&p, 1000, 6000u, 10);
+    CHECK_EQ((int32_t)(p.integ >> 16), 80);
+    CHECK_EQ(p.out, 80);
+}
+
+/* --- fixed point ----------------------------------------------------------- */
+
+static void test_q16(void)
+{
+    CHECK_EQ(PID_Q16(1.0), 65536);
+    CHECK_EQ(PID_Q16(0.5), 32768);
+    CHECK_EQ(PID_Q16(-0.5), -32768);
+    CHECK_EQ(PID_Q16(0.2), 13107);
+    CHECK_EQ(PID_Q16(-0.2), -13107);
+
+    /* P only: the output is Kp * err to the nearest count (halves up) */
+    pid_q16_t p = { .kp = PID_Q16(0.2), .out_min = -1000, .out_max = 1000,
+                    .i_min = 0, .i_max = 0 };
+    for (int32_t err = -500; err <= 500; err++) {
+        pid_reset(&p, 0, 0);
+        int32_t u = pid_step(&p, err, 0);
+        int64_t twice = 2 * (int64_t)u - (2 * (int64_t)p.kp * err) / 65536;
+        CHECK(twice >= -1 && twice <= 1);
+    }
+}
+
+/* Products at the int32 edges go through int64 and clamp, never wrap */
+static void test_saturation(void)
+{
+    pid_q16_t p = { .kp = INT32_MAX, .ki = INT32_MAX, .kd = INT32_MAX,
+                    .out_min = 0, .out_max = DUTY_MAX,
+                    .i_min = -I_LIMIT, .i_max = I_LIMIT, .aw = PID_AW_CLAMP };
+    const int32_t big = 1000000000;
+
+    pid_reset(&p, -big, 0);
+    CHECK_EQ(pid_step(&p, big, -big), DUTY_MAX);             /* err = 2e9 */
+    CHECK_EQ(p.integ, (int64_t)I_LIMIT << 16);
+    CHECK_EQ(pid_step(&p, big, -big), DUTY_MAX);
+    CHECK_EQ(pid_step(&p, -big, big), 0);                   /* D: +2e9 in one step */
+    CHECK_EQ(p.integ, -((int64_t)I_LIMIT << 16));
+
+    p.kp = INT32_MIN + 1;                                   /* negative gains */
+    p.ki = p.kd = 0;
+    pid_reset(&p, 0, 0);
+    CHECK_EQ(pid_step(&p, big, -big), 0);
+    CHECK_EQ(pid_step(&p, -big, big), DUTY_MAX);
+
+    /* the slew limit holds even from a saturated request */
+    p = heater_pid(PID_AW_CLAMP);
+    p.kp = INT32_MAX;
+    pid_reset(&p, 0, 0);
+    for (int32_t k = 1; k <= 25; k++) CHECK_EQ(pid_step(&p, big, 0), (k * SLEW > DUTY_MAX) ? DUTY_MAX : k * SLEW);
+}
+
+/* --- anti-windup ----------------------------------------------------------- */
+
+/* The load does not warm for a minute (sensor off the load, frozen block):
+   the output sits at full power. CLAMP lets the integral run to its
+   limit, CONDITIONAL freezes it once the output saturates; once the
+   plant responds, the frozen one overshoots less. */
+static Response stuck_then_free(uint8_t aw, int64_t *integ_at_release)
+{
+    pid_q16_t p = heater_pid(aw);
+    start(&p);
+    for (uint32_t k = 0; k < 600u; k++) {
+        pid_step(&p, 500, 200);
+        CHECK(p.integ >= -((int64_t)I_LIMIT << 16) && p.integ <= ((int64_t)I_LIMIT << 16));
+    }
+    CHECK_EQ(p.out, DUTY_MAX);
+    *integ_at_release = p.integ;
+    return run(&p, 500, 3000u, 10);
+}
+
+static void test_antiwindup(void)
+{
+    int64_t  i_clamp, i_cond;
+    Response clamp = stuck_then_free(PID_AW_CLAMP, &i_clamp);
+    Response cond  = stuck_then_free(PID_AW_CONDITIONAL, &i_cond);
+
+    CHECK_EQ(i_clamp, (int64_t)I_LIMIT << 16);
+    CHECK_LE(i_cond >> 16, DUTY_MAX - (MW_PID_KP * 300 >> 16) + 1);     /* P + I reached the top */
+    CHECK(cond.peak < clamp.peak);
+    CHECK_LE(cond.peak, 500 + 150);
+    CHECK_EQ(cond.final, 500);
+    CHECK_EQ(clamp.final, 500);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_step_response);
+    UNIT_RUN(test_holds_high_duty);
+    UNIT_RUN(test_q16);
+    UNIT_RUN(test_saturation);
+    UNIT_RUN(test_antiwindup);
+    UNIT_DONE();
+}
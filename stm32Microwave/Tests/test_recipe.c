@@ -0,0 +1,267 @@
+#include <string.h>
+#include "oven_rig.h"
+#include "kvs.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Program interpreter in the controller, on the rig's clock:
+*           stage by stage through the built-in programs, pause and
+*           resume on both sides of a stage boundary, the STAGE_END
+*           hand-off (to COMPLETED, or nowhere once the program is gone),
+*           and one advance per stage when DONE arrives twice.
+******************************************************/
+
+#define DEFROST     0u
+#define REHEAT      1u
+#define POPCORN     2u
+#define USER0       3u
+
+static uint32_t heater_duty(uint8_t pct)
+{
+    return (pct * 99u + 50u) / 100u;        /* start_cooking, PWM heater */
+}
+
+static uint32_t cycles(void)
+{
+    uint32_t n = 0;
+    Kvs_Get(KVS_KEY_CYCLES, &n, sizeof(n));
+    return n;
+}
+
+static void start(uint8_t prog)
+{
+    rig_reset();
+    rig_post(MW_EV_DOOR_CLOSE, 0);
+    rig_post(MW_EV_PROGRAM, prog);
+    rig_run();
+}
+
+/* In COOKING at pct for s seconds */
+#define CHECK_STAGE(pct, s) do { \
+    CHECK_EQ(rig_state(), STATE_COOKING); \
+    CHECK_EQ(mw1.power_pct, (pct)); \
+    CHECK_EQ(rig_heater_duty(), heater_duty(pct)); \
+    CHECK_EQ(mw1.cooking_time, (s) * 1000u); \
+} while (0)
+
+/* Defrost: 30 % 180 s, rest 60 s, 80 % 120 s, 3 beeps, end */
+static void test_sequence(void)
+{
+    start(DEFROST);
+    CHECK_STAGE(30, 180);
+    CHECK(rig_prog_running());
+
+    rig_advance_ms(179999);
+    CHECK_EQ(rig_state(), STATE_COOKING);
+    CHECK_EQ(mw1.power_pct, 30);
+    rig_advance_ms(1);
+    CHECK_STAGE(0, 60);                     /* rest: no heat, still turning */
+    CHECK(rig_turntable_duty() != 0u);
+
+    rig_advance_ms(60000);
+    CHECK_STAGE(80, 120);
+    CHECK_EQ(rig_beeps, 0);
+
+    rig_advance_ms(120000);
+    CHECK_EQ(rig_state(), STATE_COMPLETED);
+    CHECK_EQ(rig_beeps, 3);
+    CHECK(!rig_prog_running());
+    CHECK(!rig_heater_on());
+    CHECK_EQ(mw1.door, DOOR_OPEN);
+    CHECK_EQ(mw1.power_pct, power_pct_from_level(mw1.power));   /* manual level back */
+    CHECK_EQ(cycles(), 1);
+}
+
+/* Reheat: 70 % 60 s, 1 beep, wait for the door, 70 % 60 s, 3 beeps */
+static void test_wait_door(void)
+{
+    start(REHEAT);
+    rig_advance_ms(60000);
+    CHECK_EQ(rig_state(), STATE_WAIT_DOOR);
+    CHECK_EQ(rig_beeps, 1);
+    CHECK(!rig_heater_on());
+
+    rig_post(MW_EV_DOOR_CLOSE, 0);          /* closed already: nothing */
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_WAIT_DOOR);
+    rig_post(MW_EV_DOOR_OPEN, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_WAIT_DOOR);
+    CHECK(!rig_heater_on());
+    rig_post(MW_EV_DOOR_CLOSE, 0);
+    rig_run();
+    CHECK_STAGE(70, 60);
+
+    rig_advance_ms(60000);
+    CHECK_EQ(rig_state(), STATE_COMPLETED);
+    CHECK_EQ(rig_beeps, 4);
+}
+
+/* Pause with 1 s left, wait, resume: the stage ends 1 s of cooking
+   later, not 1 s of wall time later */
+static void test_pause_before_boundary(void)
+{
+    start(REHEAT);
+    rig_advance_ms(59000);
+    rig_post(MW_EV_KEY_ACTION, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_PAUSED);
+    CHECK_EQ(mw1.cooking_time, 1000);
+    CHECK(!rig_heater_on());
+
+    rig_advance_ms(30000);
+    CHECK_EQ(rig_state(), STATE_PAUSED);
+    CHECK_EQ(rig_beeps, 0);
+
+    rig_post(MW_EV_KEY_ACTION, 0);
+    rig_run();
+    CHECK_STAGE(70, 1);
+    rig_advance_ms(999);
+    CHECK_EQ(rig_state(), STATE_COOKING);
+    rig_advance_ms(1);
+    CHECK_EQ(rig_state(), STATE_WAIT_DOOR);
+    CHECK_EQ(rig_beeps, 1);
+}
+
+/* The key lands in the same instant the stage runs out: the countdown
+   tick is queued ahead of it and its DONE behind it, so the pause comes
+   with no time left and DONE finds PAUSED. Resuming has to move on to
+   the next stage rather than leave the program stuck. */
+static void test_pause_at_boundary(void)
+{
+    start(DEFROST);
+    rig_advance_ms(179999);
+    rig_elapse_ms(1);                       /* tick queued */
+    rig_post(MW_EV_KEY_ACTION, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_PAUSED);
+    CHECK_EQ(mw1.cooking_time, 0);
+    CHECK(!rig_heater_on());
+
+    rig_advance_ms(5000);
+    CHECK_EQ(rig_state(), STATE_PAUSED);
+
+    rig_post(MW_EV_KEY_ACTION, 0);
+    rig_run();
+    CHECK_STAGE(0, 60);                     /* the rest stage */
+
+    /* a plain cook paused the same way completes on resume */
+    rig_reset();
+    rig_post(MW_EV_SET_TIME, 3);
+    rig_post(MW_EV_START, 0);
+    rig_run();
+    rig_advance_ms(2999);
+    rig_elapse_ms(1);
+    rig_post(MW_EV_KEY_ACTION, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_PAUSED);
+    rig_post(MW_EV_START, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_COMPLETED);
+    CHECK(!rig_heater_on());
+}
+
+/* Pause, open and close the door: the stage resumes where it was */
+static void test_door_mid_stage(void)
+{
+    start(DEFROST);
+    rig_advance_ms(200000);                 /* 20 s into the rest */
+    CHECK_STAGE(0, 40);
+    rig_post(MW_EV_DOOR_OPEN, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_DOOR_OPEN);
+    rig_advance_ms(10000);
+    rig_post(MW_EV_DOOR_CLOSE, 0);
+    rig_post(MW_EV_START, 0);
+    rig_run();
+    CHECK_STAGE(0, 40);
+    rig_advance_ms(40000);
+    CHECK_STAGE(80, 120);
+}
+
+/* STAGE_END: the end of a program completes it; after STOP the program
+   is gone and late STAGE_* events change nothing */
+static void test_stage_end(void)
+{
+    start(POPCORN);
+    rig_advance_ms(150000);
+    CHECK_EQ(rig_state(), STATE_COMPLETED);
+    CHECK_EQ(rig_beeps, 3);
+    CHECK_EQ(cycles(), 1);
+
+    start(DEFROST);
+    rig_advance_ms(179999);
+    rig_elapse_ms(1);                       /* tick -> DONE -> STAGE_COOK, queued */
+    rig_post(MW_EV_STOP, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_STANDBY);
+    CHECK(!rig_prog_running());
+    rig_post(MW_EV_STAGE_COOK, 0);
+    rig_post(MW_EV_STAGE_WAIT, 0);
+    rig_post(MW_EV_STAGE_END, 0);
+    rig_run();
+    CHECK_EQ(rig_state(), STATE_STANDBY);
+    CHECK(!rig_heater_on());
+    CHECK_EQ(cycles(), 0);
+    CHECK_EQ(mw1.power_pct, power_pct_from_level(mw1.power));
+
+    /* an empty user slot ends at once: no cook, nothing completed */
+    start(USER0);
+    CHECK_EQ(rig_state(), STATE_STANDBY);
+    CHECK(!rig_prog_running());
+    CHECK_EQ(cycles(), 0);
+}
+
+/* Two DONEs for one stage (a stale tick): one advance */
+static void test_one_advance_per_stage(void)
+{
+    start(DEFROST);
+    rig_post(MW_EV_DONE, 0);
+    rig_post(MW_EV_DONE, 0);
+    rig_run();
+    CHECK_STAGE(0, 60);
+    CHECK(rig_prog_running());
+}
+
+/* A user program: zero-length cooks are skipped, beeps run in between;
+   PROGDEF gets its one reply from the controller */
+static void test_user_program(void)
+{
+    static const rcp_stage_t st[] = {
+        RCP_STAGE_COOK(50, 0), RCP_STAGE_BEEP(2), RCP_STAGE_COOK(60, 5),
+        RCP_STAGE_REST(0), RCP_STAGE_BEEP(1),
+    };
+    rig_reset();
+    rig_post_progdef(0, st, sizeof(st) / sizeof(st[0]));
+    rig_run();
+    CHECK_EQ(rig_kvs_writes, 1);
+    CHECK(strcmp(rig_console, "OK\r\n") == 0);
+
+    rig_post(MW_EV_DOOR_CLOSE, 0);
+    rig_post(MW_EV_PROGRAM, USER0);
+    rig_run();
+    CHECK_STAGE(60, 5);
+    CHECK_EQ(rig_beeps, 2);
+
+    rig_console[0] = '\0';
+    rig_post_progdef(0, st, 1);             /* refused while it runs: one reply */
+    rig_run();
+    CHECK(strcmp(rig_console, "ERR BUSY\r\n") == 0);
+    rig_advance_ms(5000);
+    CHECK_EQ(rig_state(), STATE_COMPLETED);
+    CHECK_EQ(rig_beeps, 3);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_sequence);
+    UNIT_RUN(test_wait_door);
+    UNIT_RUN(test_pause_before_boundary);
+    UNIT_RUN(test_pause_at_boundary);
+    UNIT_RUN(test_door_mid_stage);
+    UNIT_RUN(test_stage_end);
+    UNIT_RUN(test_one_advance_per_stage);
+    UNIT_RUN(test_user_program);
+    UNIT_DONE();
+}
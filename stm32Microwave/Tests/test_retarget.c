@@ -0,0 +1,79 @@
+#include <string.h>
+#include "retarget.h"
+#include "hal_stub.h"
+#include "unit.h"
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : printf ring on USART2 TX DMA: a refused transfer is retried
+*           from Retarget_Poll(), not left until the next write
+******************************************************/
+
+static uint8_t s_buf[RETARGET_TX_RING];
+
+/* Let every queued transfer complete */
+static void drain(void)
+{
+    while (host_uart.in_flight) host_uart_tx_done();
+}
+
+static void test_refused_then_polled(void)
+{
+    memset(&host_uart, 0, sizeof host_uart);
+    host_uart_refuse = 1;
+    CHECK_EQ(Retarget_Write("hello", 5), 5);
+    CHECK_EQ(host_uart.refused, 1);
+    CHECK_EQ(host_uart.bytes, 0);
+
+    Retarget_Poll();                       /* the next HAL tick */
+    CHECK_EQ(host_uart.bytes, 5);
+    CHECK_EQ(host_uart.in_flight, 5);
+    drain();
+    CHECK_EQ(Retarget_Room(), RETARGET_TX_RING);
+}
+
+static void test_poll_idle(void)
+{
+    memset(&host_uart, 0, sizeof host_uart);
+    Retarget_Poll();                       /* nothing queued */
+    CHECK_EQ(host_uart.calls, 0);
+
+    CHECK_EQ(Retarget_Write("abc", 3), 3);
+    Retarget_Poll();                       /* transfer in flight */
+    CHECK_EQ(host_uart.calls, 1);
+    drain();
+}
+
+static void test_refused_many_ticks(void)
+{
+    memset(&host_uart, 0, sizeof host_uart);
+    host_uart_refuse = 5;                  /* UART comes up 5 ms late */
+    CHECK_EQ(Retarget_Write("boot\r\n", 6), 6);
+    for (int ms = 0; ms < 10; ms++) Retarget_Poll();
+    CHECK_EQ(host_uart.bytes, 6);
+    drain();
+    CHECK_EQ(host_uart.bytes, 6);
+    CHECK_EQ(Retarget_Dropped(), 0);
+}
+
+static void test_wrap(void)
+{
+    memset(&host_uart, 0, sizeof host_uart);
+    memset(s_buf, 'x', sizeof s_buf);
+    CHECK_EQ(Retarget_Write(s_buf, RETARGET_TX_RING - 100), RETARGET_TX_RING - 100);
+    drain();
+    host_uart.bytes = 0;
+    CHECK_EQ(Retarget_Write(s_buf, 300), 300);       /* crosses the end of the ring */
+    drain();
+    CHECK_EQ(host_uart.bytes, 300);
+    CHECK_EQ(Retarget_Room(), RETARGET_TX_RING);
+}
+
+int main(void)
+{
+    UNIT_RUN(test_refused_then_polled);
+    UNIT_RUN(test_poll_idle);
+    UNIT_RUN(test_refused_many_ticks);
+    UNIT_RUN(test_wrap);
+    UNIT_DONE();
+}
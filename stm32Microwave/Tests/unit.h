@@ -0,0 +1,47 @@
+#ifndef UNIT_H
+#define UNIT_H
+
+/******************************************************
+* Project : Microwave Oven Controller (STM32F407 + HAL)
+* Note    : Minimal host test macros. A failed CHECK reports and carries
+*           on; main() ends with UNIT_DONE(), which gives ctest the verdict.
+******************************************************/
+
+#include <stdio.h>
+
+static int unit_failed;
+
+#define CHECK(c) do { \
+    if (!(c)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); \
+        unit_failed++; \
+    } \
+} while (0)
+
+#define CHECK_EQ(a, b) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    if (a_ != b_) { \
+        fprintf(stderr, "%s:%d: %s == %s failed: %lld != %lld\n", \
+                __FILE__, __LINE__, #a, #b, a_, b_); \
+        unit_failed++; \
+    } \
+} while (0)
+
+#define CHECK_LE(a, b) do { \
+    long long a_ = (long long)(a), b_ = (long long)(b); \
+    if (a_ > b_) { \
+        fprintf(stderr, "%s:%d: %s <= %s failed: %lld > %lld\n", \
+                __FILE__, __LINE__, #a, #b, a_, b_); \
+        unit_failed++; \
+    } \
+} while (0)
+
+#define UNIT_RUN(fn) do { \
+    int before_ = unit_failed; \
+    fn(); \
+    printf("%-40s %s\n", #fn, (unit_failed == before_) ? "ok" : "FAILED"); \
+} while (0)
+
+#define UNIT_DONE() return unit_failed ? 1 : 0
+
+#endif /* UNIT_H */
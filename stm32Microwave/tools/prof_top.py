@@ -0,0 +1,156 @@
+#!/usr/bin/env python3
+"""Top-like view of the controller's profiling frames (BSP/prof.h).
+
+Sends PROF on the console UART, decodes the binary frame that comes back
+and prints per-task CPU load and stack headroom plus per-IRQ load. Loads
+are worked out from the difference between two frames against wall time
+(tick ms), so SLEEP/STOP time shows up as idle.
+
+    prof_top.py /dev/ttyACM0              refresh every second
+    prof_top.py /dev/ttyACM0 -n 1         one frame, since boot
+    prof_top.py --file capture.bin        decode frames from a raw capture
+
+Needs pyserial for a port.
+"""
+
+import argparse
+import binascii
+import struct
+import sys
+import time
+
+MAGIC = b"PRF1"
+HDR = struct.Struct("<4sHBBIIIB3x")
+TASK = struct.Struct("<16sIHBB")
+IRQ = struct.Struct("<III")
+
+STATES = ["RUN", "READY", "BLOCK", "SUSP", "DEL"]
+IRQS = ["EXTI1", "EXTI15_10", "TIM3", "TIM4", "TIM7",
+        "DMA1_S5", "DMA1_S6", "DMA2_S3", "USART2"]
+
+
+def parse(frame):
+    """Frame bytes (magic .. crc) -> dict, or None if the CRC is wrong."""
+    body, crc = frame[:-2], struct.unpack_from("<H", frame, len(frame) - 2)[0]
+    if binascii.crc_hqx(body, 0xFFFF) != crc:
+        return None
+    _, _, ntask, nirq, tick, hz, total, shift = HDR.unpack_from(frame, 0)
+    off = HDR.size
+    tasks = {}
+    for _ in range(ntask):
+        name, run, free, prio, state = TASK.unpack_from(frame, off)
+        off += TASK.size
+        name = name.split(b"\0", 1)[0].decode("ascii", "replace")
+        tasks[name] = dict(run=run, free=free, prio=prio, state=state)
+    irqs = []
+    for _ in range(nirq):
+        calls, lo, hi = IRQ.unpack_from(frame, off)
+        off += IRQ.size
+        irqs.append(dict(calls=calls, cycles=(hi << 32) | lo))
+    return dict(tick=tick, hz=hz, total=total, shift=shift, tasks=tasks, irqs=irqs)
+
+
+def frames(buf):
+    """Pull complete frames out of `buf` (bytearray, consumed in place)."""
+    out = []
+    while True:
+        i = buf.find(MAGIC)
+        if i < 0:
+            del buf[:max(0, len(buf) - len(MAGIC) + 1)]
+            return out
+        del buf[:i]
+        if len(buf) < HDR.size:
+            return out
+        length = struct.unpack_from("<H", buf, 4)[0]
+        if length < HDR.size + 2:
+            del buf[:len(MAGIC)]
+            continue
+        if len(buf) < length:
+            return out
+        snap = parse(bytes(buf[:length]))
+        if snap is None:
+            del buf[:len(MAGIC)]            # not a frame after all / corrupted
+            continue
+        out.append(snap)
+        del buf[:length]
+
+
+def show(cur, prev):
+    """Print loads between `prev` and `cur` (since boot without `prev`)."""
+    base = prev or dict(tick=0, tasks={}, irqs=[dict(calls=0, cycles=0)] * len(cur["irqs"]))
+    ms = max(1, (cur["tick"] - base["tick"]) & 0xFFFFFFFF)
+    cyc = ms * cur["hz"] / 1000.0               # cycles of wall time
+
+    print("\x1b[H\x1b[2J" if prev else "", end="")
+    print("t=%.3fs  core %.0f MHz  window %d ms" % (cur["tick"] / 1000.0, cur["hz"] / 1e6, ms))
+    print("%-16s %4s %-5s %6s %10s" % ("TASK", "PRIO", "STATE", "CPU%", "STACK FREE"))
+    busy = 0.0
+    rows = []
+    for name, t in cur["tasks"].items():
+        run0 = base["tasks"].get(name, {}).get("run", 0)
+        load = ((t["run"] - run0) & 0xFFFFFFFF) * (1 << cur["shift"]) / cyc * 100.0
+        if name != "IDLE":
+            busy += load
+        rows.append((load, name, t))
+    for load, name, t in sorted(rows, key=lambda r: -r[0]):
+        state = STATES[t["state"]] if t["state"] < len(STATES) else "?"
+        shown = max(0.0, 100.0 - busy) if name == "IDLE" else load
+        print("%-16s %4d %-5s %6.2f %10d" % (name, t["prio"], state, shown, t["free"] * 4))
+
+    print()
+    print("%-10s %9s %6s %9s" % ("IRQ", "CALLS/s", "CPU%", "AVG cyc"))
+    for i, q in enumerate(cur["irqs"]):
+        q0 = base["irqs"][i] if i < len(base["irqs"]) else dict(calls=0, cycles=0)
+        calls = (q["calls"] - q0["calls"]) & 0xFFFFFFFF
+        cycles = q["cycles"] - q0["cycles"]
+        name = IRQS[i] if i < len(IRQS) else "IRQ%d" % i
+        print("%-10s %9.1f %6.2f %9.0f" % (name, calls * 1000.0 / ms, cycles / cyc * 100.0,
+                                           cycles / calls if calls else 0))
+    sys.stdout.flush()
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", nargs="?", help="serial port of the console")
+    ap.add_argument("-b", "--baud", type=int, default=115200)
+    ap.add_argument("-i", "--interval", type=float, default=1.0, help="seconds between frames")
+    ap.add_argument("-n", "--count", type=int, default=0, help="frames to show (0: until ^C)")
+    ap.add_argument("--file", help="decode a raw capture instead of polling")
+    args = ap.parse_args()
+
+    if args.file:
+        with open(args.file, "rb") as f:
+            buf = bytearray(f.read())
+        prev = None
+        for snap in frames(buf):
+            show(snap, prev)
+            print()
+            prev = snap
+        return
+    if not args.port:
+        ap.error("a port or --file is needed")
+
+    import serial   # pyserial
+    ser = serial.Serial(args.port, args.baud, timeout=0.1)
+    buf = bytearray()
+    prev = None
+    shown = 0
+    try:
+        while args.count == 0 or shown < args.count:
+            ser.write(b"PROF\r\n")
+            deadline = time.time() + 2.0
+            got = []
+            while not got and time.time() < deadline:
+                buf += ser.read(512)
+                got = frames(buf)
+            if got:
+                show(got[-1], prev)
+                prev = got[-1]
+                shown += 1
+            time.sleep(args.interval)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""Convert the controller's event trace (BSP/trace.h) to Chrome trace JSON.
+
+Sends TRACE on the console UART (or reads a raw capture), decodes the
+binary frame and writes a JSON file for chrome://tracing or
+https://ui.perfetto.dev: one track per task with its run slices and the
+queue / semaphore operations it made, one per instrumented IRQ, and the
+LCD SPI and USART2 DMA transfers.
+
+    trace2chrome.py /dev/ttyACM0 -o trace.json     dump and convert
+    trace2chrome.py --file capture.bin -o t.json   last frame of a capture
+
+Times are from the core cycle counter at the SystemCoreClock in the frame;
+CYCCNT stops in SLEEP and STOP, so idle stretches come out shorter than
+they were. Needs pyserial for a port.
+"""
+
+import argparse
+import binascii
+import json
+import struct
+import sys
+import time
+
+MAGIC = b"TRC1"
+HDR = struct.Struct("<4sIIIHBx")
+TASK = struct.Struct("<H16s")
+REC = struct.Struct("<IBBH")
+
+EV_TASK_IN, EV_QUEUE_SEND, EV_QUEUE_RECV, EV_IRQ, EV_LCD_DMA, EV_LCD_DMA_DONE, \
+    EV_UART_TX, EV_UART_TX_DONE, EV_UART_RX, EV_MARK = range(1, 11)
+
+IRQS = ["EXTI1", "EXTI15_10", "TIM3", "TIM4", "TIM7",
+        "DMA1_S5", "DMA1_S6", "DMA2_S3", "USART2"]
+
+PID = 1
+TID_ISR = 900               # queue operations from ISRs
+TID_LCD = 901
+TID_UART_TX = 902
+TID_UART_RX = 903
+TID_IRQ = 1000              # + ProfIrq
+
+
+def parse(frame):
+    """Frame bytes (magic .. crc) -> dict, or None if the CRC is wrong."""
+    body, crc = frame[:-2], struct.unpack_from("<H", frame, len(frame) - 2)[0]
+    if binascii.crc_hqx(body, 0xFFFF) != crc:
+        return None
+    _, _, hz, written, nrec, ntask = HDR.unpack_from(frame, 0)
+    off = HDR.size
+    tasks = {}
+    for _ in range(ntask):
+        num, name = TASK.unpack_from(frame, off)
+        off += TASK.size
+        tasks[num] = name.split(b"\0", 1)[0].decode("ascii", "replace")
+    recs = [REC.unpack_from(frame, off + i * REC.size) for i in range(nrec)]
+    return dict(hz=hz, written=written, tasks=tasks, recs=recs)
+
+
+def frames(buf):
+    """Pull complete frames out of `buf` (bytearray, consumed in place)."""
+    out = []
+    while True:
+        i = buf.find(MAGIC)
+        if i < 0:
+            del buf[:max(0, len(buf) - len(MAGIC) + 1)]
+            return out
+        del buf[:i]
+        if len(buf) < HDR.size:
+            return out
+        length = struct.unpack_from("<I", buf, 4)[0]
+        if length < HDR.size + 2 or length > 1 << 20:
+            del buf[:len(MAGIC)]
+            continue
+        if len(buf) < length:
+            return out
+        tr = parse(bytes(buf[:length]))
+        if tr is None:
+            del buf[:len(MAGIC)]            # not a frame after all / corrupted
+            continue
+        out.append(tr)
+        del buf[:length]
+
+
+def to_chrome(tr):
+    """Decoded frame -> list of Chrome trace events (times in us)."""
+    us = 1e6 / tr["hz"]
+    ev = []
+
+    def meta(tid, name, order):
+        ev.append(dict(ph="M", pid=PID, tid=tid, name="thread_name", args=dict(name=name)))
+        ev.append(dict(ph="M", pid=PID, tid=tid, name="thread_sort_index", args=dict(sort_index=order)))
+
+    def task_name(num):
+        return tr["tasks"].get(num, "task %d" % num)
+
+    def span(tid, name, t0, t1, args=None):
+        ev.append(dict(ph="X", pid=PID, tid=tid, name=name, ts=t0 * us,
+                       dur=max(0, t1 - t0) * us, args=args or {}))
+
+    def instant(tid, name, t, args=None):
+        ev.append(dict(ph="i", s="t", pid=PID, tid=tid, name=name, ts=t * us, args=args or {}))
+
+    ev.append(dict(ph="M", pid=PID, name="process_name", args=dict(name="STM32F407 microwave")))
+    seen_tasks, seen_irqs = set(), set()
+
+    cur = None                  # (task number, switched in at)
+    dma = {TID_LCD: None, TID_UART_TX: None}
+    t = 0
+    last_ts = None
+    for ts, code, a8, a16 in tr["recs"]:
+        if last_ts is not None:
+            d = (ts - last_ts) & 0xFFFFFFFF
+            t += d - (1 << 32) if d & 0x80000000 else d     # slot taken before the stamp
+        last_ts = ts
+
+        if code == EV_TASK_IN:
+            if cur:
+                span(cur[0], task_name(cur[0]), cur[1], t)
+            cur = (a16, t)
+            seen_tasks.add(a16)
+        elif code in (EV_QUEUE_SEND, EV_QUEUE_RECV):
+            addr = 0x20000000 | (a16 << 2)
+            name = ("send" if code == EV_QUEUE_SEND else "recv") + " 0x%08x" % addr
+            tid = TID_ISR if a8 else (cur[0] if cur else TID_ISR)
+            instant(tid, name, t, dict(queue="0x%08x" % addr))
+        elif code == EV_IRQ:
+            name = IRQS[a8] if a8 < len(IRQS) else "IRQ%d" % a8
+            span(TID_IRQ + a8, name, t - a16, t, dict(cycles=a16))
+            seen_irqs.add(a8)
+        elif code in (EV_LCD_DMA, EV_UART_TX):
+            tid = TID_LCD if code == EV_LCD_DMA else TID_UART_TX
+            if dma[tid]:                                  # done event lost
+                span(tid, "DMA %d B" % dma[tid][1], dma[tid][0], t)
+            dma[tid] = (t, a16)
+        elif code in (EV_LCD_DMA_DONE, EV_UART_TX_DONE):
+            tid = TID_LCD if code == EV_LCD_DMA_DONE else TID_UART_TX
+            if dma[tid]:
+                span(tid, "DMA %d B" % dma[tid][1], dma[tid][0], t, dict(bytes=dma[tid][1]))
+                dma[tid] = None
+        elif code == EV_UART_RX:
+            instant(TID_UART_RX, "RX %d B" % a16, t, dict(bytes=a16))
+        elif code == EV_MARK:
+            instant(cur[0] if cur else TID_ISR, "mark %d" % a16, t)
+    if cur:
+        span(cur[0], task_name(cur[0]), cur[1], t)
+
+    for num in sorted(seen_tasks):
+        meta(num, task_name(num), num)
+    meta(TID_ISR, "ISR queue ops", TID_ISR)
+    meta(TID_LCD, "LCD SPI DMA", TID_LCD)
+    meta(TID_UART_TX, "USART2 TX DMA", TID_UART_TX)
+    meta(TID_UART_RX, "USART2 RX", TID_UART_RX)
+    for i in sorted(seen_irqs):
+        meta(TID_IRQ + i, "IRQ " + (IRQS[i] if i < len(IRQS) else str(i)), TID_IRQ + i)
+    return ev
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("port", nargs="?", help="serial port of the console")
+    ap.add_argument("-b", "--baud", type=int, default=115200)
+    ap.add_argument("-o", "--out", default="trace.json", help="JSON file to write")
+    ap.add_argument("--file", help="decode a raw capture instead of dumping")
+    args = ap.parse_args()
+
+    if args.file:
+        with open(args.file, "rb") as f:
+            got = frames(bytearray(f.read()))
+    elif args.port:
+        import serial   # pyserial
+        ser = serial.Serial(args.port, args.baud, timeout=0.1)
+        ser.write(b"TRACE\r\n")
+        buf = bytearray()
+        got = []
+        deadline = time.time() + 5.0
+        while not got and time.time() < deadline:
+            buf += ser.read(4096)
+            got = frames(buf)
+    else:
+        ap.error("a port or --file is needed")
+
+    if not got:
+        sys.exit("no trace frame found")
+    tr = got[-1]
+    with open(args.out, "w") as f:
+        json.dump(dict(traceEvents=to_chrome(tr), displayTimeUnit="ns"), f)
+    lost = max(0, tr["written"] - len(tr["recs"]))
+    print("%d events (%d overwritten), %d tasks, %.0f MHz -> %s"
+          % (len(tr["recs"]), lost, len(tr["tasks"]), tr["hz"] / 1e6, args.out))
+
+
+if __name__ == "__main__":
+    main()